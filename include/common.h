@@ -5,14 +5,13 @@
 #ifndef PROJECT_BASE_COMMON_H
 #define PROJECT_BASE_COMMON_H
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <rg/FileView.h>
 
-std::string readFileContents(std::string path) {
-    std::ifstream in(path);
-    std::stringstream buffer;
-    buffer << in.rdbuf();
-    return buffer.str();
+// Prefer reading through rg::FileView (or rg::Vfs) directly where the caller can work with a
+// pointer and a length, this copies the contents once into the returned string.
+inline std::string readFileContents(const std::string& path) {
+    rg::FileView file(path);
+    return std::string(file.begin(), file.end());
 }
 
 
@@ -9,6 +9,7 @@
 #include <learnopengl/shader.h>
 
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -42,18 +43,31 @@ public:
 
     unsigned int VAO;
     std::string glslIdentifierPrefix;
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor. vertex array objects are not shared between GL contexts, so a mesh built on a loader
+    // context passes createVertexArray = false and gets SetupVertexArray() called on the render context.
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool createVertexArray = true)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupBuffers();
+        if (createVertexArray)
+            SetupVertexArray();
     }
     // render the mesh
     void Draw(Shader &shader)
+    {
+        BindTextures(shader);
+        DrawGeometry();
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // binds the mesh textures to consecutive texture units and points the shader samplers at them
+    void BindTextures(Shader &shader) const
     {
         // bind appropriate textures
         unsigned int diffuseNr  = 1;
@@ -80,38 +94,31 @@ public:
             // and finally bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
+    }
 
-        // draw mesh
+    // issues the draw call, assumes the textures are already bound
+    void DrawGeometry() const
+    {
         glBindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    // render data
-    unsigned int VBO, EBO;
+    // re-uploads the vertex data after it was modified on the CPU side (e.g. rewritten texture coordinates)
+    void UpdateVertices()
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), &vertices[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 
-    // initializes all the buffer objects/arrays
-    void setupMesh()
+    // creates the vertex array object on the current context and sets the vertex attribute pointers
+    void SetupVertexArray()
     {
-        // create buffers/arrays
         glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
         glBindVertexArray(VAO);
-        // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
         // vertex Positions
@@ -131,6 +138,31 @@ private:
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
 
         glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+private:
+    // render data
+    unsigned int VBO, EBO;
+
+    // creates the vertex and index buffers, these are shared with every context of the share group
+    void setupBuffers()
+    {
+        VAO = 0;
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        // load data into vertex buffers
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        // A great thing about structs is that their memory layout is sequential for all its items.
+        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+        // again translates to 3/2 floats which translates to a byte array.
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+
+        // the element array binding belongs to a vertex array object, so the index data goes up through GL_ARRAY_BUFFER
+        glBindBuffer(GL_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 };
 #endif
\ No newline at end of file
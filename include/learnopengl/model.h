@@ -12,13 +12,23 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <rg/AssimpVfs.h>
+#include <rg/MipChain.h>
+#include <rg/ObjLoader.h>
+#include <rg/Parallel.h>
+#include <rg/TextureCache.h>
+#include <rg/TextureRegistry.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_set>
 #include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
@@ -29,17 +39,29 @@ class Model
 {
 public:
     // model data
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<Texture> textures_loaded;	// stores all the textures this model uses, each one once. Loading is deduplicated by rg::TextureRegistry.
+    std::unordered_set<unsigned int> loaded_ids; // ids in textures_loaded
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // set when the model is loaded on a context other than the one drawing it, see SetupVertexArrays
+    bool deferVertexArrays;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, bool deferVertexArrays = false) : gammaCorrection(gamma), deferVertexArrays(deferVertexArrays)
     {
         loadModel(path);
     }
 
+    // creates the vertex array objects of a model constructed with deferVertexArrays, on the context that draws it
+    void SetupVertexArrays()
+    {
+        for (Mesh& mesh : meshes)
+            if (mesh.VAO == 0)
+                mesh.SetupVertexArray();
+        deferVertexArrays = false;
+    }
+
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
@@ -47,6 +69,20 @@ public:
             meshes[i].Draw(shader);
     }
 
+    // gives back the rg::TextureRegistry reference every mesh texture holds, which deletes the textures no other
+    // model uses. has to run on the render thread while the context still exists
+    void Release()
+    {
+        for (Mesh& mesh : meshes)
+        {
+            for (Texture& texture : mesh.textures)
+                rg::TextureRegistry::instance().release(texture.id);
+            mesh.textures.clear();
+        }
+        textures_loaded.clear();
+        loaded_ids.clear();
+    }
+
     void SetShaderTextureNamePrefix(std::string prefix) {
         for (Mesh& mesh: meshes) {
             mesh.glslIdentifierPrefix = prefix;
@@ -56,8 +92,23 @@ private:
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
-        // read file via ASSIMP
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // Wavefront OBJ goes through the dedicated parser, other formats (and OBJ files it fails on) through ASSIMP
+        if (rg::ObjLoader::handles(path))
+        {
+            rg::ObjScene scene;
+            if (rg::ObjLoader::load(path, scene))
+            {
+                processObjScene(scene);
+                return;
+            }
+        }
+
+        // read file via ASSIMP, through the pack files when mounted
         Assimp::Importer importer;
+        importer.SetIOHandler(new rg::VfsIOSystem()); // the importer takes ownership
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
@@ -65,92 +116,113 @@ private:
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        vector<aiMesh*> sceneMeshes;
+        processNode(scene->mRootNode, scene, sceneMeshes);
+
+        // converting the vertex data needs no GL context, so every mesh gets its own task
+        vector<MeshData> data(sceneMeshes.size());
+        rg::parallelFor(sceneMeshes.size(), [&](size_t i)
+        {
+            convertMesh(sceneMeshes[i], data[i]);
+        });
+
+        // textures and buffers are created on this (the context) thread, in node order
+        meshes.reserve(meshes.size() + sceneMeshes.size());
+        for(unsigned int i = 0; i < sceneMeshes.size(); i++)
+            meshes.push_back(processMesh(sceneMeshes[i], scene, data[i]));
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    // vertex and index data of one aiMesh, filled on a worker thread
+    struct MeshData
+    {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+    };
+
+    // processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on its children nodes (if any).
+    void processNode(aiNode *node, const aiScene *scene, vector<aiMesh*> &sceneMeshes)
     {
-        // process each mesh located at the current node
+        // collect each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             // the node object only contains indices to index the actual objects in the scene.
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
         }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+        // after we've collected all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, sceneMeshes);
         }
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // copies the vertices and indices of an aiMesh into the Vertex layout. Makes no GL calls, so it is safe on any thread.
+    static void convertMesh(const aiMesh *mesh, MeshData &data)
     {
-        // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
-
-        // walk through each of the mesh's vertices
-        for(unsigned int i = 0; i < mesh->mNumVertices; i++)
+        static_assert(sizeof(Vertex) == 14 * sizeof(float), "Vertex is expected to be tightly packed floats");
+        unsigned int count = mesh->mNumVertices;
+        data.vertices.resize(count);
+
+        const aiVector3D *normals = mesh->HasNormals() ? mesh->mNormals : nullptr;
+        // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
+        // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
+        const aiVector3D *texCoords = mesh->mTextureCoords[0];
+        const aiVector3D *tangents = texCoords ? mesh->mTangents : nullptr;
+        const aiVector3D *bitangents = texCoords ? mesh->mBitangents : nullptr;
+
+        unsigned int i = 0;
+#ifdef __SSE2__
+        // the common case (everything present) moves each attribute with one 16 byte load. A load reads the first float
+        // of the next aiVector3D, so the last vertex is left to the scalar loop; stores go in field order, each one
+        // spilling into a field that the following store overwrites.
+        if (normals && texCoords && tangents && bitangents)
         {
-            Vertex vertex;
-            glm::vec3 vector; // we declare a placeholder vector since assimp_ uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
-            // positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
-            // normals
-            if (mesh->HasNormals())
-            {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.Normal = vector;
-            }
-            // texture coordinates
-            if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+            for(; i + 1 < count; i++)
             {
-                glm::vec2 vec;
-                // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
-                // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
-                // tangent
-                vector.x = mesh->mTangents[i].x;
-                vector.y = mesh->mTangents[i].y;
-                vector.z = mesh->mTangents[i].z;
-                vertex.Tangent = vector;
-                // bitangent
-                vector.x = mesh->mBitangents[i].x;
-                vector.y = mesh->mBitangents[i].y;
-                vector.z = mesh->mBitangents[i].z;
-                vertex.Bitangent = vector;
+                float *out = &data.vertices[i].Position.x;
+                _mm_storeu_ps(out, _mm_loadu_ps(&mesh->mVertices[i].x));
+                _mm_storeu_ps(out + 3, _mm_loadu_ps(&normals[i].x));
+                _mm_storeu_ps(out + 6, _mm_loadu_ps(&texCoords[i].x));
+                _mm_storeu_ps(out + 8, _mm_loadu_ps(&tangents[i].x));
+                __m128 bitangent = _mm_loadu_ps(&bitangents[i].x);
+                _mm_storel_pi((__m64*)(out + 11), bitangent);
+                _mm_store_ss(out + 13, _mm_movehl_ps(bitangent, bitangent));
             }
-            else
-                vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-            vertices.push_back(vertex);
-
-
         }
-        // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
-        for(unsigned int i = 0; i < mesh->mNumFaces; i++)
+#endif
+        // walk through the remaining vertices
+        for(; i < count; i++)
         {
-            aiFace face = mesh->mFaces[i];
-            // retrieve all indices of the face and store them in the indices vector
-            for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+            Vertex &vertex = data.vertices[i];
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            vertex.Normal = normals ? glm::vec3(normals[i].x, normals[i].y, normals[i].z) : glm::vec3(0.0f);
+            vertex.TexCoords = texCoords ? glm::vec2(texCoords[i].x, texCoords[i].y) : glm::vec2(0.0f, 0.0f);
+            vertex.Tangent = tangents ? glm::vec3(tangents[i].x, tangents[i].y, tangents[i].z) : glm::vec3(0.0f);
+            vertex.Bitangent = bitangents ? glm::vec3(bitangents[i].x, bitangents[i].y, bitangents[i].z) : glm::vec3(0.0f);
         }
+
+        // now walk through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+        size_t indexCount = 0;
+        for(unsigned int f = 0; f < mesh->mNumFaces; f++)
+            indexCount += mesh->mFaces[f].mNumIndices;
+        data.indices.resize(indexCount);
+        unsigned int *out = data.indices.data();
+        for(unsigned int f = 0; f < mesh->mNumFaces; f++)
+        {
+            const aiFace &face = mesh->mFaces[f];
+            std::copy(face.mIndices, face.mIndices + face.mNumIndices, out);
+            out += face.mNumIndices;
+        }
+    }
+
+    Mesh processMesh(aiMesh *mesh, const aiScene *scene, MeshData &data)
+    {
+        // data to fill
+        vector<Texture> textures;
+
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -179,11 +251,34 @@ private:
 
 
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return Mesh(std::move(data.vertices), std::move(data.indices), textures, !deferVertexArrays);
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
+    // turns the meshes of the OBJ fast path into Mesh objects, textures in the same order processMesh uses
+    void processObjScene(rg::ObjScene &scene)
+    {
+        for(rg::ObjMesh &objMesh : scene.meshes)
+        {
+            vector<Texture> textures;
+            auto material = scene.materials.find(objMesh.material);
+            if (material != scene.materials.end())
+            {
+                const rg::ObjMaterial &maps = material->second;
+                if (!maps.diffuse.empty())
+                    textures.push_back(loadTexture(maps.diffuse, "texture_diffuse"));
+                if (!maps.specular.empty())
+                    textures.push_back(loadTexture(maps.specular, "texture_specular"));
+                if (!maps.normal.empty())
+                    textures.push_back(loadTexture(maps.normal, "texture_normal"));
+                if (!maps.height.empty())
+                    textures.push_back(loadTexture(maps.height, "texture_height"));
+            }
+            meshes.push_back(Mesh(std::move(objMesh.vertices), std::move(objMesh.indices), textures, !deferVertexArrays));
+        }
+    }
+
+    // gets all material textures of a given type from the shared texture registry, which loads them only once per process.
+    // every returned texture holds a registry reference. the required info is returned as a Texture struct.
     vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
     {
         vector<Texture> textures;
@@ -191,29 +286,22 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    Texture loadTexture(const string &file, const string &typeName)
+    {
+        Texture texture;
+        // diffuse maps hold sRGB colors and get gamma correct mip levels
+        texture.id = rg::TextureRegistry::instance().acquire(this->directory + '/' + file, typeName == "texture_diffuse");
+        texture.type = typeName;
+        texture.path = file;
+        if (loaded_ids.insert(texture.id).second)
+            textures_loaded.push_back(texture);
+        return texture;
+    }
 };
 
 
@@ -225,21 +313,24 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
+    // precomputed (and usually block compressed) mip chain from the on-disk cache, built on the first load
+    if (rg::TextureCache::load(filename, textureID, gamma))
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return textureID;
+    }
+
     int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+    rg::VfsFile file = rg::Vfs::instance().open(filename);
+    unsigned char *data = file.isOpen() ? stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &nrComponents, 0) : nullptr;
     if (data)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
         glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // mip levels are built on the CPU, see rg::MipChain
+        rg::MipChain::upload(rg::MipChain::generate(data, width, height, nrComponents, gamma), nrComponents);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <iostream>
 #include <common.h>
+#include <rg/Vfs.h>
 class Shader
 {
 public:
@@ -22,69 +23,42 @@ public:
 
         vertexPath = vertexPathString.c_str();
         fragmentPath= fragmentPathString.c_str();
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
-            {
-                std::string geometryPathString(geometryPath);
-                geometryPath = geometryPathString.c_str();
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch (std::ifstream::failure& e)
+        // 1. retrieve the vertex/fragment source code from filePath, through the pack files when mounted (see rg::Vfs)
+        rg::VfsFile vShaderFile = rg::Vfs::instance().open(vertexPath);
+        rg::VfsFile fShaderFile = rg::Vfs::instance().open(fragmentPath);
+        rg::VfsFile gShaderFile;
+        // if geometry shader path is present, also load a geometry shader
+        if(geometryPath != nullptr)
+            gShaderFile = rg::Vfs::instance().open(geometryPath);
+        if (!vShaderFile.isOpen() || !fShaderFile.isOpen() || (geometryPath != nullptr && !gShaderFile.isOpen()))
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
+        // the sources are passed with their lengths, straight from the file views
+        const char* vShaderCode = vShaderFile.begin();
+        const char * fShaderCode = fShaderFile.begin();
+        GLint vShaderLength = (GLint)vShaderFile.size();
+        GLint fShaderLength = (GLint)fShaderFile.size();
         // 2. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glShaderSource(vertex, 1, &vShaderCode, &vShaderLength);
         glCompileShader(vertex);
         checkCompileErrors(vertex, "VERTEX");
         // fragment Shader
         fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glShaderSource(fragment, 1, &fShaderCode, &fShaderLength);
         glCompileShader(fragment);
         checkCompileErrors(fragment, "FRAGMENT");
         // if geometry shader is given, compile geometry shader
         unsigned int geometry;
         if(geometryPath != nullptr)
         {
-            const char * gShaderCode = geometryCode.c_str();
+            const char * gShaderCode = gShaderFile.begin();
+            GLint gShaderLength = (GLint)gShaderFile.size();
             geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
+            glShaderSource(geometry, 1, &gShaderCode, &gShaderLength);
             glCompileShader(geometry);
             checkCompileErrors(geometry, "GEOMETRY");
         }
@@ -4,146 +4,271 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <common.h>
+#include <rg/ProgramCache.h>
+#include <rg/ShaderPreprocessor.h>
+#include <rg/Vfs.h>
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly. defines ("#define NAME value" lines, see
+    // rg::ShaderDefines) are inserted into both stages right after their #version line.
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = "")
     {
         std::string vertexPathString(vertexPath);
         std::string fragmentPathString(fragmentPath);
         vertexPath = vertexPathString.c_str();
         fragmentPath= fragmentPathString.c_str();
 
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-        }
-        catch (std::ifstream::failure& e)
+        m_VertexPath = vertexPathString;
+        m_FragmentPath = fragmentPathString;
+        m_Defines = defines;
+        auto start = std::chrono::steady_clock::now();
+        // 1. retrieve the vertex/fragment source code from filePath with its #includes resolved,
+        // through the pack files when mounted (see rg::ShaderPreprocessor and rg::Vfs)
+        rg::ShaderSource vSource, fSource;
+        rg::ShaderPreprocessor::process(vertexPath, vSource);
+        rg::ShaderPreprocessor::process(fragmentPath, fSource);
+        m_VertexFiles = vSource.files;
+        m_FragmentFiles = fSource.files;
+        // 2. a program linked from the same sources on this driver before is loaded as a binary
+        rg::ProgramCache& cache = rg::ProgramCache::instance();
+        std::string key = cache.key({vSource.text, fSource.text}, defines);
+        ID = glCreateProgram();
+        if (cache.load(key, ID))
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+            cache.recordHit(rg::ProgramCache::millisecondsSince(start));
+            return;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
+        // a rejected binary may leave the program in an unusable state, so start over
+        glDeleteProgram(ID);
+        ID = glCreateProgram();
+        rg::parallelShaderCompile();
+        // 3. submit compiling and linking, the driver may do both in the background. Nothing here
+        // asks for a status, which would wait for it, that happens in resolve() on first use.
         // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
+        m_Vertex = glCreateShader(GL_VERTEX_SHADER);
+        shaderSource(m_Vertex, vSource.text, defines);
+        glCompileShader(m_Vertex);
         // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+        m_Fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        shaderSource(m_Fragment, fSource.text, defines);
+        glCompileShader(m_Fragment);
         // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
+        glAttachShader(ID, m_Vertex);
+        glAttachShader(ID, m_Fragment);
+        cache.prepare(ID);
         glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
+        m_Key = key;
+        m_Pending = true;
+        m_SubmitMilliseconds = rg::ProgramCache::millisecondsSince(start);
+    }
+    // true if use() won't wait for the driver to finish compiling. Without
+    // KHR_parallel_shader_compile the driver can't be asked without waiting,
+    // so this reports true and the first use() may block.
+    // ------------------------------------------------------------------------
+    bool ready() const
+    {
+        if (!m_Pending || !rg::parallelShaderCompile())
+            return true;
+        GLint complete = GL_FALSE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &complete);
+        return complete == GL_TRUE;
+    }
+    // the linked program, waits for the compile submitted by the constructor the first time
+    // ------------------------------------------------------------------------
+    unsigned int program() const
+    {
+        if (m_Pending)
+            resolve();
+        return ID;
+    }
+    // Recompiles from the files on disk, ignoring mounted packs, so edits show up. If everything
+    // compiles and links the new program replaces the old one, otherwise the errors are printed
+    // and the old program stays in use.
+    // ------------------------------------------------------------------------
+    bool reload()
+    {
+        program();
+        rg::ShaderSource vSource, fSource;
+        if (!rg::ShaderPreprocessor::process(m_VertexPath, vSource, true) ||
+            !rg::ShaderPreprocessor::process(m_FragmentPath, fSource, true))
+            return false;
+        // the includes may have changed with the edit, even if it doesn't compile
+        m_VertexFiles = vSource.files;
+        m_FragmentFiles = fSource.files;
+        unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
+        shaderSource(vertex, vSource.text, m_Defines);
+        glCompileShader(vertex);
+        unsigned int fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        shaderSource(fragment, fSource.text, m_Defines);
+        glCompileShader(fragment);
+        unsigned int reloaded = glCreateProgram();
+        glAttachShader(reloaded, vertex);
+        glAttachShader(reloaded, fragment);
+        rg::ProgramCache& cache = rg::ProgramCache::instance();
+        cache.prepare(reloaded);
+        glLinkProgram(reloaded);
+        // not short-circuited, every stage reports its errors
+        bool linked = checkCompileErrors(vertex, "VERTEX", m_VertexFiles) &
+                      checkCompileErrors(fragment, "FRAGMENT", m_FragmentFiles) &
+                      checkCompileErrors(reloaded, "PROGRAM");
         glDeleteShader(vertex);
         glDeleteShader(fragment);
-
+        if (!linked)
+        {
+            glDeleteProgram(reloaded);
+            std::cout << "Keeping the previous program of " << m_FragmentPath << std::endl;
+            return false;
+        }
+        cache.store(cache.key({vSource.text, fSource.text}, m_Defines), reloaded);
+        glDeleteProgram(ID);
+        ID = reloaded;
+        return true;
+    }
+    // true if the program is built from the file at path, directly or through an #include
+    // ------------------------------------------------------------------------
+    bool dependsOn(const std::string& path) const
+    {
+        std::string name = rg::Vfs::entryName(path);
+        auto matches = [&name](const std::string& file) { return rg::Vfs::entryName(file) == name; };
+        return matches(m_VertexPath) || matches(m_FragmentPath) ||
+               std::any_of(m_VertexFiles.begin(), m_VertexFiles.end(), matches) ||
+               std::any_of(m_FragmentFiles.begin(), m_FragmentFiles.end(), matches);
     }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() const
     { 
-        glUseProgram(ID); 
+        glUseProgram(program()); 
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(glGetUniformLocation(program(), name.c_str()), (int)value); 
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(glGetUniformLocation(program(), name.c_str()), value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(glGetUniformLocation(program(), name.c_str()), value); 
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform2fv(glGetUniformLocation(program(), name.c_str()), 1, &value[0]); 
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(glGetUniformLocation(program(), name.c_str()), x, y); 
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(glGetUniformLocation(program(), name.c_str()), 1, &value[0]); 
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(glGetUniformLocation(program(), name.c_str()), x, y, z); 
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(glGetUniformLocation(program(), name.c_str()), 1, &value[0]); 
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) const
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(glGetUniformLocation(program(), name.c_str()), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(glGetUniformLocation(program(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(glGetUniformLocation(program(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(glGetUniformLocation(program(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
-    // utility function for checking shader compilation/linking errors.
+    // what the program is built from, for reload()
+    std::string m_VertexPath;
+    std::string m_FragmentPath;
+    std::string m_Defines;
+    // the files each stage was built from, includes too
+    std::vector<std::string> m_VertexFiles;
+    std::vector<std::string> m_FragmentFiles;
+    // compile state between the constructor and the first use
+    mutable bool m_Pending = false;
+    mutable unsigned int m_Vertex = 0;
+    mutable unsigned int m_Fragment = 0;
+    std::string m_Key;
+    double m_SubmitMilliseconds = 0.0;
+
+    void resolve() const
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_Pending = false;
+        checkCompileErrors(m_Vertex, "VERTEX", m_VertexFiles);
+        checkCompileErrors(m_Fragment, "FRAGMENT", m_FragmentFiles);
+        rg::ProgramCache& cache = rg::ProgramCache::instance();
+        if (checkCompileErrors(ID, "PROGRAM"))
+            cache.store(m_Key, ID);
+        // delete the shaders as they're linked into our program now and no longer necessery
+        glDeleteShader(m_Vertex);
+        glDeleteShader(m_Fragment);
+        m_Vertex = 0;
+        m_Fragment = 0;
+        // only the time this thread spent, compiling in the background is free
+        cache.recordMiss(m_SubmitMilliseconds + rg::ProgramCache::millisecondsSince(start));
+    }
+    // Sets the source of shader to source with defines after the #version line, which has to
+    // come first. The parts are passed as separate strings with their lengths, source isn't
+    // copied; a #line directive keeps the line numbers in compile errors right.
+    static void shaderSource(GLuint shader, const std::string& source, const std::string& defines)
+    {
+        const char* begin = source.data();
+        const char* end = source.data() + source.size();
+        const char* split = begin;
+        if (!defines.empty())
+        {
+            const char* version = std::search(begin, end, "#version", "#version" + 8);
+            split = version == end ? begin : std::find(version, end, '\n');
+            if (split != end)
+                ++split;
+        }
+        std::string inserted = defines;
+        if (!inserted.empty())
+            inserted += "#line " + std::to_string(std::count(begin, split, '\n') + 1) + "\n";
+        const char* strings[] = {begin, inserted.c_str(), split};
+        GLint lengths[] = {(GLint)(split - begin), (GLint)inserted.size(), (GLint)(end - split)};
+        glShaderSource(shader, 3, strings, lengths);
+    }
+    // utility function for checking shader compilation/linking errors, returns true on success.
+    // files names the source string numbers in the messages, see rg::ShaderSource.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    static bool checkCompileErrors(GLuint shader, std::string type,
+                                   const std::vector<std::string>& files = std::vector<std::string>())
     {
         GLint success;
         GLchar infoLog[1024];
@@ -153,7 +278,10 @@ private:
             if (!success)
             {
                 glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog;
+                for (size_t i = 0; i < files.size(); i++)
+                    std::cout << "source " << i << ": " << files[i] << "\n";
+                std::cout << " -- --------------------------------------------------- -- " << std::endl;
             }
         }
         else
@@ -165,6 +293,7 @@ private:
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success;
     }
 };
 #endif
@@ -0,0 +1,276 @@
+#ifndef PROJECT_BASE_ASSETSTREAMER_H
+#define PROJECT_BASE_ASSETSTREAMER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <learnopengl/model.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <rg/Error.h>
+#include <rg/GLDebug.h>
+#include <rg/TextureRegistry.h>
+
+namespace rg {
+
+class AssetStreamer;
+
+// Model that is being loaded by an AssetStreamer. Only usable on the render thread.
+class ModelHandle {
+public:
+    bool ready() const {
+        return m_State && m_State->ready;
+    }
+
+    Model& get() const {
+        ASSERT(ready(), "Using a model before it finished loading");
+        return *m_State->model;
+    }
+
+private:
+    friend class AssetStreamer;
+
+    struct State {
+        std::unique_ptr<Model> model;
+        bool ready = false;
+    };
+    std::shared_ptr<State> m_State;
+};
+
+// Texture that is being loaded by an AssetStreamer, id() is a placeholder until it is ready.
+class TextureHandle {
+public:
+    bool ready() const {
+        return m_State && m_State->ready;
+    }
+
+    unsigned int id() const {
+        return ready() ? m_State->texture : m_State->placeholder;
+    }
+
+private:
+    friend class AssetStreamer;
+
+    struct State {
+        unsigned int texture = 0;
+        unsigned int placeholder = 0;
+        bool ready = false;
+    };
+    std::shared_ptr<State> m_State;
+};
+
+// Loads models and textures on a background thread, so the first frame doesn't wait for them.
+//
+// The loader thread owns a hidden window whose context shares objects with the render context.
+// It creates buffers and textures there, then puts a fence behind its commands and hands the
+// result over; update() on the render thread finishes a load once its fence has signaled, which
+// guarantees the render context sees the complete objects. Vertex array objects are not shared
+// between contexts, so those are created at that point. Until then handles report not ready and
+// textures resolve to a 1x1 placeholder.
+//
+// Without a second context (window creation failed) loads run synchronously.
+class AssetStreamer {
+public:
+    // Has to be created on the main thread with the render context current.
+    explicit AssetStreamer(GLFWwindow* renderWindow) {
+        unsigned char grey[] = {128, 128, 128, 255};
+        glGenTextures(1, &m_Placeholder);
+        glBindTexture(GL_TEXTURE_2D, m_Placeholder);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // same context hints as the render window, which are still set
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        m_LoaderWindow = glfwCreateWindow(1, 1, "loader", nullptr, renderWindow);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (!m_LoaderWindow) {
+            std::cout << "AssetStreamer: could not create a shared context, loading synchronously" << std::endl;
+            return;
+        }
+        m_Thread = std::thread(&AssetStreamer::run, this);
+    }
+
+    ~AssetStreamer() {
+        shutdown();
+    }
+
+    AssetStreamer(const AssetStreamer&) = delete;
+    AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+    // Stops the loader thread, dropping loads that haven't started. Loads that did are finished,
+    // so their handles are ready and whatever they hold can be released. Has to run on the render
+    // thread before glfwTerminate.
+    void shutdown() {
+        if (m_Thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Stop = true;
+                m_Jobs.clear();
+            }
+            m_Wake.notify_one();
+            m_Thread.join();
+        }
+        for (Completion& completion : m_Completed) {
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            while (true) {
+                GLenum status = glClientWaitSync(completion.fence, flags, 1000000000);
+                if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED) {
+                    break;
+                }
+                flags = 0;
+            }
+            glDeleteSync(completion.fence);
+            completion.finish();
+            --m_Outstanding;
+        }
+        m_Completed.clear();
+        if (m_LoaderWindow) {
+            glfwDestroyWindow(m_LoaderWindow);
+            m_LoaderWindow = nullptr;
+        }
+        if (m_Placeholder) {
+            glDeleteTextures(1, &m_Placeholder);
+            m_Placeholder = 0;
+        }
+    }
+
+    // prepare runs on the loader thread after the model loaded, for import steps that touch GL
+    // (e.g. building a texture atlas) and shouldn't stall the render thread either.
+    ModelHandle loadModel(const std::string& path, bool gamma = false,
+                          std::function<void(Model&)> prepare = std::function<void(Model&)>()) {
+        ModelHandle handle;
+        handle.m_State = std::make_shared<ModelHandle::State>();
+        std::shared_ptr<ModelHandle::State> state = handle.m_State;
+        bool deferVertexArrays = m_LoaderWindow != nullptr;
+        submit([state, path, gamma, prepare, deferVertexArrays]() -> std::function<void()> {
+            state->model.reset(new Model(path, gamma, deferVertexArrays));
+            if (prepare) {
+                prepare(*state->model);
+            }
+            return [state] {
+                state->model->SetupVertexArrays();
+                state->ready = true;
+            };
+        });
+        return handle;
+    }
+
+    TextureHandle loadTexture(const std::string& path, bool srgb) {
+        TextureHandle handle;
+        handle.m_State = std::make_shared<TextureHandle::State>();
+        handle.m_State->placeholder = m_Placeholder;
+        std::shared_ptr<TextureHandle::State> state = handle.m_State;
+        submit([state, path, srgb]() -> std::function<void()> {
+            unsigned int texture = TextureRegistry::instance().acquire(path, srgb);
+            return [state, texture] {
+                state->texture = texture;
+                state->ready = true;
+            };
+        });
+        return handle;
+    }
+
+    // Finishes the loads whose GL work completed. Call once per frame on the render thread.
+    void update() {
+        std::deque<Completion> finished;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            while (!m_Completed.empty()) {
+                GLenum status = glClientWaitSync(m_Completed.front().fence, 0, 0);
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+                    break;
+                }
+                finished.push_back(std::move(m_Completed.front()));
+                m_Completed.pop_front();
+            }
+        }
+        for (Completion& completion : finished) {
+            glDeleteSync(completion.fence);
+            completion.finish();
+            --m_Outstanding;
+        }
+    }
+
+    // true once every requested load finished
+    bool idle() const {
+        return m_Outstanding == 0;
+    }
+
+    unsigned int outstanding() const {
+        return m_Outstanding;
+    }
+
+    unsigned int placeholderTexture() const {
+        return m_Placeholder;
+    }
+
+private:
+    // runs on the loader thread and returns the part that has to run on the render thread
+    typedef std::function<std::function<void()>()> Job;
+
+    struct Completion {
+        GLsync fence;
+        std::function<void()> finish;
+    };
+
+    GLFWwindow* m_LoaderWindow = nullptr;
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::deque<Job> m_Jobs;
+    std::deque<Completion> m_Completed;
+    bool m_Stop = false;
+    // touched by the render thread only
+    unsigned int m_Outstanding = 0;
+    unsigned int m_Placeholder = 0;
+
+    void submit(Job job) {
+        ++m_Outstanding;
+        if (!m_LoaderWindow) {
+            job()();
+            --m_Outstanding;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Jobs.push_back(std::move(job));
+        }
+        m_Wake.notify_one();
+    }
+
+    void run() {
+        glfwMakeContextCurrent(m_LoaderWindow);
+        GLDebug::instance().install();
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Wake.wait(lock, [this] { return m_Stop || !m_Jobs.empty(); });
+                if (m_Stop) {
+                    break;
+                }
+                job = std::move(m_Jobs.front());
+                m_Jobs.pop_front();
+            }
+            std::function<void()> finish = job();
+            // the render thread may only use the results once the GPU has executed everything above
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Completed.push_back(Completion{fence, std::move(finish)});
+        }
+        glfwMakeContextCurrent(nullptr);
+    }
+};
+
+};
+#endif //PROJECT_BASE_ASSETSTREAMER_H
@@ -0,0 +1,83 @@
+#ifndef PROJECT_BASE_ASSIMPVFS_H
+#define PROJECT_BASE_ASSIMPVFS_H
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <rg/Vfs.h>
+
+namespace rg {
+
+// Read-only Assimp stream over a file opened through the Vfs.
+class VfsIOStream : public Assimp::IOStream {
+public:
+    explicit VfsIOStream(VfsFile file) : m_File(std::move(file)) {
+    }
+
+    size_t Read(void* buffer, size_t size, size_t count) override {
+        if (size == 0) {
+            return 0;
+        }
+        size_t items = std::min(count, (m_File.size() - m_Position) / size);
+        std::memcpy(buffer, m_File.data() + m_Position, items * size);
+        m_Position += items * size;
+        return items;
+    }
+
+    size_t Write(const void* buffer, size_t size, size_t count) override {
+        return 0;
+    }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override {
+        size_t base = origin == aiOrigin_SET ? 0 : (origin == aiOrigin_CUR ? m_Position : m_File.size());
+        if (base + offset > m_File.size()) {
+            return aiReturn_FAILURE;
+        }
+        m_Position = base + offset;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override {
+        return m_Position;
+    }
+
+    size_t FileSize() const override {
+        return m_File.size();
+    }
+
+    void Flush() override {
+    }
+
+private:
+    VfsFile m_File;
+    size_t m_Position = 0;
+};
+
+// Lets Assimp (and the material libraries or textures it follows) read through the Vfs.
+class VfsIOSystem : public Assimp::IOSystem {
+public:
+    bool Exists(const char* path) const override {
+        return Vfs::instance().exists(path);
+    }
+
+    char getOsSeparator() const override {
+        return '/';
+    }
+
+    Assimp::IOStream* Open(const char* path, const char* mode = "rb") override {
+        if (std::strchr(mode, 'w') || std::strchr(mode, 'a')) {
+            return nullptr;
+        }
+        VfsFile file = Vfs::instance().open(path);
+        return file.isOpen() ? new VfsIOStream(std::move(file)) : nullptr;
+    }
+
+    void Close(Assimp::IOStream* stream) override {
+        delete stream;
+    }
+};
+
+};
+#endif //PROJECT_BASE_ASSIMPVFS_H
@@ -0,0 +1,222 @@
+#ifndef PROJECT_BASE_BLOCKCOMPRESSION_H
+#define PROJECT_BASE_BLOCKCOMPRESSION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// CPU encoders for the BCn block formats. Every 4x4 pixel block becomes 8 (BC1, BC4) or
+// 16 (BC3, BC5) bytes. Quality is that of a fast single-pass encoder: BC1 endpoints come
+// from the principal axis of the block colors, BC4 endpoints from the channel range.
+namespace rg {
+namespace bc {
+
+enum class Format {
+    BC1, // RGB
+    BC3, // RGBA, BC1 color + BC4 alpha
+    BC4, // single channel
+    BC5  // two channels, two BC4 blocks
+};
+
+inline size_t blockSize(Format format) {
+    return format == Format::BC1 || format == Format::BC4 ? 8 : 16;
+}
+
+inline size_t compressedSize(Format format, int width, int height) {
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize(format);
+}
+
+inline uint16_t packRgb565(const float* rgb) {
+    int r = (int)(rgb[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(rgb[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(rgb[2] * 31.0f / 255.0f + 0.5f);
+    r = std::min(std::max(r, 0), 31);
+    g = std::min(std::max(g, 0), 63);
+    b = std::min(std::max(b, 0), 31);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRgb565(uint16_t color, int* rgb) {
+    rgb[0] = ((color >> 11) & 31) * 255 / 31;
+    rgb[1] = ((color >> 5) & 63) * 255 / 63;
+    rgb[2] = (color & 31) * 255 / 31;
+}
+
+// block is 16 RGBA pixels, row by row
+inline void encodeColorBlock(const unsigned char* block, unsigned char* out) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            mean[c] += block[i * 4 + c];
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[6] = {0.0f}; // rr rg rb gg gb bb
+    for (int i = 0; i < 16; ++i) {
+        float r = block[i * 4 + 0] - mean[0];
+        float g = block[i * 4 + 1] - mean[1];
+        float b = block[i * 4 + 2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // a few power iterations are enough to find the principal axis
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 4; ++iteration) {
+        float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+        float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+        if (length < 1e-6f) {
+            break;
+        }
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    float minProjection = 1e30f;
+    float maxProjection = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float projection = (block[i * 4 + 0] - mean[0]) * axis[0] +
+                           (block[i * 4 + 1] - mean[1]) * axis[1] +
+                           (block[i * 4 + 2] - mean[2]) * axis[2];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+    float axisLength = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float maxColor[3];
+    float minColor[3];
+    for (int c = 0; c < 3; ++c) {
+        float scale = axisLength > 0.0f ? axis[c] / axisLength : 0.0f;
+        maxColor[c] = mean[c] + maxProjection * scale;
+        minColor[c] = mean[c] + minProjection * scale;
+    }
+
+    uint16_t color0 = packRgb565(maxColor);
+    uint16_t color1 = packRgb565(minColor);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    // color0 > color1 selects the four color mode; equal endpoints mean a flat block
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            int bestDistance = 1 << 30;
+            for (int p = 0; p < 4; ++p) {
+                int dr = block[i * 4 + 0] - palette[p][0];
+                int dg = block[i * 4 + 1] - palette[p][1];
+                int db = block[i * 4 + 2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (i * 2);
+        }
+    }
+
+    out[0] = color0 & 0xff;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xff;
+    out[3] = color1 >> 8;
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = (indices >> (i * 8)) & 0xff;
+    }
+}
+
+// block is 16 values with the given stride between them
+inline void encodeChannelBlock(const unsigned char* block, int stride, unsigned char* out) {
+    int minValue = 255;
+    int maxValue = 0;
+    for (int i = 0; i < 16; ++i) {
+        minValue = std::min(minValue, (int)block[i * stride]);
+        maxValue = std::max(maxValue, (int)block[i * stride]);
+    }
+
+    // value0 > value1 selects the eight value mode: index 0 is value0, 1 is value1 and
+    // 2..7 step from value0 towards value1
+    uint64_t indices = 0;
+    if (maxValue != minValue) {
+        int range = maxValue - minValue;
+        for (int i = 0; i < 16; ++i) {
+            int step = ((maxValue - block[i * stride]) * 7 + range / 2) / range;
+            int index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+            indices |= (uint64_t)index << (i * 3);
+        }
+    }
+
+    out[0] = (unsigned char)maxValue;
+    out[1] = (unsigned char)minValue;
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = (indices >> (i * 8)) & 0xff;
+    }
+}
+
+// Compresses one image level. pixels has the given number of components (1-4) per pixel;
+// edge blocks replicate the last row/column.
+inline std::vector<unsigned char> compress(Format format, const unsigned char* pixels, int width, int height,
+                                           int components) {
+    std::vector<unsigned char> result(compressedSize(format, width, height));
+    unsigned char* out = result.data();
+    unsigned char block[16 * 4];
+
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            for (int y = 0; y < 4; ++y) {
+                int sy = std::min(by + y, height - 1);
+                for (int x = 0; x < 4; ++x) {
+                    int sx = std::min(bx + x, width - 1);
+                    const unsigned char* src = pixels + ((size_t)sy * width + sx) * components;
+                    unsigned char* dst = block + (y * 4 + x) * 4;
+                    dst[0] = src[0];
+                    dst[1] = components > 1 ? src[1] : 0;
+                    dst[2] = components > 2 ? src[2] : 0;
+                    dst[3] = components > 3 ? src[3] : 255;
+                }
+            }
+
+            switch (format) {
+                case Format::BC1: {
+                    encodeColorBlock(block, out);
+                }break;
+                case Format::BC3: {
+                    encodeChannelBlock(block + 3, 4, out);
+                    encodeColorBlock(block, out + 8);
+                }break;
+                case Format::BC4: {
+                    encodeChannelBlock(block, 4, out);
+                }break;
+                case Format::BC5: {
+                    encodeChannelBlock(block, 4, out);
+                    encodeChannelBlock(block + 1, 4, out + 8);
+                }break;
+            }
+            out += blockSize(format);
+        }
+    }
+    return result;
+}
+
+};
+};
+#endif //PROJECT_BASE_BLOCKCOMPRESSION_H
@@ -0,0 +1,154 @@
+#ifndef PROJECT_BASE_BOUNDS_H
+#define PROJECT_BASE_BOUNDS_H
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+namespace rg {
+
+// Axis aligned bounding box. A default constructed box is empty (min > max): expanding it by a
+// point gives that point, and it overlaps nothing and is outside every frustum.
+struct Aabb {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    Aabb() = default;
+    Aabb(const glm::vec3& min, const glm::vec3& max) : min(min), max(max) {}
+
+    bool empty() const {
+        return min.x > max.x;
+    }
+
+    void expand(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void expand(const Aabb& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    glm::vec3 center() const {
+        return (min + max) * 0.5f;
+    }
+
+    float surfaceArea() const {
+        if (empty()) {
+            return 0.0f;
+        }
+        glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool overlaps(const Aabb& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+               min.y <= other.max.y && max.y >= other.min.y &&
+               min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    bool overlapsSphere(const glm::vec3& center, float radius) const {
+        glm::vec3 closest = glm::min(glm::max(center, min), max);
+        glm::vec3 offset = center - closest;
+        return !empty() && glm::dot(offset, offset) <= radius * radius;
+    }
+
+    // Distance along the ray to where it enters the box, or a negative value if it misses the box
+    // or enters it beyond maxDistance. A ray starting inside the box hits it at 0.
+    float intersect(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) const {
+        float entry = 0.0f;
+        float leave = maxDistance;
+        for (int axis = 0; axis < 3; ++axis) {
+            float t0 = (min[axis] - origin[axis]) * inverseDirection[axis];
+            float t1 = (max[axis] - origin[axis]) * inverseDirection[axis];
+            // a ray parallel to the slab and inside it gives NaN, which these comparisons skip
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            entry = t0 > entry ? t0 : entry;
+            leave = t1 < leave ? t1 : leave;
+            if (entry > leave) {
+                return -1.0f;
+            }
+        }
+        return entry;
+    }
+
+    // Bounds of the box after transform, as the box around its eight transformed corners but
+    // computed from the matrix columns (Arvo, Graphics Gems 1990).
+    Aabb transformed(const glm::mat4& transform) const {
+        if (empty()) {
+            return Aabb();
+        }
+        glm::vec3 translation(transform[3]);
+        Aabb result(translation, translation);
+        for (int column = 0; column < 3; ++column) {
+            glm::vec3 axis(transform[column]);
+            glm::vec3 a = axis * min[column];
+            glm::vec3 b = axis * max[column];
+            result.min += glm::min(a, b);
+            result.max += glm::max(a, b);
+        }
+        return result;
+    }
+};
+
+// The six planes of a view frustum, pointing inwards, taken from a projection * view matrix
+// (Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection
+// Matrix").
+struct Frustum {
+    enum Result {
+        Outside,
+        Intersects,
+        Inside
+    };
+
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection) {
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; ++i) {
+            row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        }
+        Frustum frustum;
+        frustum.planes[0] = row[3] + row[0];
+        frustum.planes[1] = row[3] - row[0];
+        frustum.planes[2] = row[3] + row[1];
+        frustum.planes[3] = row[3] - row[1];
+        frustum.planes[4] = row[3] + row[2];
+        frustum.planes[5] = row[3] - row[2];
+        for (glm::vec4& plane : frustum.planes) {
+            plane = plane / glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    // Conservative: a box near a frustum corner can be reported as intersecting although it is
+    // outside, never the other way round.
+    Result test(const Aabb& box) const {
+        Result result = Inside;
+        for (const glm::vec4& plane : planes) {
+            glm::vec3 normal(plane);
+            // the corner furthest along the plane normal and the one furthest against it
+            glm::vec3 positive(normal.x >= 0.0f ? box.max.x : box.min.x,
+                               normal.y >= 0.0f ? box.max.y : box.min.y,
+                               normal.z >= 0.0f ? box.max.z : box.min.z);
+            glm::vec3 negative(normal.x >= 0.0f ? box.min.x : box.max.x,
+                               normal.y >= 0.0f ? box.min.y : box.max.y,
+                               normal.z >= 0.0f ? box.min.z : box.max.z);
+            if (glm::dot(normal, positive) + plane.w < 0.0f) {
+                return Outside;
+            }
+            if (glm::dot(normal, negative) + plane.w < 0.0f) {
+                result = Intersects;
+            }
+        }
+        return result;
+    }
+};
+
+};
+#endif //PROJECT_BASE_BOUNDS_H
@@ -0,0 +1,415 @@
+#ifndef PROJECT_BASE_BVH_H
+#define PROJECT_BASE_BVH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <rg/Bounds.h>
+
+namespace rg {
+
+// Bounding volume hierarchy over the world bounds of scene instances, for frustum culling, picking
+// and overlap queries that don't have to look at every instance.
+//
+// build() splits the items with the surface area heuristic, evaluated on a fixed number of bins
+// per axis (Wald, "On fast Construction of SAH-based Bounding Volume Hierarchies", 2007). Items
+// are partitioned in place, so the items below any node are one contiguous range of m_Items and
+// a node entirely inside the frustum hands out its range without visiting its children.
+//
+// Moving items don't need a rebuild: update() changes an item's bounds and refit() grows or
+// shrinks the boxes on the way from its leaf to the root, which for the few swinging lamps is a
+// handful of nodes per frame. Refitting keeps the tree correct but not optimal, when many items
+// have moved far cost() rises and build() should be called again.
+class Bvh {
+public:
+    typedef uint32_t ItemId;
+    static const ItemId None = ~0u;
+
+    struct Stats {
+        // nodes and items tested by the queries since the last resetStats()
+        unsigned int nodeTests = 0;
+        unsigned int itemTests = 0;
+    };
+
+    void build(const std::vector<Aabb>& bounds) {
+        m_ItemBounds = bounds;
+        m_Nodes.clear();
+        m_Items.resize(bounds.size());
+        m_ItemLeaves.assign(bounds.size(), 0);
+        m_DirtyLeaves.clear();
+        m_Centers.resize(bounds.size());
+        for (ItemId item = 0; item < bounds.size(); ++item) {
+            m_Items[item] = item;
+            // items without bounds yet (e.g. a model still loading) are kept together at the origin
+            m_Centers[item] = bounds[item].empty() ? glm::vec3(0.0f) : bounds[item].center();
+        }
+        m_Nodes.reserve(bounds.size() * 2 / MinLeafItems + 1);
+        m_Nodes.emplace_back();
+        m_Nodes[0].parent = None;
+        split(0, 0, (uint32_t)bounds.size(), 0);
+        m_Dirty.assign(m_Nodes.size(), 0);
+    }
+
+    size_t size() const {
+        return m_ItemBounds.size();
+    }
+
+    const Aabb& bounds(ItemId item) const {
+        return m_ItemBounds[item];
+    }
+
+    // Changes an item's bounds, the nodes above it follow on refit().
+    void update(ItemId item, const Aabb& bounds) {
+        m_ItemBounds[item] = bounds;
+        uint32_t leaf = m_ItemLeaves[item];
+        if (!m_Dirty[leaf]) {
+            m_Dirty[leaf] = 1;
+            m_DirtyLeaves.push_back(leaf);
+        }
+    }
+
+    void refit() {
+        for (uint32_t leaf : m_DirtyLeaves) {
+            m_Dirty[leaf] = 0;
+            for (uint32_t node = leaf; node != None; node = m_Nodes[node].parent) {
+                Aabb bounds = nodeBounds(node);
+                // the nodes further up were built from this box, if it didn't change neither did they
+                if (bounds.min == m_Nodes[node].bounds.min && bounds.max == m_Nodes[node].bounds.max) {
+                    break;
+                }
+                m_Nodes[node].bounds = bounds;
+            }
+        }
+        m_DirtyLeaves.clear();
+    }
+
+    // Surface area heuristic cost of the tree: the node and item tests a random ray through the
+    // root is expected to make (size() without the tree). Refitting after large moves raises it,
+    // once it has grown well past the cost right after build() a rebuild pays off.
+    float cost() const {
+        if (m_Nodes.empty() || m_Nodes[0].bounds.empty()) {
+            return 0.0f;
+        }
+        float total = 0.0f;
+        for (const Node& node : m_Nodes) {
+            float area = node.bounds.surfaceArea();
+            total += node.leaf() ? area * (node.end - node.begin) : area * TraversalCost;
+        }
+        return total / m_Nodes[0].bounds.surfaceArea();
+    }
+
+    // Calls visible(item) for every item whose bounds are at least partly inside the frustum.
+    template<typename Visitor>
+    void cull(const Frustum& frustum, Visitor visible) {
+        if (!m_Nodes.empty()) {
+            cull(frustum, visible, 0, m_Stats);
+        }
+    }
+
+    // The same below one node, counting the tests in stats instead of stats(), so several threads
+    // can cull the subtrees() at once.
+    template<typename Visitor>
+    void cull(const Frustum& frustum, Visitor visible, uint32_t root, Stats& stats) const {
+        uint32_t stack[MaxDepth];
+        uint32_t top = 0;
+        stack[top++] = root;
+        while (top > 0) {
+            const Node& node = m_Nodes[stack[--top]];
+            stats.nodeTests++;
+            Frustum::Result result = frustum.test(node.bounds);
+            if (result == Frustum::Outside) {
+                continue;
+            }
+            if (result == Frustum::Inside) {
+                for (uint32_t i = node.begin; i < node.end; ++i) {
+                    visible(m_Items[i]);
+                }
+            } else if (node.leaf()) {
+                for (uint32_t i = node.begin; i < node.end; ++i) {
+                    stats.itemTests++;
+                    if (frustum.test(m_ItemBounds[m_Items[i]]) != Frustum::Outside) {
+                        visible(m_Items[i]);
+                    }
+                }
+            } else {
+                stack[top++] = node.left;
+                stack[top++] = node.left + 1;
+            }
+        }
+    }
+
+    // Up to count nodes whose subtrees together hold every item once, found by splitting the node
+    // with the most items until there are enough, for spreading a query over threads.
+    void subtrees(size_t count, std::vector<uint32_t>& nodes) const {
+        nodes.clear();
+        if (m_Nodes.empty()) {
+            return;
+        }
+        nodes.push_back(0);
+        while (nodes.size() < count) {
+            size_t largest = nodes.size();
+            uint32_t largestItems = 0;
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                const Node& node = m_Nodes[nodes[i]];
+                if (!node.leaf() && node.end - node.begin > largestItems) {
+                    largest = i;
+                    largestItems = node.end - node.begin;
+                }
+            }
+            if (largest == nodes.size()) {
+                break;
+            }
+            uint32_t left = m_Nodes[nodes[largest]].left;
+            nodes[largest] = left;
+            nodes.push_back(left + 1);
+        }
+    }
+
+    // Nearest item whose bounds the ray hits within maxDistance, or None. distance is set to where
+    // the ray enters it.
+    ItemId raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) {
+        return raycast(origin, direction, maxDistance, distance, [](ItemId, float boundsDistance) {
+            return boundsDistance;
+        });
+    }
+
+    // Same, but hit(item, boundsDistance) refines a bounds hit: it returns the distance to the item
+    // itself (at least boundsDistance), or a negative value if the ray passes it.
+    template<typename HitTest>
+    ItemId raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance,
+                   HitTest hit) {
+        ItemId nearest = None;
+        distance = maxDistance;
+        if (m_Nodes.empty()) {
+            return nearest;
+        }
+        glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        uint32_t stack[MaxDepth];
+        uint32_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = m_Nodes[stack[--top]];
+            m_Stats.nodeTests++;
+            if (node.bounds.intersect(origin, inverseDirection, distance) < 0.0f) {
+                continue;
+            }
+            if (node.leaf()) {
+                for (uint32_t i = node.begin; i < node.end; ++i) {
+                    m_Stats.itemTests++;
+                    float boundsDistance = m_ItemBounds[m_Items[i]].intersect(origin, inverseDirection, distance);
+                    if (boundsDistance < 0.0f) {
+                        continue;
+                    }
+                    float itemDistance = hit(m_Items[i], boundsDistance);
+                    if (itemDistance >= 0.0f && itemDistance < distance) {
+                        distance = itemDistance;
+                        nearest = m_Items[i];
+                    }
+                }
+                continue;
+            }
+            // the nearer child goes on top so it's searched first and shortens the ray for the other
+            const Node& left = m_Nodes[node.left];
+            const Node& right = m_Nodes[node.left + 1];
+            bool leftFirst = glm::dot(left.bounds.center() - right.bounds.center(), direction) <= 0.0f;
+            stack[top++] = leftFirst ? node.left + 1 : node.left;
+            stack[top++] = leftFirst ? node.left : node.left + 1;
+        }
+        return nearest;
+    }
+
+    // Calls overlapping(item) for every item whose bounds overlap the box.
+    template<typename Visitor>
+    void overlap(const Aabb& box, Visitor overlapping) {
+        query([&](const Aabb& bounds) { return bounds.overlaps(box); }, overlapping);
+    }
+
+    // Calls overlapping(item) for every item whose bounds overlap the sphere, e.g. the instances
+    // within reach of a point light.
+    template<typename Visitor>
+    void overlapSphere(const glm::vec3& center, float radius, Visitor overlapping) {
+        query([&](const Aabb& bounds) { return bounds.overlapsSphere(center, radius); }, overlapping);
+    }
+
+    const Stats& stats() const {
+        return m_Stats;
+    }
+
+    void resetStats() {
+        m_Stats = Stats();
+    }
+
+private:
+    // a leaf holds up to MaxLeafItems items, more only if they can't be told apart
+    static const uint32_t MinLeafItems = 2;
+    static const uint32_t MaxLeafItems = 8;
+    static const int Bins = 12;
+    // cost of visiting a node, relative to testing one item
+    static constexpr float TraversalCost = 1.0f;
+    // Past this depth split() only halves, so no path gets longer than MaxSahDepth + 32 and the
+    // traversal stacks (one entry per level) can't overflow.
+    static const uint32_t MaxSahDepth = 64;
+    static const uint32_t MaxDepth = MaxSahDepth + 34;
+
+    struct Node {
+        Aabb bounds;
+        // the items below the node are m_Items[begin, end)
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        // children are left and left + 1, the root is never a child so 0 marks a leaf
+        uint32_t left = 0;
+        uint32_t parent = 0;
+
+        bool leaf() const {
+            return left == 0;
+        }
+    };
+
+    std::vector<Node> m_Nodes;
+    std::vector<ItemId> m_Items;
+    std::vector<Aabb> m_ItemBounds;
+    std::vector<uint32_t> m_ItemLeaves;
+    std::vector<glm::vec3> m_Centers;
+    std::vector<uint8_t> m_Dirty;
+    std::vector<uint32_t> m_DirtyLeaves;
+    Stats m_Stats;
+
+    template<typename Test, typename Visitor>
+    void query(Test overlaps, Visitor overlapping) {
+        if (m_Nodes.empty()) {
+            return;
+        }
+        uint32_t stack[MaxDepth];
+        uint32_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = m_Nodes[stack[--top]];
+            m_Stats.nodeTests++;
+            if (!overlaps(node.bounds)) {
+                continue;
+            }
+            if (node.leaf()) {
+                for (uint32_t i = node.begin; i < node.end; ++i) {
+                    m_Stats.itemTests++;
+                    if (overlaps(m_ItemBounds[m_Items[i]])) {
+                        overlapping(m_Items[i]);
+                    }
+                }
+            } else {
+                stack[top++] = node.left;
+                stack[top++] = node.left + 1;
+            }
+        }
+    }
+
+    Aabb nodeBounds(uint32_t index) const {
+        const Node& node = m_Nodes[index];
+        Aabb bounds;
+        if (node.leaf()) {
+            for (uint32_t i = node.begin; i < node.end; ++i) {
+                bounds.expand(m_ItemBounds[m_Items[i]]);
+            }
+        } else {
+            bounds = m_Nodes[node.left].bounds;
+            bounds.expand(m_Nodes[node.left + 1].bounds);
+        }
+        return bounds;
+    }
+
+    void makeLeaf(uint32_t index) {
+        for (uint32_t i = m_Nodes[index].begin; i < m_Nodes[index].end; ++i) {
+            m_ItemLeaves[m_Items[i]] = index;
+        }
+    }
+
+    void split(uint32_t index, uint32_t begin, uint32_t end, uint32_t depth) {
+        m_Nodes[index].begin = begin;
+        m_Nodes[index].end = end;
+        m_Nodes[index].left = 0;
+        Aabb centers;
+        for (uint32_t i = begin; i < end; ++i) {
+            m_Nodes[index].bounds.expand(m_ItemBounds[m_Items[i]]);
+            centers.expand(m_Centers[m_Items[i]]);
+        }
+        uint32_t count = end - begin;
+        if (count <= MinLeafItems) {
+            makeLeaf(index);
+            return;
+        }
+
+        // the cheapest of the bin boundaries on all three axes
+        int bestAxis = -1;
+        int bestSplit = 0;
+        float bestCost = count * m_Nodes[index].bounds.surfaceArea();
+        for (int axis = 0; axis < 3 && depth < MaxSahDepth; ++axis) {
+            float extent = centers.max[axis] - centers.min[axis];
+            if (extent <= 0.0f) {
+                continue;
+            }
+            Aabb binBounds[Bins];
+            uint32_t binCounts[Bins] = {};
+            float scale = Bins / extent;
+            for (uint32_t i = begin; i < end; ++i) {
+                int bin = binIndex(m_Centers[m_Items[i]][axis], centers.min[axis], scale);
+                binCounts[bin]++;
+                binBounds[bin].expand(m_ItemBounds[m_Items[i]]);
+            }
+            // sweep from the right to get the cost of everything right of each boundary
+            float rightCosts[Bins];
+            Aabb right;
+            uint32_t rightCount = 0;
+            for (int bin = Bins - 1; bin > 0; --bin) {
+                right.expand(binBounds[bin]);
+                rightCount += binCounts[bin];
+                rightCosts[bin] = rightCount * right.surfaceArea();
+            }
+            Aabb left;
+            uint32_t leftCount = 0;
+            for (int bin = 0; bin < Bins - 1; ++bin) {
+                left.expand(binBounds[bin]);
+                leftCount += binCounts[bin];
+                float cost = leftCount * left.surfaceArea() + rightCosts[bin + 1];
+                if (leftCount > 0 && leftCount < count && cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = bin + 1;
+                }
+            }
+        }
+
+        uint32_t middle;
+        if (bestAxis >= 0) {
+            float scale = Bins / (centers.max[bestAxis] - centers.min[bestAxis]);
+            float minimum = centers.min[bestAxis];
+            ItemId* split = std::partition(&m_Items[begin], &m_Items[begin] + count, [&](ItemId item) {
+                return binIndex(m_Centers[item][bestAxis], minimum, scale) < bestSplit;
+            });
+            middle = (uint32_t)(split - &m_Items[0]);
+        } else if (count > MaxLeafItems) {
+            // no split beats a leaf (e.g. all centers in one spot) or the tree is already very
+            // deep, but the leaf would be too big
+            middle = begin + count / 2;
+        } else {
+            makeLeaf(index);
+            return;
+        }
+
+        uint32_t left = (uint32_t)m_Nodes.size();
+        m_Nodes.emplace_back();
+        m_Nodes.emplace_back();
+        m_Nodes[index].left = left;
+        m_Nodes[left].parent = index;
+        m_Nodes[left + 1].parent = index;
+        split(left, begin, middle, depth + 1);
+        split(left + 1, middle, end, depth + 1);
+    }
+
+    static int binIndex(float center, float minimum, float scale) {
+        return std::min((int)((center - minimum) * scale), Bins - 1);
+    }
+};
+
+};
+#endif //PROJECT_BASE_BVH_H
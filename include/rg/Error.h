@@ -11,22 +11,35 @@
 #define LOG(stream) stream << "[" << __FILE__ << ", " << __func__ << ", " << __LINE__ << "] "
 #define BREAK_IF_FALSE(x) if (!(x)) __builtin_trap()
 #define ASSERT(x, msg) do { if (!(x)) { std::cerr << msg << '\n'; BREAK_IF_FALSE(false); } } while(0)
+// With RG_GL_DEBUG (cmake -DRG_GL_DEBUG=ON) GLCALL checks glGetError after x, unless the context
+// reports errors through rg::GLDebug, whose synchronous callback already stops inside x. glGetError
+// makes many drivers wait for the GPU, so without RG_GL_DEBUG GLCALL(x) is just x.
+#ifdef RG_GL_DEBUG
 #define GLCALL(x) \
-do{ rg::clearAllOpenGlErrors(); x; BREAK_IF_FALSE(rg::wasPreviousOpenGLCallSuccessful(__FILE__, __LINE__, #x)); } while (0)
+do{ if (rg::debugOutputEnabled()) { x; } else { rg::clearAllOpenGlErrors(); x; BREAK_IF_FALSE(rg::wasPreviousOpenGLCallSuccessful(__FILE__, __LINE__, #x)); } } while (0)
+#else
+#define GLCALL(x) do{ x; } while (0)
+#endif
 
 namespace rg {
 
     
-void clearAllOpenGlErrors();
-const char* openGLErrorToString(GLenum error);
-bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* call);
+inline void clearAllOpenGlErrors();
+inline const char* openGLErrorToString(GLenum error);
+inline bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* call);
 
-    void clearAllOpenGlErrors() {
+    // true once rg::GLDebug reports errors for the context current on this thread
+    inline bool& debugOutputEnabled() {
+        static thread_local bool enabled = false;
+        return enabled;
+    }
+
+    inline void clearAllOpenGlErrors() {
         while (glGetError() != GL_NO_ERROR) {
             ;
         }
     }
-    const char* openGLErrorToString(GLenum error) {
+    inline const char* openGLErrorToString(GLenum error) {
         switch(error) {
             case GL_NO_ERROR: return "GL_NO_ERROR";
             case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
@@ -37,7 +50,7 @@ bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* cal
         ASSERT(false, "Passed something that is not an error code");
         return "THIS_SHOULD_NEVER_HAPPEN";
     }
-    bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* call) {
+    inline bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* call) {
         bool success = true;
         while (GLenum error = glGetError()) {
             std::cerr << "[OpenGL error] " << error << " " << openGLErrorToString(error)
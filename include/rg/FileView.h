@@ -0,0 +1,151 @@
+#ifndef PROJECT_BASE_FILEVIEW_H
+#define PROJECT_BASE_FILEVIEW_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rg {
+
+// Read-only view of a whole file's contents, valid as long as the object lives.
+//
+// Regular files are memory mapped, so parsers read straight from the page cache without a copy.
+// Anything that can't be mapped (pipes, procfs files reporting size 0, filesystems without mmap
+// support) is read into an owned buffer instead; callers see the same data()/size() either way.
+class FileView {
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+    bool m_Open = false;
+    bool m_Mapped = false;
+    std::vector<unsigned char> m_Buffer;
+public:
+    FileView() = default;
+
+    explicit FileView(const std::string& path) {
+        open(path);
+    }
+
+    ~FileView() {
+        close();
+    }
+
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    FileView(FileView&& other) noexcept
+    : m_Data(other.m_Data), m_Size(other.m_Size), m_Open(other.m_Open), m_Mapped(other.m_Mapped),
+      m_Buffer(std::move(other.m_Buffer)) {
+        other.m_Data = nullptr;
+        other.m_Size = 0;
+        other.m_Open = false;
+        other.m_Mapped = false;
+    }
+
+    FileView& operator=(FileView&& other) noexcept {
+        if (this != &other) {
+            close();
+            std::swap(m_Data, other.m_Data);
+            std::swap(m_Size, other.m_Size);
+            std::swap(m_Open, other.m_Open);
+            std::swap(m_Mapped, other.m_Mapped);
+            m_Buffer.swap(other.m_Buffer);
+        }
+        return *this;
+    }
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        if (S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                m_Data = (const unsigned char*)data;
+                m_Size = (size_t)info.st_size;
+                m_Mapped = true;
+            }
+        }
+        if (!m_Mapped && !readAll(fd, info)) {
+            ::close(fd);
+            return false;
+        }
+        // a mapping keeps its own reference to the file
+        ::close(fd);
+        m_Open = true;
+        return true;
+    }
+
+    void close() {
+        if (m_Mapped) {
+            munmap((void*)m_Data, m_Size);
+        }
+        std::vector<unsigned char>().swap(m_Buffer);
+        m_Data = nullptr;
+        m_Size = 0;
+        m_Open = false;
+        m_Mapped = false;
+    }
+
+    bool isOpen() const {
+        return m_Open;
+    }
+
+    // false if the contents were read into a buffer
+    bool isMapped() const {
+        return m_Mapped;
+    }
+
+    const unsigned char* data() const {
+        return m_Data;
+    }
+
+    size_t size() const {
+        return m_Size;
+    }
+
+    const char* begin() const {
+        return (const char*)m_Data;
+    }
+
+    const char* end() const {
+        return (const char*)m_Data + m_Size;
+    }
+
+private:
+    bool readAll(int fd, const struct stat& info) {
+        m_Buffer.resize(info.st_size > 0 ? (size_t)info.st_size : 4096);
+        size_t size = 0;
+        while (true) {
+            if (size == m_Buffer.size()) {
+                m_Buffer.resize(m_Buffer.size() * 2);
+            }
+            ssize_t count = ::read(fd, m_Buffer.data() + size, m_Buffer.size() - size);
+            if (count < 0) {
+                std::vector<unsigned char>().swap(m_Buffer);
+                return false;
+            }
+            if (count == 0) {
+                break;
+            }
+            size += (size_t)count;
+        }
+        m_Buffer.resize(size);
+        m_Data = m_Buffer.data();
+        m_Size = size;
+        return true;
+    }
+};
+
+};
+#endif //PROJECT_BASE_FILEVIEW_H
@@ -0,0 +1,127 @@
+#ifndef PROJECT_BASE_FRAMEGRAPH_H
+#define PROJECT_BASE_FRAMEGRAPH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <rg/Error.h>
+#include <rg/JobSystem.h>
+
+namespace rg {
+
+// The CPU work of a frame as passes with dependencies between them, run on a JobSystem.
+//
+// The graph is set up once and run every frame. A pass names the passes it needs, which have to
+// be added before it, so there can't be a cycle. Passes without dependencies are queued when the
+// frame starts; every other pass is queued by the thread that finishes the last pass it waits for,
+// so independent passes run side by side and no thread polls for them. A pass can be parallel
+// itself with JobSystem::parallelFor().
+//
+// start() returns right away, the calling thread can do its own work (GL calls, which have to stay
+// on the thread that owns the context) until it calls wait(), which helps running the passes.
+class FrameGraph {
+public:
+    typedef uint32_t PassId;
+
+    PassId addPass(const std::string& name, std::function<void()> function,
+                   const std::vector<PassId>& dependencies = {}) {
+        ASSERT(!m_Running, "Frame graph changed while it runs");
+        PassId id = (PassId)m_Passes.size();
+        m_Passes.emplace_back(new Pass());
+        Pass& pass = *m_Passes.back();
+        pass.name = name;
+        pass.function = std::move(function);
+        pass.dependencies = (uint32_t)dependencies.size();
+        for (PassId dependency : dependencies) {
+            ASSERT(dependency < id, "Frame graph pass depends on a pass added after it");
+            m_Passes[dependency]->dependents.push_back(id);
+        }
+        return id;
+    }
+
+    void start(JobSystem& jobs) {
+        ASSERT(!m_Running, "Frame graph started twice");
+        m_Running = true;
+        m_Frames++;
+        for (std::unique_ptr<Pass>& pass : m_Passes) {
+            pass->remaining = pass->dependencies;
+        }
+        for (PassId id = 0; id < m_Passes.size(); ++id) {
+            if (m_Passes[id]->dependencies == 0) {
+                schedule(jobs, id);
+            }
+        }
+    }
+
+    // Returns when every pass of the frame finished.
+    void wait(JobSystem& jobs) {
+        jobs.wait(m_Pending);
+        m_Running = false;
+    }
+
+    void execute(JobSystem& jobs) {
+        start(jobs);
+        wait(jobs);
+    }
+
+    // average time per frame of each pass
+    double milliseconds(PassId id) const {
+        return m_Frames ? m_Passes[id]->milliseconds / m_Frames : 0.0;
+    }
+
+    size_t size() const {
+        return m_Passes.size();
+    }
+
+    const std::string& name(PassId id) const {
+        return m_Passes[id]->name;
+    }
+
+    void printStats() const {
+        std::cout << "Frame graph, ms per frame:";
+        for (PassId id = 0; id < m_Passes.size(); ++id) {
+            std::cout << (id ? ", " : " ") << m_Passes[id]->name << " " << milliseconds(id);
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    struct Pass {
+        std::string name;
+        std::function<void()> function;
+        std::vector<PassId> dependents;
+        uint32_t dependencies = 0;
+        // dependencies that haven't finished this frame
+        std::atomic<uint32_t> remaining{0};
+        // summed over all frames, only touched by the thread running the pass
+        double milliseconds = 0.0;
+    };
+
+    std::vector<std::unique_ptr<Pass>> m_Passes;
+    JobSystem::Counter m_Pending{0};
+    bool m_Running = false;
+    unsigned int m_Frames = 0;
+
+    void schedule(JobSystem& jobs, PassId id) {
+        jobs.run(m_Pending, [this, &jobs, id]() {
+            Pass& pass = *m_Passes[id];
+            auto start = std::chrono::steady_clock::now();
+            pass.function();
+            pass.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            // queued before this job counts as finished, so m_Pending can't drop to zero in between
+            for (PassId dependent : pass.dependents) {
+                if (m_Passes[dependent]->remaining.fetch_sub(1) == 1) {
+                    schedule(jobs, dependent);
+                }
+            }
+        });
+    }
+};
+
+};
+#endif //PROJECT_BASE_FRAMEGRAPH_H
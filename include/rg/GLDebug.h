@@ -0,0 +1,154 @@
+#ifndef PROJECT_BASE_GLDEBUG_H
+#define PROJECT_BASE_GLDEBUG_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <rg/Error.h>
+#include <rg/GLExtensions.h>
+
+namespace rg {
+
+// Reports OpenGL errors and warnings through a KHR_debug callback instead of polling glGetError.
+//
+// The driver only calls back when there is something to report, so checked calls cost nothing
+// extra. By default the output is asynchronous: the driver may report from its own thread,
+// some time after the call. With RG_GL_DEBUG the program asks for a debug context and the output
+// is synchronous, so the callback runs inside the offending call and a breakpoint in report()
+// shows where it came from, at the price of the driver doing its work in order.
+//
+// Notifications are turned off in the driver, as are the ids passed to ignore(). Every other
+// message is printed the first time it arrives; repeats are only counted, see printStats().
+class GLDebug {
+public:
+#ifdef RG_GL_DEBUG
+    static const bool Synchronous = true;
+#else
+    static const bool Synchronous = false;
+#endif
+
+    static GLDebug& instance() {
+        static GLDebug debug;
+        return debug;
+    }
+
+    // Messages with one of these ids aren't generated any more, call before install().
+    void ignore(GLuint id) {
+        m_Ignored.push_back(id);
+    }
+
+    // Installs the callback for the current context, each context (and thread) needs its own
+    // call. Returns false without KHR_debug, GLCALL falls back to glGetError then.
+    bool install(bool synchronous = Synchronous) {
+        const DebugOutputFunctions& functions = debugOutputFunctions();
+        if (!functions.available()) {
+            return false;
+        }
+        glEnable(GL_DEBUG_OUTPUT);
+        if (synchronous) {
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        } else {
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        }
+        functions.debugMessageCallback(callback, this);
+        functions.debugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+        if (!m_Ignored.empty()) {
+            functions.debugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, (GLsizei)m_Ignored.size(),
+                                          m_Ignored.data(), GL_FALSE);
+        }
+        debugOutputEnabled() = true;
+        return true;
+    }
+
+    // true if the context was created with GLFW_OPENGL_DEBUG_CONTEXT, only those report everything
+    static bool debugContext() {
+        GLint flags = 0;
+        glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+        return (flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+    }
+
+    void printStats() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::cout << "GL debug output: " << m_Messages << " messages, " << m_Counts.size() << " distinct" << std::endl;
+        std::vector<std::pair<unsigned int, const std::string*>> repeated;
+        for (const auto& message : m_Counts) {
+            if (message.second > 1) {
+                repeated.emplace_back(message.second, &message.first);
+            }
+        }
+        std::sort(repeated.begin(), repeated.end(), [](const std::pair<unsigned int, const std::string*>& a,
+                                                       const std::pair<unsigned int, const std::string*>& b) {
+            return a.first > b.first;
+        });
+        for (const auto& message : repeated) {
+            std::cout << "  " << message.first << "x " << *message.second << std::endl;
+        }
+    }
+
+private:
+    std::mutex m_Mutex;
+    std::unordered_map<std::string, unsigned int> m_Counts;
+    std::vector<GLuint> m_Ignored;
+    unsigned int m_Messages = 0;
+
+    GLDebug() = default;
+
+    static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                  const GLchar* message, const void* userParam) {
+        GLDebug* debug = (GLDebug*)userParam;
+        debug->report(source, type, id, severity, length < 0 ? std::string(message) : std::string(message, length));
+    }
+
+    void report(GLenum source, GLenum type, GLuint id, GLenum severity, const std::string& message) {
+        // the same message can come from several places, the text usually names the object
+        std::string text = std::string(sourceToString(source)) + " " + typeToString(type) + " " +
+                           std::to_string(id) + " (" + severityToString(severity) + "): " + message;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Messages++;
+        if (m_Counts[text]++ == 0) {
+            std::cerr << "[OpenGL] " << text << std::endl;
+        }
+    }
+
+    static const char* sourceToString(GLenum source) {
+        switch (source) {
+            case GL_DEBUG_SOURCE_API: return "api";
+            case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window-system";
+            case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader-compiler";
+            case GL_DEBUG_SOURCE_THIRD_PARTY: return "third-party";
+            case GL_DEBUG_SOURCE_APPLICATION: return "application";
+        }
+        return "other";
+    }
+
+    static const char* typeToString(GLenum type) {
+        switch (type) {
+            case GL_DEBUG_TYPE_ERROR: return "error";
+            case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+            case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined-behavior";
+            case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+            case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+            case GL_DEBUG_TYPE_MARKER: return "marker";
+            case GL_DEBUG_TYPE_PUSH_GROUP: return "push-group";
+            case GL_DEBUG_TYPE_POP_GROUP: return "pop-group";
+        }
+        return "other";
+    }
+
+    static const char* severityToString(GLenum severity) {
+        switch (severity) {
+            case GL_DEBUG_SEVERITY_HIGH: return "high";
+            case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+            case GL_DEBUG_SEVERITY_LOW: return "low";
+        }
+        return "notification";
+    }
+};
+
+};
+#endif //PROJECT_BASE_GLDEBUG_H
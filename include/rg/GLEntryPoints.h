@@ -0,0 +1,383 @@
+#ifndef PROJECT_BASE_GLENTRYPOINTS_H
+#define PROJECT_BASE_GLENTRYPOINTS_H
+
+// Every entry point glad loads (core 3.3), for code that has to visit all of them, like rg::GLTrace.
+// Define RG_GL_ENTRY_POINT(name) before RG_GL_ENTRY_POINTS is expanded; name is the unprefixed
+// function name, so use it with # or ## to keep glad's macro from replacing it.
+#define RG_GL_ENTRY_POINTS \
+    RG_GL_ENTRY_POINT(glCullFace) \
+    RG_GL_ENTRY_POINT(glFrontFace) \
+    RG_GL_ENTRY_POINT(glHint) \
+    RG_GL_ENTRY_POINT(glLineWidth) \
+    RG_GL_ENTRY_POINT(glPointSize) \
+    RG_GL_ENTRY_POINT(glPolygonMode) \
+    RG_GL_ENTRY_POINT(glScissor) \
+    RG_GL_ENTRY_POINT(glTexParameterf) \
+    RG_GL_ENTRY_POINT(glTexParameterfv) \
+    RG_GL_ENTRY_POINT(glTexParameteri) \
+    RG_GL_ENTRY_POINT(glTexParameteriv) \
+    RG_GL_ENTRY_POINT(glTexImage1D) \
+    RG_GL_ENTRY_POINT(glTexImage2D) \
+    RG_GL_ENTRY_POINT(glDrawBuffer) \
+    RG_GL_ENTRY_POINT(glClear) \
+    RG_GL_ENTRY_POINT(glClearColor) \
+    RG_GL_ENTRY_POINT(glClearStencil) \
+    RG_GL_ENTRY_POINT(glClearDepth) \
+    RG_GL_ENTRY_POINT(glStencilMask) \
+    RG_GL_ENTRY_POINT(glColorMask) \
+    RG_GL_ENTRY_POINT(glDepthMask) \
+    RG_GL_ENTRY_POINT(glDisable) \
+    RG_GL_ENTRY_POINT(glEnable) \
+    RG_GL_ENTRY_POINT(glFinish) \
+    RG_GL_ENTRY_POINT(glFlush) \
+    RG_GL_ENTRY_POINT(glBlendFunc) \
+    RG_GL_ENTRY_POINT(glLogicOp) \
+    RG_GL_ENTRY_POINT(glStencilFunc) \
+    RG_GL_ENTRY_POINT(glStencilOp) \
+    RG_GL_ENTRY_POINT(glDepthFunc) \
+    RG_GL_ENTRY_POINT(glPixelStoref) \
+    RG_GL_ENTRY_POINT(glPixelStorei) \
+    RG_GL_ENTRY_POINT(glReadBuffer) \
+    RG_GL_ENTRY_POINT(glReadPixels) \
+    RG_GL_ENTRY_POINT(glGetBooleanv) \
+    RG_GL_ENTRY_POINT(glGetDoublev) \
+    RG_GL_ENTRY_POINT(glGetError) \
+    RG_GL_ENTRY_POINT(glGetFloatv) \
+    RG_GL_ENTRY_POINT(glGetIntegerv) \
+    RG_GL_ENTRY_POINT(glGetString) \
+    RG_GL_ENTRY_POINT(glGetTexImage) \
+    RG_GL_ENTRY_POINT(glGetTexParameterfv) \
+    RG_GL_ENTRY_POINT(glGetTexParameteriv) \
+    RG_GL_ENTRY_POINT(glGetTexLevelParameterfv) \
+    RG_GL_ENTRY_POINT(glGetTexLevelParameteriv) \
+    RG_GL_ENTRY_POINT(glIsEnabled) \
+    RG_GL_ENTRY_POINT(glDepthRange) \
+    RG_GL_ENTRY_POINT(glViewport) \
+    RG_GL_ENTRY_POINT(glDrawArrays) \
+    RG_GL_ENTRY_POINT(glDrawElements) \
+    RG_GL_ENTRY_POINT(glPolygonOffset) \
+    RG_GL_ENTRY_POINT(glCopyTexImage1D) \
+    RG_GL_ENTRY_POINT(glCopyTexImage2D) \
+    RG_GL_ENTRY_POINT(glCopyTexSubImage1D) \
+    RG_GL_ENTRY_POINT(glCopyTexSubImage2D) \
+    RG_GL_ENTRY_POINT(glTexSubImage1D) \
+    RG_GL_ENTRY_POINT(glTexSubImage2D) \
+    RG_GL_ENTRY_POINT(glBindTexture) \
+    RG_GL_ENTRY_POINT(glDeleteTextures) \
+    RG_GL_ENTRY_POINT(glGenTextures) \
+    RG_GL_ENTRY_POINT(glIsTexture) \
+    RG_GL_ENTRY_POINT(glDrawRangeElements) \
+    RG_GL_ENTRY_POINT(glTexImage3D) \
+    RG_GL_ENTRY_POINT(glTexSubImage3D) \
+    RG_GL_ENTRY_POINT(glCopyTexSubImage3D) \
+    RG_GL_ENTRY_POINT(glActiveTexture) \
+    RG_GL_ENTRY_POINT(glSampleCoverage) \
+    RG_GL_ENTRY_POINT(glCompressedTexImage3D) \
+    RG_GL_ENTRY_POINT(glCompressedTexImage2D) \
+    RG_GL_ENTRY_POINT(glCompressedTexImage1D) \
+    RG_GL_ENTRY_POINT(glCompressedTexSubImage3D) \
+    RG_GL_ENTRY_POINT(glCompressedTexSubImage2D) \
+    RG_GL_ENTRY_POINT(glCompressedTexSubImage1D) \
+    RG_GL_ENTRY_POINT(glGetCompressedTexImage) \
+    RG_GL_ENTRY_POINT(glBlendFuncSeparate) \
+    RG_GL_ENTRY_POINT(glMultiDrawArrays) \
+    RG_GL_ENTRY_POINT(glMultiDrawElements) \
+    RG_GL_ENTRY_POINT(glPointParameterf) \
+    RG_GL_ENTRY_POINT(glPointParameterfv) \
+    RG_GL_ENTRY_POINT(glPointParameteri) \
+    RG_GL_ENTRY_POINT(glPointParameteriv) \
+    RG_GL_ENTRY_POINT(glBlendColor) \
+    RG_GL_ENTRY_POINT(glBlendEquation) \
+    RG_GL_ENTRY_POINT(glGenQueries) \
+    RG_GL_ENTRY_POINT(glDeleteQueries) \
+    RG_GL_ENTRY_POINT(glIsQuery) \
+    RG_GL_ENTRY_POINT(glBeginQuery) \
+    RG_GL_ENTRY_POINT(glEndQuery) \
+    RG_GL_ENTRY_POINT(glGetQueryiv) \
+    RG_GL_ENTRY_POINT(glGetQueryObjectiv) \
+    RG_GL_ENTRY_POINT(glGetQueryObjectuiv) \
+    RG_GL_ENTRY_POINT(glBindBuffer) \
+    RG_GL_ENTRY_POINT(glDeleteBuffers) \
+    RG_GL_ENTRY_POINT(glGenBuffers) \
+    RG_GL_ENTRY_POINT(glIsBuffer) \
+    RG_GL_ENTRY_POINT(glBufferData) \
+    RG_GL_ENTRY_POINT(glBufferSubData) \
+    RG_GL_ENTRY_POINT(glGetBufferSubData) \
+    RG_GL_ENTRY_POINT(glMapBuffer) \
+    RG_GL_ENTRY_POINT(glUnmapBuffer) \
+    RG_GL_ENTRY_POINT(glGetBufferParameteriv) \
+    RG_GL_ENTRY_POINT(glGetBufferPointerv) \
+    RG_GL_ENTRY_POINT(glBlendEquationSeparate) \
+    RG_GL_ENTRY_POINT(glDrawBuffers) \
+    RG_GL_ENTRY_POINT(glStencilOpSeparate) \
+    RG_GL_ENTRY_POINT(glStencilFuncSeparate) \
+    RG_GL_ENTRY_POINT(glStencilMaskSeparate) \
+    RG_GL_ENTRY_POINT(glAttachShader) \
+    RG_GL_ENTRY_POINT(glBindAttribLocation) \
+    RG_GL_ENTRY_POINT(glCompileShader) \
+    RG_GL_ENTRY_POINT(glCreateProgram) \
+    RG_GL_ENTRY_POINT(glCreateShader) \
+    RG_GL_ENTRY_POINT(glDeleteProgram) \
+    RG_GL_ENTRY_POINT(glDeleteShader) \
+    RG_GL_ENTRY_POINT(glDetachShader) \
+    RG_GL_ENTRY_POINT(glDisableVertexAttribArray) \
+    RG_GL_ENTRY_POINT(glEnableVertexAttribArray) \
+    RG_GL_ENTRY_POINT(glGetActiveAttrib) \
+    RG_GL_ENTRY_POINT(glGetActiveUniform) \
+    RG_GL_ENTRY_POINT(glGetAttachedShaders) \
+    RG_GL_ENTRY_POINT(glGetAttribLocation) \
+    RG_GL_ENTRY_POINT(glGetProgramiv) \
+    RG_GL_ENTRY_POINT(glGetProgramInfoLog) \
+    RG_GL_ENTRY_POINT(glGetShaderiv) \
+    RG_GL_ENTRY_POINT(glGetShaderInfoLog) \
+    RG_GL_ENTRY_POINT(glGetShaderSource) \
+    RG_GL_ENTRY_POINT(glGetUniformLocation) \
+    RG_GL_ENTRY_POINT(glGetUniformfv) \
+    RG_GL_ENTRY_POINT(glGetUniformiv) \
+    RG_GL_ENTRY_POINT(glGetVertexAttribdv) \
+    RG_GL_ENTRY_POINT(glGetVertexAttribfv) \
+    RG_GL_ENTRY_POINT(glGetVertexAttribiv) \
+    RG_GL_ENTRY_POINT(glGetVertexAttribPointerv) \
+    RG_GL_ENTRY_POINT(glIsProgram) \
+    RG_GL_ENTRY_POINT(glIsShader) \
+    RG_GL_ENTRY_POINT(glLinkProgram) \
+    RG_GL_ENTRY_POINT(glShaderSource) \
+    RG_GL_ENTRY_POINT(glUseProgram) \
+    RG_GL_ENTRY_POINT(glUniform1f) \
+    RG_GL_ENTRY_POINT(glUniform2f) \
+    RG_GL_ENTRY_POINT(glUniform3f) \
+    RG_GL_ENTRY_POINT(glUniform4f) \
+    RG_GL_ENTRY_POINT(glUniform1i) \
+    RG_GL_ENTRY_POINT(glUniform2i) \
+    RG_GL_ENTRY_POINT(glUniform3i) \
+    RG_GL_ENTRY_POINT(glUniform4i) \
+    RG_GL_ENTRY_POINT(glUniform1fv) \
+    RG_GL_ENTRY_POINT(glUniform2fv) \
+    RG_GL_ENTRY_POINT(glUniform3fv) \
+    RG_GL_ENTRY_POINT(glUniform4fv) \
+    RG_GL_ENTRY_POINT(glUniform1iv) \
+    RG_GL_ENTRY_POINT(glUniform2iv) \
+    RG_GL_ENTRY_POINT(glUniform3iv) \
+    RG_GL_ENTRY_POINT(glUniform4iv) \
+    RG_GL_ENTRY_POINT(glUniformMatrix2fv) \
+    RG_GL_ENTRY_POINT(glUniformMatrix3fv) \
+    RG_GL_ENTRY_POINT(glUniformMatrix4fv) \
+    RG_GL_ENTRY_POINT(glValidateProgram) \
+    RG_GL_ENTRY_POINT(glVertexAttrib1d) \
+    RG_GL_ENTRY_POINT(glVertexAttrib1dv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib1f) \
+    RG_GL_ENTRY_POINT(glVertexAttrib1fv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib1s) \
+    RG_GL_ENTRY_POINT(glVertexAttrib1sv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib2d) \
+    RG_GL_ENTRY_POINT(glVertexAttrib2dv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib2f) \
+    RG_GL_ENTRY_POINT(glVertexAttrib2fv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib2s) \
+    RG_GL_ENTRY_POINT(glVertexAttrib2sv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib3d) \
+    RG_GL_ENTRY_POINT(glVertexAttrib3dv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib3f) \
+    RG_GL_ENTRY_POINT(glVertexAttrib3fv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib3s) \
+    RG_GL_ENTRY_POINT(glVertexAttrib3sv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4Nbv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4Niv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4Nsv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4Nub) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4Nubv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4Nuiv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4Nusv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4bv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4d) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4dv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4f) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4fv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4iv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4s) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4sv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4ubv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4uiv) \
+    RG_GL_ENTRY_POINT(glVertexAttrib4usv) \
+    RG_GL_ENTRY_POINT(glVertexAttribPointer) \
+    RG_GL_ENTRY_POINT(glUniformMatrix2x3fv) \
+    RG_GL_ENTRY_POINT(glUniformMatrix3x2fv) \
+    RG_GL_ENTRY_POINT(glUniformMatrix2x4fv) \
+    RG_GL_ENTRY_POINT(glUniformMatrix4x2fv) \
+    RG_GL_ENTRY_POINT(glUniformMatrix3x4fv) \
+    RG_GL_ENTRY_POINT(glUniformMatrix4x3fv) \
+    RG_GL_ENTRY_POINT(glColorMaski) \
+    RG_GL_ENTRY_POINT(glGetBooleani_v) \
+    RG_GL_ENTRY_POINT(glGetIntegeri_v) \
+    RG_GL_ENTRY_POINT(glEnablei) \
+    RG_GL_ENTRY_POINT(glDisablei) \
+    RG_GL_ENTRY_POINT(glIsEnabledi) \
+    RG_GL_ENTRY_POINT(glBeginTransformFeedback) \
+    RG_GL_ENTRY_POINT(glEndTransformFeedback) \
+    RG_GL_ENTRY_POINT(glBindBufferRange) \
+    RG_GL_ENTRY_POINT(glBindBufferBase) \
+    RG_GL_ENTRY_POINT(glTransformFeedbackVaryings) \
+    RG_GL_ENTRY_POINT(glGetTransformFeedbackVarying) \
+    RG_GL_ENTRY_POINT(glClampColor) \
+    RG_GL_ENTRY_POINT(glBeginConditionalRender) \
+    RG_GL_ENTRY_POINT(glEndConditionalRender) \
+    RG_GL_ENTRY_POINT(glVertexAttribIPointer) \
+    RG_GL_ENTRY_POINT(glGetVertexAttribIiv) \
+    RG_GL_ENTRY_POINT(glGetVertexAttribIuiv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI1i) \
+    RG_GL_ENTRY_POINT(glVertexAttribI2i) \
+    RG_GL_ENTRY_POINT(glVertexAttribI3i) \
+    RG_GL_ENTRY_POINT(glVertexAttribI4i) \
+    RG_GL_ENTRY_POINT(glVertexAttribI1ui) \
+    RG_GL_ENTRY_POINT(glVertexAttribI2ui) \
+    RG_GL_ENTRY_POINT(glVertexAttribI3ui) \
+    RG_GL_ENTRY_POINT(glVertexAttribI4ui) \
+    RG_GL_ENTRY_POINT(glVertexAttribI1iv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI2iv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI3iv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI4iv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI1uiv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI2uiv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI3uiv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI4uiv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI4bv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI4sv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI4ubv) \
+    RG_GL_ENTRY_POINT(glVertexAttribI4usv) \
+    RG_GL_ENTRY_POINT(glGetUniformuiv) \
+    RG_GL_ENTRY_POINT(glBindFragDataLocation) \
+    RG_GL_ENTRY_POINT(glGetFragDataLocation) \
+    RG_GL_ENTRY_POINT(glUniform1ui) \
+    RG_GL_ENTRY_POINT(glUniform2ui) \
+    RG_GL_ENTRY_POINT(glUniform3ui) \
+    RG_GL_ENTRY_POINT(glUniform4ui) \
+    RG_GL_ENTRY_POINT(glUniform1uiv) \
+    RG_GL_ENTRY_POINT(glUniform2uiv) \
+    RG_GL_ENTRY_POINT(glUniform3uiv) \
+    RG_GL_ENTRY_POINT(glUniform4uiv) \
+    RG_GL_ENTRY_POINT(glTexParameterIiv) \
+    RG_GL_ENTRY_POINT(glTexParameterIuiv) \
+    RG_GL_ENTRY_POINT(glGetTexParameterIiv) \
+    RG_GL_ENTRY_POINT(glGetTexParameterIuiv) \
+    RG_GL_ENTRY_POINT(glClearBufferiv) \
+    RG_GL_ENTRY_POINT(glClearBufferuiv) \
+    RG_GL_ENTRY_POINT(glClearBufferfv) \
+    RG_GL_ENTRY_POINT(glClearBufferfi) \
+    RG_GL_ENTRY_POINT(glGetStringi) \
+    RG_GL_ENTRY_POINT(glIsRenderbuffer) \
+    RG_GL_ENTRY_POINT(glBindRenderbuffer) \
+    RG_GL_ENTRY_POINT(glDeleteRenderbuffers) \
+    RG_GL_ENTRY_POINT(glGenRenderbuffers) \
+    RG_GL_ENTRY_POINT(glRenderbufferStorage) \
+    RG_GL_ENTRY_POINT(glGetRenderbufferParameteriv) \
+    RG_GL_ENTRY_POINT(glIsFramebuffer) \
+    RG_GL_ENTRY_POINT(glBindFramebuffer) \
+    RG_GL_ENTRY_POINT(glDeleteFramebuffers) \
+    RG_GL_ENTRY_POINT(glGenFramebuffers) \
+    RG_GL_ENTRY_POINT(glCheckFramebufferStatus) \
+    RG_GL_ENTRY_POINT(glFramebufferTexture1D) \
+    RG_GL_ENTRY_POINT(glFramebufferTexture2D) \
+    RG_GL_ENTRY_POINT(glFramebufferTexture3D) \
+    RG_GL_ENTRY_POINT(glFramebufferRenderbuffer) \
+    RG_GL_ENTRY_POINT(glGetFramebufferAttachmentParameteriv) \
+    RG_GL_ENTRY_POINT(glGenerateMipmap) \
+    RG_GL_ENTRY_POINT(glBlitFramebuffer) \
+    RG_GL_ENTRY_POINT(glRenderbufferStorageMultisample) \
+    RG_GL_ENTRY_POINT(glFramebufferTextureLayer) \
+    RG_GL_ENTRY_POINT(glMapBufferRange) \
+    RG_GL_ENTRY_POINT(glFlushMappedBufferRange) \
+    RG_GL_ENTRY_POINT(glBindVertexArray) \
+    RG_GL_ENTRY_POINT(glDeleteVertexArrays) \
+    RG_GL_ENTRY_POINT(glGenVertexArrays) \
+    RG_GL_ENTRY_POINT(glIsVertexArray) \
+    RG_GL_ENTRY_POINT(glDrawArraysInstanced) \
+    RG_GL_ENTRY_POINT(glDrawElementsInstanced) \
+    RG_GL_ENTRY_POINT(glTexBuffer) \
+    RG_GL_ENTRY_POINT(glPrimitiveRestartIndex) \
+    RG_GL_ENTRY_POINT(glCopyBufferSubData) \
+    RG_GL_ENTRY_POINT(glGetUniformIndices) \
+    RG_GL_ENTRY_POINT(glGetActiveUniformsiv) \
+    RG_GL_ENTRY_POINT(glGetActiveUniformName) \
+    RG_GL_ENTRY_POINT(glGetUniformBlockIndex) \
+    RG_GL_ENTRY_POINT(glGetActiveUniformBlockiv) \
+    RG_GL_ENTRY_POINT(glGetActiveUniformBlockName) \
+    RG_GL_ENTRY_POINT(glUniformBlockBinding) \
+    RG_GL_ENTRY_POINT(glDrawElementsBaseVertex) \
+    RG_GL_ENTRY_POINT(glDrawRangeElementsBaseVertex) \
+    RG_GL_ENTRY_POINT(glDrawElementsInstancedBaseVertex) \
+    RG_GL_ENTRY_POINT(glMultiDrawElementsBaseVertex) \
+    RG_GL_ENTRY_POINT(glProvokingVertex) \
+    RG_GL_ENTRY_POINT(glFenceSync) \
+    RG_GL_ENTRY_POINT(glIsSync) \
+    RG_GL_ENTRY_POINT(glDeleteSync) \
+    RG_GL_ENTRY_POINT(glClientWaitSync) \
+    RG_GL_ENTRY_POINT(glWaitSync) \
+    RG_GL_ENTRY_POINT(glGetInteger64v) \
+    RG_GL_ENTRY_POINT(glGetSynciv) \
+    RG_GL_ENTRY_POINT(glGetInteger64i_v) \
+    RG_GL_ENTRY_POINT(glGetBufferParameteri64v) \
+    RG_GL_ENTRY_POINT(glFramebufferTexture) \
+    RG_GL_ENTRY_POINT(glTexImage2DMultisample) \
+    RG_GL_ENTRY_POINT(glTexImage3DMultisample) \
+    RG_GL_ENTRY_POINT(glGetMultisamplefv) \
+    RG_GL_ENTRY_POINT(glSampleMaski) \
+    RG_GL_ENTRY_POINT(glBindFragDataLocationIndexed) \
+    RG_GL_ENTRY_POINT(glGetFragDataIndex) \
+    RG_GL_ENTRY_POINT(glGenSamplers) \
+    RG_GL_ENTRY_POINT(glDeleteSamplers) \
+    RG_GL_ENTRY_POINT(glIsSampler) \
+    RG_GL_ENTRY_POINT(glBindSampler) \
+    RG_GL_ENTRY_POINT(glSamplerParameteri) \
+    RG_GL_ENTRY_POINT(glSamplerParameteriv) \
+    RG_GL_ENTRY_POINT(glSamplerParameterf) \
+    RG_GL_ENTRY_POINT(glSamplerParameterfv) \
+    RG_GL_ENTRY_POINT(glSamplerParameterIiv) \
+    RG_GL_ENTRY_POINT(glSamplerParameterIuiv) \
+    RG_GL_ENTRY_POINT(glGetSamplerParameteriv) \
+    RG_GL_ENTRY_POINT(glGetSamplerParameterIiv) \
+    RG_GL_ENTRY_POINT(glGetSamplerParameterfv) \
+    RG_GL_ENTRY_POINT(glGetSamplerParameterIuiv) \
+    RG_GL_ENTRY_POINT(glQueryCounter) \
+    RG_GL_ENTRY_POINT(glGetQueryObjecti64v) \
+    RG_GL_ENTRY_POINT(glGetQueryObjectui64v) \
+    RG_GL_ENTRY_POINT(glVertexAttribDivisor) \
+    RG_GL_ENTRY_POINT(glVertexAttribP1ui) \
+    RG_GL_ENTRY_POINT(glVertexAttribP1uiv) \
+    RG_GL_ENTRY_POINT(glVertexAttribP2ui) \
+    RG_GL_ENTRY_POINT(glVertexAttribP2uiv) \
+    RG_GL_ENTRY_POINT(glVertexAttribP3ui) \
+    RG_GL_ENTRY_POINT(glVertexAttribP3uiv) \
+    RG_GL_ENTRY_POINT(glVertexAttribP4ui) \
+    RG_GL_ENTRY_POINT(glVertexAttribP4uiv) \
+    RG_GL_ENTRY_POINT(glVertexP2ui) \
+    RG_GL_ENTRY_POINT(glVertexP2uiv) \
+    RG_GL_ENTRY_POINT(glVertexP3ui) \
+    RG_GL_ENTRY_POINT(glVertexP3uiv) \
+    RG_GL_ENTRY_POINT(glVertexP4ui) \
+    RG_GL_ENTRY_POINT(glVertexP4uiv) \
+    RG_GL_ENTRY_POINT(glTexCoordP1ui) \
+    RG_GL_ENTRY_POINT(glTexCoordP1uiv) \
+    RG_GL_ENTRY_POINT(glTexCoordP2ui) \
+    RG_GL_ENTRY_POINT(glTexCoordP2uiv) \
+    RG_GL_ENTRY_POINT(glTexCoordP3ui) \
+    RG_GL_ENTRY_POINT(glTexCoordP3uiv) \
+    RG_GL_ENTRY_POINT(glTexCoordP4ui) \
+    RG_GL_ENTRY_POINT(glTexCoordP4uiv) \
+    RG_GL_ENTRY_POINT(glMultiTexCoordP1ui) \
+    RG_GL_ENTRY_POINT(glMultiTexCoordP1uiv) \
+    RG_GL_ENTRY_POINT(glMultiTexCoordP2ui) \
+    RG_GL_ENTRY_POINT(glMultiTexCoordP2uiv) \
+    RG_GL_ENTRY_POINT(glMultiTexCoordP3ui) \
+    RG_GL_ENTRY_POINT(glMultiTexCoordP3uiv) \
+    RG_GL_ENTRY_POINT(glMultiTexCoordP4ui) \
+    RG_GL_ENTRY_POINT(glMultiTexCoordP4uiv) \
+    RG_GL_ENTRY_POINT(glNormalP3ui) \
+    RG_GL_ENTRY_POINT(glNormalP3uiv) \
+    RG_GL_ENTRY_POINT(glColorP3ui) \
+    RG_GL_ENTRY_POINT(glColorP3uiv) \
+    RG_GL_ENTRY_POINT(glColorP4ui) \
+    RG_GL_ENTRY_POINT(glColorP4uiv) \
+    RG_GL_ENTRY_POINT(glSecondaryColorP3ui) \
+    RG_GL_ENTRY_POINT(glSecondaryColorP3uiv)
+
+#endif //PROJECT_BASE_GLENTRYPOINTS_H
@@ -0,0 +1,179 @@
+#ifndef PROJECT_BASE_GLEXTENSIONS_H
+#define PROJECT_BASE_GLEXTENSIONS_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <unordered_set>
+
+// glad is generated for core 3.3 without extensions, so the extension enums and entry points
+// we use are declared here and resolved at runtime (through GLFW, like glad itself).
+
+// EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// ARB_get_program_binary, core since 4.1
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+typedef void (APIENTRYP RG_PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length,
+                                                      GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP RG_PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary,
+                                                   GLsizei length);
+typedef void (APIENTRYP RG_PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+// KHR_parallel_shader_compile, ARB_parallel_shader_compile uses the same enum
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP RG_PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// ARB_buffer_storage, core since 4.4
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+typedef void (APIENTRYP RG_PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// KHR_debug, core since 4.3
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_CONTEXT_FLAG_DEBUG_BIT 0x00000002
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_TYPE_MARKER 0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
+#define GL_DEBUG_TYPE_POP_GROUP 0x826A
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#endif
+typedef void (APIENTRYP RG_PFNGLDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC callback, const void* userParam);
+typedef void (APIENTRYP RG_PFNGLDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity, GLsizei count,
+                                                         const GLuint* ids, GLboolean enabled);
+
+namespace rg {
+
+// Must be called with a current context. The extension list is read once and cached.
+inline bool hasExtension(const char* name) {
+    static std::unordered_set<std::string> extensions = [] {
+        std::unordered_set<std::string> result;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            result.insert((const char*)glGetStringi(GL_EXTENSIONS, i));
+        }
+        return result;
+    }();
+    return extensions.count(name) != 0;
+}
+
+inline bool hasVersion(int major, int minor) {
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+struct ProgramBinaryFunctions {
+    RG_PFNGLGETPROGRAMBINARYPROC getProgramBinary = nullptr;
+    RG_PFNGLPROGRAMBINARYPROC programBinary = nullptr;
+    RG_PFNGLPROGRAMPARAMETERIPROC programParameteri = nullptr;
+
+    bool available() const {
+        return getProgramBinary && programBinary && programParameteri;
+    }
+};
+
+// Null entry points if the driver doesn't support program binaries or offers no binary format
+// (which some drivers report even with the extension present).
+inline const ProgramBinaryFunctions& programBinaryFunctions() {
+    static ProgramBinaryFunctions functions = [] {
+        ProgramBinaryFunctions result;
+        GLint formats = 0;
+        if (hasVersion(4, 1) || hasExtension("GL_ARB_get_program_binary")) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        if (formats > 0) {
+            result.getProgramBinary = (RG_PFNGLGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+            result.programBinary = (RG_PFNGLPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+            result.programParameteri = (RG_PFNGLPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+        }
+        return result;
+    }();
+    return functions;
+}
+
+// true if shaders and programs can be polled with GL_COMPLETION_STATUS_KHR. The first call lets
+// the driver pick its number of compiler threads, which some only start on request.
+inline bool parallelShaderCompile() {
+    static bool available = [] {
+        const char* name = nullptr;
+        if (hasExtension("GL_KHR_parallel_shader_compile")) {
+            name = "glMaxShaderCompilerThreadsKHR";
+        } else if (hasExtension("GL_ARB_parallel_shader_compile")) {
+            name = "glMaxShaderCompilerThreadsARB";
+        } else {
+            return false;
+        }
+        auto maxShaderCompilerThreads = (RG_PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress(name);
+        if (maxShaderCompilerThreads) {
+            maxShaderCompilerThreads(0xFFFFFFFFu);
+        }
+        return true;
+    }();
+    return available;
+}
+
+// null without immutable buffer storage, which persistent mapping needs
+inline RG_PFNGLBUFFERSTORAGEPROC bufferStorageFunction() {
+    static RG_PFNGLBUFFERSTORAGEPROC function = [] {
+        if (!hasVersion(4, 4) && !hasExtension("GL_ARB_buffer_storage")) {
+            return (RG_PFNGLBUFFERSTORAGEPROC)nullptr;
+        }
+        return (RG_PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+    }();
+    return function;
+}
+
+struct DebugOutputFunctions {
+    RG_PFNGLDEBUGMESSAGECALLBACKPROC debugMessageCallback = nullptr;
+    RG_PFNGLDEBUGMESSAGECONTROLPROC debugMessageControl = nullptr;
+
+    bool available() const {
+        return debugMessageCallback && debugMessageControl;
+    }
+};
+
+// Null entry points without KHR_debug. ARB_debug_output isn't used, it can't be switched off
+// and has no notification severity to filter on.
+inline const DebugOutputFunctions& debugOutputFunctions() {
+    static DebugOutputFunctions functions = [] {
+        DebugOutputFunctions result;
+        if (hasVersion(4, 3) || hasExtension("GL_KHR_debug")) {
+            result.debugMessageCallback = (RG_PFNGLDEBUGMESSAGECALLBACKPROC)glfwGetProcAddress("glDebugMessageCallback");
+            result.debugMessageControl = (RG_PFNGLDEBUGMESSAGECONTROLPROC)glfwGetProcAddress("glDebugMessageControl");
+        }
+        return result;
+    }();
+    return functions;
+}
+
+};
+#endif //PROJECT_BASE_GLEXTENSIONS_H
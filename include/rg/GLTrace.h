@@ -0,0 +1,569 @@
+#ifndef PROJECT_BASE_GLTRACE_H
+#define PROJECT_BASE_GLTRACE_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <rg/GLEntryPoints.h>
+
+namespace rg {
+
+// Counts the GL calls each frame makes, by wrapping glad's function pointers.
+//
+// install() replaces every loaded glad_gl* pointer with a wrapper that counts the call and
+// forwards it, so nothing changes until it is installed. Only calls from the installing thread
+// (the render thread) are counted, other threads just pass through.
+//
+// Per frame it counts calls per entry point, draws, uniform calls, state changes and the bytes
+// uploaded from client memory by glBufferData/glBufferSubData and the glTex(Sub)Image calls.
+// Data written through mapped buffers isn't visible here. Binds and glEnable/glDisable are
+// compared against the value last set by the same thread, so redundant state changes are
+// counted too. endFrame() writes the frame's numbers to the log; a Section attributes the
+// calls made while it exists to a name, e.g. the render queue flush or the light uniforms.
+class GLTrace {
+public:
+    struct Counters {
+        uint64_t calls = 0;
+        uint64_t draws = 0;
+        uint64_t uniformCalls = 0;
+        uint64_t stateChanges = 0;
+        uint64_t redundantStateChanges = 0;
+        uint64_t uploadBytes = 0;
+
+        Counters& operator+=(const Counters& other) {
+            calls += other.calls;
+            draws += other.draws;
+            uniformCalls += other.uniformCalls;
+            stateChanges += other.stateChanges;
+            redundantStateChanges += other.redundantStateChanges;
+            uploadBytes += other.uploadBytes;
+            return *this;
+        }
+    };
+
+    // Attributes the calls made during its lifetime to name, which has to be a string literal.
+    class Section {
+    public:
+        explicit Section(const char* name) {
+            GLTrace* trace = current();
+            if (trace) {
+                m_Previous = trace->m_Section;
+                trace->m_Section = trace->section(name);
+            }
+        }
+
+        ~Section() {
+            GLTrace* trace = current();
+            if (trace) {
+                trace->m_Section = m_Previous;
+            }
+        }
+
+        Section(const Section&) = delete;
+        Section& operator=(const Section&) = delete;
+
+    private:
+        int m_Previous = -1;
+    };
+
+    static GLTrace& instance() {
+        static GLTrace trace;
+        return trace;
+    }
+
+    // Wraps the glad entry points and writes per-frame statistics to logPath. Call on the
+    // render thread after glad is loaded, before other threads use the GL.
+    bool install(const std::string& logPath);
+
+    bool installed() const {
+        return m_Installed;
+    }
+
+    // Ends the frame: writes its statistics to the log and starts counting the next one.
+    void endFrame() {
+        if (!m_Installed) {
+            return;
+        }
+        m_Log << "frame " << m_Frames << ": " << describe(m_Frame) << "\n";
+        for (size_t i = 0; i < m_Sections.size(); ++i) {
+            m_Log << "  " << m_Sections[i].first << ": " << describe(m_Sections[i].second) << "\n";
+            m_SectionTotals[i] += m_Sections[i].second;
+            m_Sections[i].second = Counters();
+        }
+        m_Log << "  top:";
+        for (size_t entry : top(m_Calls, 8)) {
+            m_Log << " " << m_Names[entry] << " " << m_Calls[entry];
+        }
+        m_Log << "\n";
+
+        for (size_t i = 0; i < m_Calls.size(); ++i) {
+            m_TotalCalls[i] += m_Calls[i];
+            m_Calls[i] = 0;
+        }
+        m_Total += m_Frame;
+        m_Frame = Counters();
+        m_Frames++;
+    }
+
+    // Per-frame averages over all frames so far.
+    void printSummary() const {
+        if (!m_Installed || m_Frames == 0) {
+            return;
+        }
+        std::cout << "GL calls per frame (" << m_Frames << " frames): " << describe(m_Total, m_Frames) << std::endl;
+        for (size_t i = 0; i < m_Sections.size(); ++i) {
+            std::cout << "  " << m_Sections[i].first << ": " << describe(m_SectionTotals[i], m_Frames) << std::endl;
+        }
+        std::cout << "  top:";
+        for (size_t entry : top(m_TotalCalls, 8)) {
+            std::cout << " " << m_Names[entry] << " " << m_TotalCalls[entry] / m_Frames;
+        }
+        std::cout << std::endl;
+    }
+
+    // The trace counting the calls of this thread, null on other threads.
+    static GLTrace*& current() {
+        static thread_local GLTrace* trace = nullptr;
+        return trace;
+    }
+
+    // Used by the hooks.
+    void call(unsigned int entry) {
+        m_Calls[entry]++;
+        Counters* section = m_Section >= 0 ? &m_Sections[m_Section].second : nullptr;
+        switch (m_Categories[entry]) {
+            case Draw:
+                m_Frame.draws++;
+                if (section) section->draws++;
+                break;
+            case Uniform:
+                m_Frame.uniformCalls++;
+                if (section) section->uniformCalls++;
+                break;
+            case State:
+                m_Frame.stateChanges++;
+                if (section) section->stateChanges++;
+                break;
+            default:
+                break;
+        }
+        m_Frame.calls++;
+        if (section) section->calls++;
+    }
+
+    void upload(uint64_t bytes) {
+        m_Frame.uploadBytes += bytes;
+        if (m_Section >= 0) {
+            m_Sections[m_Section].second.uploadBytes += bytes;
+        }
+    }
+
+    // Records that the state identified by key was set to value, counting it if it already was.
+    void set(uint64_t key, uint64_t value) {
+        auto it = m_State.find(key);
+        if (it != m_State.end() && it->second == value) {
+            m_Frame.redundantStateChanges++;
+            if (m_Section >= 0) {
+                m_Sections[m_Section].second.redundantStateChanges++;
+            }
+            return;
+        }
+        m_State[key] = value;
+    }
+
+    // Forgets the state identified by key, e.g. after the object bound there was deleted.
+    void forget(uint64_t key) {
+        m_State.erase(key);
+    }
+
+    void forgetAll() {
+        m_State.clear();
+    }
+
+    bool holds(uint64_t key, uint64_t value) const {
+        auto it = m_State.find(key);
+        return it != m_State.end() && it->second == value;
+    }
+
+    // 0 if unknown
+    uint64_t get(uint64_t key) const {
+        auto it = m_State.find(key);
+        return it != m_State.end() ? it->second : 0;
+    }
+
+    GLenum activeTexture() const {
+        return m_ActiveTexture;
+    }
+
+    void setActiveTexture(GLenum unit) {
+        m_ActiveTexture = unit;
+    }
+
+    static uint64_t stateKey(uint32_t function, uint32_t target, uint32_t index = 0) {
+        return ((uint64_t)function << 48) ^ ((uint64_t)index << 32) ^ target;
+    }
+
+private:
+    enum Category {
+        Other,
+        Draw,
+        Uniform,
+        State
+    };
+
+    bool m_Installed = false;
+    std::ofstream m_Log;
+    std::vector<const char*> m_Names;
+    std::vector<Category> m_Categories;
+    std::vector<uint64_t> m_Calls;
+    std::vector<uint64_t> m_TotalCalls;
+    std::vector<std::pair<const char*, Counters>> m_Sections;
+    std::vector<Counters> m_SectionTotals;
+    int m_Section = -1;
+    Counters m_Frame;
+    Counters m_Total;
+    uint64_t m_Frames = 0;
+    std::unordered_map<uint64_t, uint64_t> m_State;
+    GLenum m_ActiveTexture = GL_TEXTURE0;
+
+    GLTrace() = default;
+
+    unsigned int add(const char* name) {
+        static const char* statePrefixes[] = {
+            "glBindBuffer", "glBindFramebuffer", "glBindRenderbuffer", "glBindSampler", "glBindTexture",
+            "glBindVertexArray", "glUseProgram", "glActiveTexture", "glEnable", "glDisable", "glBlend",
+            "glDepthFunc", "glDepthMask", "glDepthRange", "glColorMask", "glCullFace", "glFrontFace",
+            "glPolygon", "glStencilFunc", "glStencilOp", "glStencilMask", "glViewport", "glScissor",
+            "glLineWidth", "glPointSize", "glClearColor", "glClearDepth", "glClearStencil", "glPixelStore",
+            "glProvokingVertex", "glSampleMask", "glPrimitiveRestartIndex", "glVertexAttribPointer",
+            "glVertexAttribIPointer", "glVertexAttribDivisor"
+        };
+        auto startsWith = [name](const char* prefix) {
+            return std::strncmp(name, prefix, std::strlen(prefix)) == 0;
+        };
+        Category category = Other;
+        if (startsWith("glDraw") || startsWith("glMultiDraw")) {
+            category = Draw;
+        } else if (startsWith("glUniform") && !startsWith("glUniformBlockBinding")) {
+            category = Uniform;
+        } else {
+            for (const char* prefix : statePrefixes) {
+                if (startsWith(prefix)) {
+                    category = State;
+                    break;
+                }
+            }
+        }
+        m_Names.push_back(name);
+        m_Categories.push_back(category);
+        m_Calls.push_back(0);
+        m_TotalCalls.push_back(0);
+        return (unsigned int)(m_Names.size() - 1);
+    }
+
+    int section(const char* name) {
+        for (size_t i = 0; i < m_Sections.size(); ++i) {
+            if (m_Sections[i].first == name || std::strcmp(m_Sections[i].first, name) == 0) {
+                return (int)i;
+            }
+        }
+        m_Sections.emplace_back(name, Counters());
+        m_SectionTotals.emplace_back();
+        return (int)(m_Sections.size() - 1);
+    }
+
+    static std::vector<size_t> top(const std::vector<uint64_t>& calls, size_t count) {
+        std::vector<size_t> entries;
+        for (size_t i = 0; i < calls.size(); ++i) {
+            if (calls[i] > 0) {
+                entries.push_back(i);
+            }
+        }
+        count = std::min(count, entries.size());
+        std::partial_sort(entries.begin(), entries.begin() + count, entries.end(), [&calls](size_t a, size_t b) {
+            return calls[a] > calls[b];
+        });
+        entries.resize(count);
+        return entries;
+    }
+
+    static std::string describe(const Counters& counters, uint64_t frames = 1) {
+        return std::to_string(counters.calls / frames) + " calls, " +
+               std::to_string(counters.draws / frames) + " draws, " +
+               std::to_string(counters.uniformCalls / frames) + " uniforms, " +
+               std::to_string(counters.stateChanges / frames) + " state changes (" +
+               std::to_string(counters.redundantStateChanges / frames) + " redundant), " +
+               std::to_string(counters.uploadBytes / frames) + " bytes uploaded";
+    }
+
+    template<typename Function, Function* Entry>
+    friend struct GLTraceHook;
+};
+
+// Extra bookkeeping for some entry points, run before the call is forwarded. The default does nothing.
+template<typename Function, Function* Entry>
+struct GLTraceObserver {
+    template<typename... Args>
+    static void observe(GLTrace& trace, Args... args) {
+    }
+};
+
+// Wraps one glad entry point.
+template<typename Function, Function* Entry>
+struct GLTraceHook;
+
+template<typename R, typename... Args, R (APIENTRYP* Entry)(Args...)>
+struct GLTraceHook<R (APIENTRYP)(Args...), Entry> {
+    typedef R (APIENTRYP Function)(Args...);
+
+    static Function& original() {
+        static Function function = nullptr;
+        return function;
+    }
+
+    static unsigned int& index() {
+        static unsigned int value = 0;
+        return value;
+    }
+
+    static R APIENTRY call(Args... args) {
+        GLTrace* trace = GLTrace::current();
+        if (trace) {
+            trace->call(index());
+            GLTraceObserver<Function, Entry>::observe(*trace, args...);
+        }
+        return original()(args...);
+    }
+
+    static void install(GLTrace& trace, const char* name) {
+        if (!*Entry || *Entry == call) {
+            return;
+        }
+        original() = *Entry;
+        index() = trace.add(name);
+        *Entry = call;
+    }
+};
+
+namespace gltrace {
+
+inline uint64_t pixelSize(GLenum format, GLenum type) {
+    uint64_t components = 4;
+    switch (format) {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: components = 1; break;
+        case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL: components = 2; break;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+    }
+    switch (type) {
+        case GL_UNSIGNED_BYTE: case GL_BYTE: return components;
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+        case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: return components * 4;
+    }
+    // packed formats hold a whole pixel
+    return type == GL_UNSIGNED_SHORT_5_6_5 || type == GL_UNSIGNED_SHORT_4_4_4_4 ? 2 : 4;
+}
+
+// pixels are read from client memory, not from a pixel buffer
+inline bool fromClientMemory(GLTrace& trace, const void* pixels) {
+    return pixels && trace.get(GLTrace::stateKey(1, GL_PIXEL_UNPACK_BUFFER)) == 0;
+}
+
+};
+
+// The first argument of stateKey tells the kinds of state apart: 1 buffer bindings, 2 texture
+// bindings, 3 enables, 4 programs, 5 vertex arrays, 6 framebuffers, 7 indexed buffer ranges.
+
+template<>
+struct GLTraceObserver<PFNGLBINDBUFFERPROC, &glad_glBindBuffer> {
+    static void observe(GLTrace& trace, GLenum target, GLuint buffer) {
+        trace.set(GLTrace::stateKey(1, target), buffer);
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLBINDBUFFERRANGEPROC, &glad_glBindBufferRange> {
+    static void observe(GLTrace& trace, GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        // also binds the generic target
+        trace.forget(GLTrace::stateKey(1, target));
+        trace.set(GLTrace::stateKey(7, target, index), ((uint64_t)buffer << 40) ^ ((uint64_t)offset << 8) ^ (uint64_t)size);
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLBINDBUFFERBASEPROC, &glad_glBindBufferBase> {
+    static void observe(GLTrace& trace, GLenum target, GLuint index, GLuint buffer) {
+        trace.forget(GLTrace::stateKey(1, target));
+        trace.forget(GLTrace::stateKey(7, target, index));
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLACTIVETEXTUREPROC, &glad_glActiveTexture> {
+    static void observe(GLTrace& trace, GLenum unit) {
+        trace.set(GLTrace::stateKey(2, 0), unit);
+        trace.setActiveTexture(unit);
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLBINDTEXTUREPROC, &glad_glBindTexture> {
+    static void observe(GLTrace& trace, GLenum target, GLuint texture) {
+        trace.set(GLTrace::stateKey(2, target, trace.activeTexture()), texture);
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLENABLEPROC, &glad_glEnable> {
+    static void observe(GLTrace& trace, GLenum capability) {
+        trace.set(GLTrace::stateKey(3, capability), 1);
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLDISABLEPROC, &glad_glDisable> {
+    static void observe(GLTrace& trace, GLenum capability) {
+        trace.set(GLTrace::stateKey(3, capability), 2);
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLUSEPROGRAMPROC, &glad_glUseProgram> {
+    static void observe(GLTrace& trace, GLuint program) {
+        trace.set(GLTrace::stateKey(4, 0), program);
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLBINDVERTEXARRAYPROC, &glad_glBindVertexArray> {
+    static void observe(GLTrace& trace, GLuint vertexArray) {
+        trace.set(GLTrace::stateKey(5, 0), vertexArray);
+        // the element buffer binding belongs to the vertex array
+        trace.forget(GLTrace::stateKey(1, GL_ELEMENT_ARRAY_BUFFER));
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLBINDFRAMEBUFFERPROC, &glad_glBindFramebuffer> {
+    static void observe(GLTrace& trace, GLenum target, GLuint framebuffer) {
+        if (target != GL_FRAMEBUFFER) {
+            trace.set(GLTrace::stateKey(6, target), framebuffer);
+            return;
+        }
+        // binds both, only redundant if both already were
+        uint64_t draw = GLTrace::stateKey(6, GL_DRAW_FRAMEBUFFER);
+        uint64_t read = GLTrace::stateKey(6, GL_READ_FRAMEBUFFER);
+        bool redundant = trace.holds(draw, framebuffer) && trace.holds(read, framebuffer);
+        if (!redundant) {
+            trace.forget(draw);
+        }
+        trace.forget(read);
+        trace.set(read, framebuffer);
+        trace.set(draw, framebuffer);
+    }
+};
+
+// Deleting bound objects resets their bindings and names are reused, so deletes drop what is known.
+#define RG_GL_TRACE_FORGET_ON_DELETE(function, proc) \
+template<> \
+struct GLTraceObserver<proc, &glad_##function> { \
+    static void observe(GLTrace& trace, GLsizei count, const GLuint* names) { \
+        trace.forgetAll(); \
+    } \
+};
+RG_GL_TRACE_FORGET_ON_DELETE(glDeleteBuffers, PFNGLDELETEBUFFERSPROC)
+RG_GL_TRACE_FORGET_ON_DELETE(glDeleteTextures, PFNGLDELETETEXTURESPROC)
+RG_GL_TRACE_FORGET_ON_DELETE(glDeleteVertexArrays, PFNGLDELETEVERTEXARRAYSPROC)
+RG_GL_TRACE_FORGET_ON_DELETE(glDeleteFramebuffers, PFNGLDELETEFRAMEBUFFERSPROC)
+#undef RG_GL_TRACE_FORGET_ON_DELETE
+
+template<>
+struct GLTraceObserver<PFNGLDELETEPROGRAMPROC, &glad_glDeleteProgram> {
+    static void observe(GLTrace& trace, GLuint program) {
+        trace.forgetAll();
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLBUFFERDATAPROC, &glad_glBufferData> {
+    static void observe(GLTrace& trace, GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+        if (data) {
+            trace.upload(size);
+        }
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLBUFFERSUBDATAPROC, &glad_glBufferSubData> {
+    static void observe(GLTrace& trace, GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+        trace.upload(size);
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLTEXIMAGE2DPROC, &glad_glTexImage2D> {
+    static void observe(GLTrace& trace, GLenum target, GLint level, GLint internalFormat, GLsizei width,
+                        GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+        if (gltrace::fromClientMemory(trace, pixels)) {
+            trace.upload((uint64_t)width * height * gltrace::pixelSize(format, type));
+        }
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLTEXSUBIMAGE2DPROC, &glad_glTexSubImage2D> {
+    static void observe(GLTrace& trace, GLenum target, GLint level, GLint x, GLint y, GLsizei width,
+                        GLsizei height, GLenum format, GLenum type, const void* pixels) {
+        if (gltrace::fromClientMemory(trace, pixels)) {
+            trace.upload((uint64_t)width * height * gltrace::pixelSize(format, type));
+        }
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLCOMPRESSEDTEXIMAGE2DPROC, &glad_glCompressedTexImage2D> {
+    static void observe(GLTrace& trace, GLenum target, GLint level, GLenum internalFormat, GLsizei width,
+                        GLsizei height, GLint border, GLsizei imageSize, const void* data) {
+        if (gltrace::fromClientMemory(trace, data)) {
+            trace.upload(imageSize);
+        }
+    }
+};
+
+template<>
+struct GLTraceObserver<PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC, &glad_glCompressedTexSubImage2D> {
+    static void observe(GLTrace& trace, GLenum target, GLint level, GLint x, GLint y, GLsizei width,
+                        GLsizei height, GLenum format, GLsizei imageSize, const void* data) {
+        if (gltrace::fromClientMemory(trace, data)) {
+            trace.upload(imageSize);
+        }
+    }
+};
+
+inline bool GLTrace::install(const std::string& logPath) {
+    if (m_Installed) {
+        return true;
+    }
+    m_Log.open(logPath);
+    if (!m_Log) {
+        std::cout << "GLTrace: can't write " << logPath << std::endl;
+        return false;
+    }
+#define RG_GL_ENTRY_POINT(name) GLTraceHook<decltype(glad_##name), &glad_##name>::install(*this, #name);
+    RG_GL_ENTRY_POINTS
+#undef RG_GL_ENTRY_POINT
+    current() = this;
+    m_Installed = true;
+    std::cout << "GLTrace: " << m_Names.size() << " entry points wrapped, writing " << logPath << std::endl;
+    return true;
+}
+
+};
+#endif //PROJECT_BASE_GLTRACE_H
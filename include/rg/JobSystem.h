@@ -0,0 +1,237 @@
+#ifndef PROJECT_BASE_JOBSYSTEM_H
+#define PROJECT_BASE_JOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <rg/Parallel.h>
+
+namespace rg {
+
+// Work-stealing job scheduler for the CPU work of a frame.
+//
+// Every thread has its own deque of jobs: the one that created the system is thread 0 and works
+// on jobs while it waits for them, the others are workers. A thread pushes and pops at the back
+// of its own deque, so it carries on with what it split off last while that is still in its
+// cache, and only when its deque is empty takes from the front of another thread's, where the
+// oldest and, with parallelFor(), largest pieces of work are. Threads that find nothing sleep
+// until a job is pushed.
+//
+// wait() doesn't block: it runs jobs until its counter is zero. Jobs can therefore start jobs and
+// wait for them (a parallelFor() inside a frame graph pass) without tying up a thread.
+class JobSystem {
+public:
+    // unfinished jobs of a group, run() counts up and finishing a job counts down
+    typedef std::atomic<int> Counter;
+
+    struct Stats {
+        unsigned int jobs = 0;
+        // jobs taken from another thread's deque
+        unsigned int steals = 0;
+    };
+
+    explicit JobSystem(unsigned int threads = hardwareThreads()) {
+        threads = std::max(threads, 1u);
+        for (unsigned int i = 0; i < threads; ++i) {
+            m_Queues.emplace_back(new Queue());
+        }
+        current() = ThreadSlot{this, 0};
+        for (unsigned int i = 1; i < threads; ++i) {
+            m_Workers.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        for (std::thread& worker : m_Workers) {
+            worker.join();
+        }
+        if (current().system == this) {
+            current() = ThreadSlot();
+        }
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int threads() const {
+        return (unsigned int)m_Queues.size();
+    }
+
+    // Index of the calling thread in [0, threads()), for per-thread output of jobs. Only the thread
+    // that created the system and its workers have one.
+    unsigned int threadIndex() const {
+        return current().system == this ? current().index : 0;
+    }
+
+    // Queues job on the calling thread's deque.
+    void run(Counter& counter, std::function<void()> job) {
+        counter.fetch_add(1);
+        Queue& queue = *m_Queues[threadIndex()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(Job{std::move(job), &counter});
+        }
+        m_Queued.fetch_add(1);
+        // a worker going to sleep counts itself before it checks m_Queued, so either it sees this
+        // job or this sees it sleeping and wakes it
+        if (m_Sleeping.load() > 0) {
+            { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+            m_Wake.notify_one();
+        }
+    }
+
+    // Runs jobs, any thread's, until every job counted by counter finished.
+    void wait(Counter& counter) {
+        unsigned int index = threadIndex();
+        while (counter.load(std::memory_order_acquire) > 0) {
+            if (!runOne(index)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Calls function(begin, end) on ranges of at most grain indices covering [0, count) and
+    // returns when all calls finished. The range is halved recursively, one half queued and the
+    // other split further, so an idle thread steals half of the remaining work at once.
+    template<typename Function>
+    void parallelFor(size_t count, size_t grain, Function function) {
+        if (count == 0) {
+            return;
+        }
+        Counter counter(0);
+        splitRange(0, count, std::max<size_t>(grain, 1), function, counter);
+        wait(counter);
+    }
+
+    Stats stats() const {
+        Stats stats;
+        for (const std::unique_ptr<Queue>& queue : m_Queues) {
+            stats.jobs += queue->executed.load(std::memory_order_relaxed);
+            stats.steals += queue->stolen.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    void resetStats() {
+        for (std::unique_ptr<Queue>& queue : m_Queues) {
+            queue->executed = 0;
+            queue->stolen = 0;
+        }
+    }
+
+private:
+    struct Job {
+        std::function<void()> function;
+        Counter* counter;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        // written by the thread the deque belongs to only
+        std::atomic<unsigned int> executed{0};
+        std::atomic<unsigned int> stolen{0};
+    };
+
+    struct ThreadSlot {
+        const JobSystem* system = nullptr;
+        unsigned int index = 0;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_Queues;
+    std::atomic<int> m_Queued{0};
+    std::atomic<int> m_Sleeping{0};
+    std::mutex m_SleepMutex;
+    std::condition_variable m_Wake;
+    bool m_Stop = false;
+    std::vector<std::thread> m_Workers;
+
+    static ThreadSlot& current() {
+        static thread_local ThreadSlot slot;
+        return slot;
+    }
+
+    template<typename Function>
+    void splitRange(size_t begin, size_t end, size_t grain, const Function& function, Counter& counter) {
+        while (end - begin > grain) {
+            size_t middle = begin + (end - begin) / 2;
+            run(counter, [this, middle, end, grain, &function, &counter]() {
+                splitRange(middle, end, grain, function, counter);
+            });
+            end = middle;
+        }
+        function(begin, end);
+    }
+
+    bool pop(unsigned int index, Job& job) {
+        Queue& queue = *m_Queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            return false;
+        }
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned int index, Job& job) {
+        for (size_t i = 1; i < m_Queues.size(); ++i) {
+            Queue& victim = *m_Queues[(index + i) % m_Queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool runOne(unsigned int index) {
+        Job job;
+        bool stolen = false;
+        if (!pop(index, job)) {
+            if (!steal(index, job)) {
+                return false;
+            }
+            stolen = true;
+        }
+        m_Queued.fetch_sub(1);
+        job.function();
+        Queue& queue = *m_Queues[index];
+        queue.executed.store(queue.executed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        queue.stolen.store(queue.stolen.load(std::memory_order_relaxed) + stolen, std::memory_order_relaxed);
+        job.counter->fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    void work(unsigned int index) {
+        current() = ThreadSlot{this, index};
+        while (true) {
+            if (runOne(index)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_Sleeping.fetch_add(1);
+            m_Wake.wait(lock, [this]() { return m_Stop || m_Queued.load() > 0; });
+            m_Sleeping.fetch_sub(1);
+            if (m_Stop) {
+                return;
+            }
+        }
+    }
+};
+
+};
+#endif //PROJECT_BASE_JOBSYSTEM_H
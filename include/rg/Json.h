@@ -0,0 +1,365 @@
+#ifndef PROJECT_BASE_JSON_H
+#define PROJECT_BASE_JSON_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+// Parsed JSON value. Objects keep their members in file order; looking up a member that
+// doesn't exist (or indexing something that isn't an object or array) gives a null value, so
+// optional fields can be read with a default without checking first.
+class JsonValue {
+public:
+    enum Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type type() const {
+        return m_Type;
+    }
+
+    bool isNull() const { return m_Type == Null; }
+    bool isBool() const { return m_Type == Bool; }
+    bool isNumber() const { return m_Type == Number; }
+    bool isString() const { return m_Type == String; }
+    bool isArray() const { return m_Type == Array; }
+    bool isObject() const { return m_Type == Object; }
+
+    bool asBool(bool fallback = false) const {
+        return m_Type == Bool ? m_Number != 0.0 : fallback;
+    }
+
+    double asNumber(double fallback = 0.0) const {
+        return m_Type == Number ? m_Number : fallback;
+    }
+
+    const std::string& asString() const {
+        return m_String;
+    }
+
+    std::string asString(const std::string& fallback) const {
+        return m_Type == String ? m_String : fallback;
+    }
+
+    // elements of an array, members of an object
+    size_t size() const {
+        return m_Type == Array ? m_Elements.size() : (m_Type == Object ? m_Members.size() : 0);
+    }
+
+    const JsonValue& operator[](size_t index) const {
+        return m_Type == Array && index < m_Elements.size() ? m_Elements[index] : null();
+    }
+
+    // without it value[0] would be ambiguous between the index and a null key
+    const JsonValue& operator[](int index) const {
+        return index >= 0 ? (*this)[(size_t)index] : null();
+    }
+
+    const JsonValue& operator[](const char* key) const {
+        if (m_Type == Object) {
+            for (const auto& member : m_Members) {
+                if (member.first == key) {
+                    return member.second;
+                }
+            }
+        }
+        return null();
+    }
+
+    bool has(const char* key) const {
+        return !(*this)[key].isNull();
+    }
+
+    const std::vector<JsonValue>& elements() const {
+        return m_Elements;
+    }
+
+    const std::vector<std::pair<std::string, JsonValue>>& members() const {
+        return m_Members;
+    }
+
+    // Parses text, on failure returns false with the line and reason in error.
+    static bool parse(const char* begin, const char* end, JsonValue& value, std::string& error) {
+        Parser parser{begin, begin, end, std::string()};
+        value = JsonValue();
+        bool parsed = parser.value(value, 0);
+        if (parsed) {
+            parser.skipWhitespace();
+            parsed = parser.position == end || parser.fail("trailing characters");
+        }
+        if (!parsed) {
+            error = "line " + std::to_string(parser.line()) + ": " + parser.error;
+        }
+        return parsed;
+    }
+
+    static bool parse(const std::string& text, JsonValue& value, std::string& error) {
+        return parse(text.data(), text.data() + text.size(), value, error);
+    }
+
+private:
+    Type m_Type = Null;
+    double m_Number = 0.0;
+    std::string m_String;
+    std::vector<JsonValue> m_Elements;
+    std::vector<std::pair<std::string, JsonValue>> m_Members;
+
+    static const JsonValue& null() {
+        static const JsonValue value;
+        return value;
+    }
+
+    struct Parser {
+        const char* start;
+        const char* position;
+        const char* end;
+        std::string error;
+
+        static const int MaxDepth = 256;
+
+        bool fail(const char* reason) {
+            if (error.empty()) {
+                error = reason;
+            }
+            return false;
+        }
+
+        int line() const {
+            int result = 1;
+            for (const char* c = start; c < position && c < end; ++c) {
+                result += *c == '\n';
+            }
+            return result;
+        }
+
+        void skipWhitespace() {
+            while (position != end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r')) {
+                ++position;
+            }
+        }
+
+        bool literal(const char* text) {
+            size_t length = std::strlen(text);
+            if ((size_t)(end - position) < length || std::strncmp(position, text, length) != 0) {
+                return fail("invalid literal");
+            }
+            position += length;
+            return true;
+        }
+
+        bool value(JsonValue& result, int depth) {
+            if (depth > MaxDepth) {
+                return fail("nested too deeply");
+            }
+            skipWhitespace();
+            if (position == end) {
+                return fail("unexpected end of input");
+            }
+            switch (*position) {
+                case '{': return object(result, depth);
+                case '[': return array(result, depth);
+                case '"':
+                    result.m_Type = String;
+                    return string(result.m_String);
+                case 't':
+                    result.m_Type = Bool;
+                    result.m_Number = 1.0;
+                    return literal("true");
+                case 'f':
+                    result.m_Type = Bool;
+                    return literal("false");
+                case 'n':
+                    return literal("null");
+                default:
+                    return number(result);
+            }
+        }
+
+        bool object(JsonValue& result, int depth) {
+            result.m_Type = Object;
+            ++position;
+            skipWhitespace();
+            if (position != end && *position == '}') {
+                ++position;
+                return true;
+            }
+            while (true) {
+                skipWhitespace();
+                std::string key;
+                if (position == end || *position != '"') {
+                    return fail("expected a member name");
+                }
+                if (!string(key)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (position == end || *position != ':') {
+                    return fail("expected ':'");
+                }
+                ++position;
+                result.m_Members.emplace_back(std::move(key), JsonValue());
+                if (!value(result.m_Members.back().second, depth + 1)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (position != end && *position == ',') {
+                    ++position;
+                    continue;
+                }
+                if (position != end && *position == '}') {
+                    ++position;
+                    return true;
+                }
+                return fail("expected ',' or '}'");
+            }
+        }
+
+        bool array(JsonValue& result, int depth) {
+            result.m_Type = Array;
+            ++position;
+            skipWhitespace();
+            if (position != end && *position == ']') {
+                ++position;
+                return true;
+            }
+            while (true) {
+                result.m_Elements.emplace_back();
+                if (!value(result.m_Elements.back(), depth + 1)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (position != end && *position == ',') {
+                    ++position;
+                    continue;
+                }
+                if (position != end && *position == ']') {
+                    ++position;
+                    return true;
+                }
+                return fail("expected ',' or ']'");
+            }
+        }
+
+        bool number(JsonValue& result) {
+            const char* first = position;
+            while (position != end && (std::strchr("+-.eE", *position) || (*position >= '0' && *position <= '9'))) {
+                ++position;
+            }
+            if (position == first || position - first > 63) {
+                return fail("invalid value");
+            }
+            // strtod needs a terminated string and the input isn't one
+            char digits[64];
+            std::memcpy(digits, first, position - first);
+            digits[position - first] = '\0';
+            char* parsedEnd = nullptr;
+            result.m_Type = Number;
+            result.m_Number = std::strtod(digits, &parsedEnd);
+            if (parsedEnd != digits + (position - first)) {
+                return fail("invalid number");
+            }
+            return true;
+        }
+
+        static void appendUtf8(std::string& out, unsigned int codePoint) {
+            if (codePoint < 0x80) {
+                out += (char)codePoint;
+            } else if (codePoint < 0x800) {
+                out += (char)(0xC0 | (codePoint >> 6));
+                out += (char)(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x10000) {
+                out += (char)(0xE0 | (codePoint >> 12));
+                out += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                out += (char)(0x80 | (codePoint & 0x3F));
+            } else {
+                out += (char)(0xF0 | (codePoint >> 18));
+                out += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+                out += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                out += (char)(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        bool hex4(unsigned int& codePoint) {
+            if (end - position < 4) {
+                return fail("invalid \\u escape");
+            }
+            codePoint = 0;
+            for (int i = 0; i < 4; ++i) {
+                char c = *position++;
+                codePoint <<= 4;
+                if (c >= '0' && c <= '9') {
+                    codePoint |= c - '0';
+                } else if (c >= 'a' && c <= 'f') {
+                    codePoint |= c - 'a' + 10;
+                } else if (c >= 'A' && c <= 'F') {
+                    codePoint |= c - 'A' + 10;
+                } else {
+                    return fail("invalid \\u escape");
+                }
+            }
+            return true;
+        }
+
+        bool string(std::string& out) {
+            ++position;
+            while (position != end && *position != '"') {
+                char c = *position++;
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (position == end) {
+                    break;
+                }
+                c = *position++;
+                switch (c) {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        unsigned int codePoint;
+                        if (!hex4(codePoint)) {
+                            return false;
+                        }
+                        // surrogate pair
+                        if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - position >= 6 &&
+                            position[0] == '\\' && position[1] == 'u') {
+                            position += 2;
+                            unsigned int low;
+                            if (!hex4(low)) {
+                                return false;
+                            }
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(out, codePoint);
+                        break;
+                    }
+                    default:
+                        return fail("invalid escape");
+                }
+            }
+            if (position == end) {
+                return fail("unterminated string");
+            }
+            ++position;
+            return true;
+        }
+    };
+};
+
+};
+#endif //PROJECT_BASE_JSON_H
@@ -0,0 +1,156 @@
+#ifndef PROJECT_BASE_LZ_H
+#define PROJECT_BASE_LZ_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Byte oriented LZ77 compression in the LZ4 block format: every sequence is a token (literal
+// count and match length, 4 bits each), the literals, a 16-bit little endian offset and extra
+// length bytes where a count doesn't fit its 4 bits. The last sequence holds literals only.
+// Compression is a greedy single pass with a hash table of 4-byte prefixes, decompression is
+// a bounds checked copy loop, fast enough to run on every read of a packed file.
+namespace rg {
+namespace lz {
+
+const size_t MinMatch = 4;
+const size_t MaxOffset = 65535;
+const unsigned int HashBits = 16;
+
+inline size_t compressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HashBits);
+}
+
+inline unsigned char* writeLength(unsigned char* out, size_t length) {
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+// match == 0 writes the final literal-only sequence
+inline unsigned char* writeSequence(unsigned char* out, const unsigned char* literals, size_t literalCount,
+                                    size_t offset, size_t match) {
+    size_t matchCode = match ? match - MinMatch : 0;
+    unsigned char* token = out++;
+    *token = (unsigned char)((literalCount < 15 ? literalCount : 15) << 4 | (matchCode < 15 ? matchCode : 15));
+    if (literalCount >= 15) {
+        out = writeLength(out, literalCount - 15);
+    }
+    std::memcpy(out, literals, literalCount);
+    out += literalCount;
+    if (match) {
+        *out++ = (unsigned char)(offset & 0xFF);
+        *out++ = (unsigned char)(offset >> 8);
+        if (matchCode >= 15) {
+            out = writeLength(out, matchCode - 15);
+        }
+    }
+    return out;
+}
+
+// Compresses size bytes into out, which needs compressBound(size) bytes. Returns the compressed size.
+inline size_t compress(const unsigned char* source, size_t size, unsigned char* out) {
+    std::vector<uint32_t> table((size_t)1 << HashBits, UINT32_MAX);
+    unsigned char* start = out;
+    size_t anchor = 0;
+    size_t position = 0;
+    size_t misses = 0;
+    while (position + MinMatch <= size) {
+        uint32_t sequence = read32(source + position);
+        uint32_t& slot = table[hash(sequence)];
+        size_t candidate = slot;
+        slot = (uint32_t)position;
+        if (candidate == UINT32_MAX || position - candidate > MaxOffset || read32(source + candidate) != sequence) {
+            // skip faster through data that doesn't compress
+            position += 1 + (misses++ >> 6);
+            continue;
+        }
+        misses = 0;
+        size_t length = MinMatch;
+        while (position + length < size && source[candidate + length] == source[position + length]) {
+            ++length;
+        }
+        out = writeSequence(out, source + anchor, position - anchor, position - candidate, length);
+        position += length;
+        anchor = position;
+    }
+    out = writeSequence(out, source + anchor, size - anchor, 0, 0);
+    return out - start;
+}
+
+inline bool readLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (in == end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Decompresses into out, which has to be exactly the original size. Returns false on corrupt input.
+inline bool decompress(const unsigned char* in, size_t size, unsigned char* out, size_t outSize) {
+    const unsigned char* end = in + size;
+    unsigned char* begin = out;
+    unsigned char* outEnd = out + outSize;
+    while (in < end) {
+        unsigned int token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(in, end, literals)) {
+            return false;
+        }
+        if (literals > (size_t)(end - in) || literals > (size_t)(outEnd - out)) {
+            return false;
+        }
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == end) {
+            break;
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        size_t offset = in[0] | (size_t)in[1] << 8;
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(in, end, length)) {
+            return false;
+        }
+        length += MinMatch;
+        if (offset == 0 || offset > (size_t)(out - begin) || length > (size_t)(outEnd - out)) {
+            return false;
+        }
+        const unsigned char* match = out - offset;
+        if (offset >= length) {
+            std::memcpy(out, match, length);
+            out += length;
+        } else {
+            // overlapping match, repeats the last offset bytes
+            for (size_t i = 0; i < length; ++i) {
+                *out++ = match[i];
+            }
+        }
+    }
+    return out == outEnd;
+}
+
+};
+};
+#endif //PROJECT_BASE_LZ_H
@@ -0,0 +1,163 @@
+#ifndef PROJECT_BASE_MIPCHAIN_H
+#define PROJECT_BASE_MIPCHAIN_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace rg {
+
+struct MipLevel {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels; // tightly packed rows
+};
+
+// Builds full mip chains on the CPU so textures don't need glGenerateMipmap on the driver thread.
+//
+// Levels are made with a 2x2 box filter (odd dimensions repeat their last row/column). Color
+// textures marked as sRGB are filtered in linear space and encoded back, alpha always stays linear.
+// The linear RGBA path is vectorized with SSE2.
+class MipChain {
+public:
+    static std::vector<MipLevel> generate(const unsigned char* pixels, int width, int height, int components,
+                                          bool srgb) {
+        std::vector<MipLevel> levels(1);
+        levels[0].width = width;
+        levels[0].height = height;
+        levels[0].pixels.assign(pixels, pixels + (size_t)width * height * components);
+
+        while (levels.back().width > 1 || levels.back().height > 1) {
+            const MipLevel& source = levels.back();
+            MipLevel next;
+            next.width = std::max(source.width / 2, 1);
+            next.height = std::max(source.height / 2, 1);
+            next.pixels.resize((size_t)next.width * next.height * components);
+            if (srgb && components >= 3) {
+                downsampleSrgb(source, components, next);
+            } else {
+                downsampleLinear(source, components, next);
+            }
+            levels.push_back(std::move(next));
+        }
+        return levels;
+    }
+
+    static GLenum format(int components) {
+        switch (components) {
+            case 1: return GL_RED;
+            case 2: return GL_RG;
+            case 3: return GL_RGB;
+        }
+        return GL_RGBA;
+    }
+
+    // Uploads every level into the texture bound to GL_TEXTURE_2D.
+    static void upload(const std::vector<MipLevel>& levels, int components) {
+        GLenum pixelFormat = format(components);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (size_t level = 0; level < levels.size(); ++level) {
+            glTexImage2D(GL_TEXTURE_2D, level, pixelFormat, levels[level].width, levels[level].height, 0,
+                         pixelFormat, GL_UNSIGNED_BYTE, levels[level].pixels.data());
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+    }
+
+private:
+    static void downsampleLinear(const MipLevel& source, int components, MipLevel& next) {
+        for (int y = 0; y < next.height; ++y) {
+            const unsigned char* row0 = source.pixels.data() + (size_t)std::min(y * 2, source.height - 1) * source.width * components;
+            const unsigned char* row1 = source.pixels.data() + (size_t)std::min(y * 2 + 1, source.height - 1) * source.width * components;
+            unsigned char* out = next.pixels.data() + (size_t)y * next.width * components;
+
+            int x = 0;
+#ifdef __SSE2__
+            // four source pixels from each row become two output pixels
+            if (components == 4) {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i rounding = _mm_set1_epi16(2);
+                for (; x * 2 + 3 < source.width; x += 2) {
+                    __m128i top = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+                    __m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+                    __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                    __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+                    low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+                    high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+                    __m128i sum = _mm_unpacklo_epi64(low, high);
+                    sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+                    _mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(sum, zero));
+                }
+            }
+#endif
+            for (; x < next.width; ++x) {
+                int x0 = std::min(x * 2, source.width - 1) * components;
+                int x1 = std::min(x * 2 + 1, source.width - 1) * components;
+                for (int c = 0; c < components; ++c) {
+                    int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                    out[x * components + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    // built once on first use, function-local statics are initialized thread safely
+    static const float* srgbToLinearTable() {
+        static const std::array<float, 256> table = []() {
+            std::array<float, 256> table;
+            for (int i = 0; i < 256; ++i) {
+                float value = i / 255.0f;
+                table[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+            return table;
+        }();
+        return table.data();
+    }
+
+    static const unsigned char* linearToSrgbTable() {
+        static const std::array<unsigned char, 4096> table = []() {
+            std::array<unsigned char, 4096> table;
+            for (int i = 0; i < 4096; ++i) {
+                float value = i / 4095.0f;
+                value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+                table[i] = (unsigned char)std::min(std::max(value * 255.0f + 0.5f, 0.0f), 255.0f);
+            }
+            return table;
+        }();
+        return table.data();
+    }
+
+    static void downsampleSrgb(const MipLevel& source, int components, MipLevel& next) {
+        const float* toLinear = srgbToLinearTable();
+        const unsigned char* toSrgb = linearToSrgbTable();
+
+        for (int y = 0; y < next.height; ++y) {
+            const unsigned char* row0 = source.pixels.data() + (size_t)std::min(y * 2, source.height - 1) * source.width * components;
+            const unsigned char* row1 = source.pixels.data() + (size_t)std::min(y * 2 + 1, source.height - 1) * source.width * components;
+            unsigned char* out = next.pixels.data() + (size_t)y * next.width * components;
+
+            for (int x = 0; x < next.width; ++x) {
+                int x0 = std::min(x * 2, source.width - 1) * components;
+                int x1 = std::min(x * 2 + 1, source.width - 1) * components;
+                for (int c = 0; c < 3; ++c) {
+                    float sum = toLinear[row0[x0 + c]] + toLinear[row0[x1 + c]] +
+                                toLinear[row1[x0 + c]] + toLinear[row1[x1 + c]];
+                    out[x * components + c] = toSrgb[(int)(sum * 0.25f * 4095.0f + 0.5f)];
+                }
+                if (components == 4) {
+                    int sum = row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3];
+                    out[x * components + 3] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+    }
+};
+
+};
+#endif //PROJECT_BASE_MIPCHAIN_H
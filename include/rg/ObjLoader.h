@@ -0,0 +1,678 @@
+#ifndef PROJECT_BASE_OBJLOADER_H
+#define PROJECT_BASE_OBJLOADER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <rg/Parallel.h>
+#include <rg/Vfs.h>
+
+namespace rg {
+
+// Texture file names of one MTL material, relative to the model directory. Empty if unused.
+struct ObjMaterial {
+    std::string diffuse;  // map_Kd
+    std::string specular; // map_Ks
+    std::string normal;   // map_Bump / bump, what Assimp reports as aiTextureType_HEIGHT
+    std::string height;   // map_Ka, what Assimp reports as aiTextureType_AMBIENT
+};
+
+struct ObjMesh {
+    std::string material;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+struct ObjScene {
+    std::vector<ObjMesh> meshes;
+    std::map<std::string, ObjMaterial> materials;
+};
+
+// Wavefront OBJ/MTL loader producing the same vertex data as Assimp with
+// aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace.
+//
+// The file is mapped (or read from a pack, see Vfs) and split at line boundaries into chunks
+// that are parsed on separate threads. Negative (relative) indices are resolved once the element
+// counts of the preceding chunks are known and usemtl state carries over from one chunk to the
+// next. Faces are grouped into one mesh per material, each mesh deduplicates its (position, uv,
+// normal) corners and is built on its own thread as well.
+class ObjLoader {
+public:
+    static bool handles(const std::string& path) {
+        if (path.size() < 4) {
+            return false;
+        }
+        std::string extension = path.substr(path.size() - 4);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        return extension == ".obj";
+    }
+
+    static bool load(const std::string& path, ObjScene& scene,
+                     unsigned int threads = hardwareThreads()) {
+        VfsFile file = Vfs::instance().open(path);
+        if (!file.isOpen()) {
+            std::cout << "ERROR::OBJ:: could not open " << path << std::endl;
+            return false;
+        }
+        const char* begin = (const char*)file.data();
+        const char* end = begin + file.size();
+
+        std::vector<Chunk> chunks(chunkCount(file.size(), threads));
+        splitChunks(begin, end, chunks);
+        parallelFor(chunks.size(), [&](size_t i) {
+            parseChunk(chunks[i], end);
+        }, threads);
+
+        Elements elements;
+        std::vector<Group> groups;
+        std::vector<std::string> libraries;
+        if (!mergeChunks(chunks, elements, groups, libraries)) {
+            std::cout << "ERROR::OBJ:: face index out of range in " << path << std::endl;
+            return false;
+        }
+        chunks.clear();
+
+        std::string directory = path.substr(0, path.find_last_of('/'));
+        for (const std::string& library : libraries) {
+            if (!loadMaterials(directory + '/' + library, scene.materials)) {
+                // same fallback as Assimp: a library next to the obj with the same base name
+                std::string fallback = path.substr(0, path.size() - 3) + "mtl";
+                std::cout << "OBJ: unable to open material library " << library << ", trying " << fallback << std::endl;
+                loadMaterials(fallback, scene.materials);
+            }
+        }
+
+        scene.meshes.resize(groups.size());
+        parallelFor(groups.size(), [&](size_t i) {
+            buildMesh(elements, groups[i], scene.meshes[i]);
+        }, threads);
+        return true;
+    }
+
+private:
+    // raw face corner, see parseIndex for the encoding
+    struct Corner {
+        int position;
+        int texCoord;
+        int normal;
+    };
+
+    struct Chunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        std::vector<float> positions;
+        std::vector<float> texCoords;
+        std::vector<float> normals;
+        std::vector<Corner> corners;
+        std::vector<unsigned int> faceSizes;
+        // face index at which a usemtl switched the material
+        std::vector<std::pair<size_t, std::string>> materials;
+        std::vector<std::string> libraries;
+        bool error = false;
+    };
+
+    struct Elements {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texCoords;
+        std::vector<glm::vec3> normals;
+    };
+
+    // all triangles using one material, corners resolved to absolute indices
+    struct Group {
+        std::string material;
+        std::vector<Corner> corners;
+    };
+
+    static const size_t MinChunkSize = 256 * 1024;
+
+    static size_t chunkCount(size_t size, unsigned int threads) {
+        return std::max<size_t>(std::min<size_t>(threads, size / MinChunkSize), 1);
+    }
+
+    static void splitChunks(const char* begin, const char* end, std::vector<Chunk>& chunks) {
+        size_t step = (end - begin) / chunks.size();
+        const char* position = begin;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            chunks[i].begin = position;
+            const char* split = i + 1 == chunks.size() ? end : std::max(position, begin + step * (i + 1));
+            if (split < end) {
+                const char* newline = (const char*)std::memchr(split, '\n', end - split);
+                split = newline ? newline + 1 : end;
+            }
+            chunks[i].end = split;
+            position = split;
+        }
+    }
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && isSpace(*p)) {
+            ++p;
+        }
+        return p;
+    }
+
+    // the line after the keyword, without surrounding whitespace (names may contain spaces)
+    static std::string restOfLine(const char* p, const char* end) {
+        p = skipSpaces(p, end);
+        while (end > p && isSpace(end[-1])) {
+            --end;
+        }
+        return std::string(p, end);
+    }
+
+    // Number of leading ASCII digits in the 8 bytes at p and their value, found without a branch per digit.
+    static unsigned int parseEightDigits(const char* p, uint64_t& value) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        // a byte is a digit if its high nibble is 3 and adding 6 doesn't carry out of the low nibble
+        uint64_t mismatch = ((word & 0xF0F0F0F0F0F0F0F0ull) ^ 0x3030303030303030ull) |
+                            (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) ^ 0x3030303030303030ull);
+        unsigned int digits = mismatch ? __builtin_ctzll(mismatch) / 8 : 8;
+        if (digits == 0) {
+            return 0;
+        }
+        // move the digits to the top and pad with leading '0's
+        if (digits < 8) {
+            word = (word << (8 - digits) * 8) | (0x3030303030303030ull >> digits * 8);
+        }
+        word -= 0x3030303030303030ull;
+        word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFull;
+        word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFull;
+        value = (word * 10000 + (word >> 32)) & 0xFFFFFFFFull;
+        return digits;
+    }
+
+    // Appends a run of digits to mantissa, returns the number of digits read. Digits that don't fit
+    // the mantissa any more are counted in dropped.
+    static unsigned int parseDigits(const char*& p, const char* end, uint64_t& mantissa, unsigned int& significant,
+                                    unsigned int& dropped) {
+        static const uint64_t powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+        unsigned int total = 0;
+        while (true) {
+            unsigned int digits = 0;
+            uint64_t value = 0;
+            if (end - p >= 8) {
+                digits = parseEightDigits(p, value);
+            } else {
+                while (digits < (unsigned int)(end - p) && p[digits] >= '0' && p[digits] <= '9') {
+                    value = value * 10 + (p[digits] - '0');
+                    ++digits;
+                }
+            }
+            if (digits == 0) {
+                return total;
+            }
+            if (significant + digits <= 18) {
+                mantissa = mantissa * powers[digits] + value;
+                if (mantissa != 0) {
+                    significant += digits;
+                }
+            } else {
+                dropped += digits;
+            }
+            p += digits;
+            total += digits;
+            if (digits < 8) {
+                return total;
+            }
+        }
+    }
+
+    static const char* parseFloat(const char* p, const char* end, float& out) {
+        p = skipSpaces(p, end);
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            ++p;
+        }
+        uint64_t mantissa = 0;
+        unsigned int significant = 0;
+        unsigned int dropped = 0;
+        unsigned int digits = parseDigits(p, end, mantissa, significant, dropped);
+        int exponent = (int)dropped;
+        if (p < end && *p == '.') {
+            ++p;
+            dropped = 0;
+            unsigned int fraction = parseDigits(p, end, mantissa, significant, dropped);
+            exponent -= (int)(fraction - dropped);
+            digits += fraction;
+        }
+        if (digits == 0) {
+            out = 0.0f;
+            return p;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char* q = p + 1;
+            bool negativeExponent = false;
+            if (q < end && (*q == '-' || *q == '+')) {
+                negativeExponent = *q == '-';
+                ++q;
+            }
+            int value = 0;
+            bool any = false;
+            while (q < end && *q >= '0' && *q <= '9') {
+                value = std::min(value * 10 + (*q - '0'), 1000);
+                any = true;
+                ++q;
+            }
+            if (any) {
+                exponent += negativeExponent ? -value : value;
+                p = q;
+            }
+        }
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        double value = (double)mantissa;
+        if (exponent < 0) {
+            value = exponent >= -22 ? value / powers[-exponent] : value * std::pow(10.0, exponent);
+        } else if (exponent > 0) {
+            value = exponent <= 22 ? value * powers[exponent] : value * std::pow(10.0, exponent);
+        }
+        out = (float)(negative ? -value : value);
+        return p;
+    }
+
+    // Positive indices become 0-based absolute ones and -1 marks a missing index. Negative indices
+    // count back from the elements parsed so far, of which a chunk only knows its own: they are
+    // stored as the (possibly negative) chunk local index minus RelativeBias and resolved in mergeChunks.
+    static const int RelativeBias = 1 << 30;
+
+    static const char* parseIndex(const char* p, const char* end, size_t localCount, int& out, bool& error) {
+        bool negative = false;
+        if (p < end && *p == '-') {
+            negative = true;
+            ++p;
+        }
+        long value = 0;
+        const char* start = p;
+        while (p < end && *p >= '0' && *p <= '9' && value < RelativeBias) {
+            value = value * 10 + (*p - '0');
+            ++p;
+        }
+        if (p == start) {
+            out = -1;
+        } else if (negative) {
+            out = (int)((long)localCount - value) - RelativeBias;
+        } else {
+            error |= value == 0 || value >= RelativeBias;
+            out = (int)value - 1;
+        }
+        return p;
+    }
+
+    static void parseFace(const char* p, const char* end, Chunk& chunk) {
+        unsigned int size = 0;
+        while (true) {
+            p = skipSpaces(p, end);
+            if (p == end) {
+                break;
+            }
+            Corner corner;
+            p = parseIndex(p, end, chunk.positions.size() / 3, corner.position, chunk.error);
+            corner.texCoord = -1;
+            corner.normal = -1;
+            if (p < end && *p == '/') {
+                p = parseIndex(p + 1, end, chunk.texCoords.size() / 2, corner.texCoord, chunk.error);
+                if (p < end && *p == '/') {
+                    p = parseIndex(p + 1, end, chunk.normals.size() / 3, corner.normal, chunk.error);
+                }
+            }
+            if (corner.position == -1) {
+                break;
+            }
+            chunk.corners.push_back(corner);
+            ++size;
+            while (p < end && !isSpace(*p)) {
+                ++p;
+            }
+        }
+        if (size >= 3) {
+            chunk.faceSizes.push_back(size);
+        } else {
+            // points and lines are dropped, like aiProcess_Triangulate leaves them out of triangle meshes
+            chunk.corners.resize(chunk.corners.size() - size);
+        }
+    }
+
+    static void parseChunk(Chunk& chunk, const char* fileEnd) {
+        // the counts of a chunk are roughly proportional to its share of the file
+        size_t reserve = (chunk.end - chunk.begin) / 32;
+        chunk.positions.reserve(reserve);
+        chunk.corners.reserve(reserve / 2);
+
+        const char* line = chunk.begin;
+        while (line < chunk.end) {
+            const char* newline = (const char*)std::memchr(line, '\n', chunk.end - line);
+            const char* end = newline ? newline : chunk.end;
+            const char* p = skipSpaces(line, end);
+            line = end + 1;
+            if (end - p < 2) {
+                continue;
+            }
+
+            float x, y, z;
+            if (p[0] == 'v' && isSpace(p[1])) {
+                p = parseFloat(p + 2, fileEnd, x);
+                p = parseFloat(p, fileEnd, y);
+                parseFloat(p, fileEnd, z);
+                chunk.positions.insert(chunk.positions.end(), {x, y, z});
+            } else if (p[0] == 'v' && p[1] == 't') {
+                p = parseFloat(p + 2, fileEnd, x);
+                y = 0.0f;
+                if (skipSpaces(p, end) < end) {
+                    parseFloat(p, fileEnd, y);
+                }
+                chunk.texCoords.insert(chunk.texCoords.end(), {x, y});
+            } else if (p[0] == 'v' && p[1] == 'n') {
+                p = parseFloat(p + 2, fileEnd, x);
+                p = parseFloat(p, fileEnd, y);
+                parseFloat(p, fileEnd, z);
+                chunk.normals.insert(chunk.normals.end(), {x, y, z});
+            } else if (p[0] == 'f' && isSpace(p[1])) {
+                parseFace(p + 2, end, chunk);
+            } else if (end - p > 6 && std::strncmp(p, "usemtl", 6) == 0 && isSpace(p[6])) {
+                chunk.materials.emplace_back(chunk.faceSizes.size(), restOfLine(p + 6, end));
+            } else if (end - p > 6 && std::strncmp(p, "mtllib", 6) == 0 && isSpace(p[6])) {
+                chunk.libraries.push_back(restOfLine(p + 6, end));
+            }
+        }
+    }
+
+    static bool resolve(int& index, size_t base, size_t count) {
+        if (index < -1) {
+            index = (int)base + (index + RelativeBias);
+            return index >= 0 && index < (int)count;
+        }
+        return index < (int)count;
+    }
+
+    static bool mergeChunks(std::vector<Chunk>& chunks, Elements& elements, std::vector<Group>& groups,
+                            std::vector<std::string>& libraries) {
+        size_t positions = 0, texCoords = 0, normals = 0;
+        for (const Chunk& chunk : chunks) {
+            if (chunk.error) {
+                return false;
+            }
+            positions += chunk.positions.size() / 3;
+            texCoords += chunk.texCoords.size() / 2;
+            normals += chunk.normals.size() / 3;
+        }
+        elements.positions.resize(positions);
+        elements.texCoords.resize(texCoords);
+        elements.normals.resize(normals);
+
+        std::map<std::string, size_t> groupByMaterial;
+        std::string material;
+        size_t positionBase = 0, texCoordBase = 0, normalBase = 0;
+        for (Chunk& chunk : chunks) {
+            std::memcpy((void*)(elements.positions.data() + positionBase), chunk.positions.data(), chunk.positions.size() * sizeof(float));
+            std::memcpy((void*)(elements.texCoords.data() + texCoordBase), chunk.texCoords.data(), chunk.texCoords.size() * sizeof(float));
+            std::memcpy((void*)(elements.normals.data() + normalBase), chunk.normals.data(), chunk.normals.size() * sizeof(float));
+            libraries.insert(libraries.end(), chunk.libraries.begin(), chunk.libraries.end());
+
+            size_t nextSwitch = 0;
+            Group* group = nullptr;
+            std::vector<Corner> resolved;
+            const Corner* corners = chunk.corners.data();
+            for (size_t face = 0; face < chunk.faceSizes.size(); ++face) {
+                while (nextSwitch < chunk.materials.size() && chunk.materials[nextSwitch].first == face) {
+                    material = chunk.materials[nextSwitch++].second;
+                    group = nullptr;
+                }
+                if (!group) {
+                    auto it = groupByMaterial.find(material);
+                    if (it == groupByMaterial.end()) {
+                        it = groupByMaterial.emplace(material, groups.size()).first;
+                        groups.emplace_back();
+                        groups.back().material = material;
+                    }
+                    group = &groups[it->second];
+                }
+
+                unsigned int size = chunk.faceSizes[face];
+                resolved.assign(corners, corners + size);
+                corners += size;
+                for (Corner& corner : resolved) {
+                    if (!resolve(corner.position, positionBase, positions) ||
+                        !resolve(corner.texCoord, texCoordBase, texCoords) ||
+                        !resolve(corner.normal, normalBase, normals)) {
+                        return false;
+                    }
+                }
+                // fan triangulation, fine for the convex polygons exporters write
+                for (unsigned int i = 1; i + 1 < size; ++i) {
+                    group->corners.insert(group->corners.end(), {resolved[0], resolved[i], resolved[i + 1]});
+                }
+            }
+            // a usemtl after the last face of the chunk still applies to the next one
+            while (nextSwitch < chunk.materials.size()) {
+                material = chunk.materials[nextSwitch++].second;
+            }
+
+            positionBase += chunk.positions.size() / 3;
+            texCoordBase += chunk.texCoords.size() / 2;
+            normalBase += chunk.normals.size() / 3;
+            std::vector<float>().swap(chunk.positions);
+            std::vector<float>().swap(chunk.texCoords);
+            std::vector<float>().swap(chunk.normals);
+        }
+        return true;
+    }
+
+    struct CornerHash {
+        size_t operator()(const Corner& corner) const {
+            uint64_t key = (uint64_t)(uint32_t)corner.position * 0x9E3779B97F4A7C15ull;
+            key ^= (uint64_t)(uint32_t)corner.texCoord * 0xC2B2AE3D27D4EB4Full;
+            key ^= (uint64_t)(uint32_t)corner.normal * 0x165667B19E3779F9ull;
+            return (size_t)(key ^ (key >> 32));
+        }
+    };
+
+    struct CornerEqual {
+        bool operator()(const Corner& a, const Corner& b) const {
+            return a.position == b.position && a.texCoord == b.texCoord && a.normal == b.normal;
+        }
+    };
+
+    static void buildMesh(const Elements& elements, const Group& group, ObjMesh& mesh) {
+        mesh.material = group.material;
+        mesh.indices.reserve(group.corners.size());
+
+        bool hasNormals = true;
+        bool hasTexCoords = true;
+        std::unordered_map<Corner, unsigned int, CornerHash, CornerEqual> unique;
+        unique.reserve(group.corners.size());
+        std::vector<int> positionOf;
+        for (const Corner& corner : group.corners) {
+            auto inserted = unique.emplace(corner, (unsigned int)mesh.vertices.size());
+            if (inserted.second) {
+                Vertex vertex{};
+                vertex.Position = elements.positions[corner.position];
+                if (corner.normal >= 0) {
+                    vertex.Normal = elements.normals[corner.normal];
+                } else {
+                    hasNormals = false;
+                }
+                if (corner.texCoord >= 0) {
+                    const glm::vec2& texCoord = elements.texCoords[corner.texCoord];
+                    vertex.TexCoords = glm::vec2(texCoord.x, 1.0f - texCoord.y);
+                } else {
+                    hasTexCoords = false;
+                }
+                mesh.vertices.push_back(vertex);
+                positionOf.push_back(corner.position);
+            }
+            mesh.indices.push_back(inserted.first->second);
+        }
+
+        if (!hasNormals) {
+            generateNormals(mesh, positionOf);
+        }
+        if (hasTexCoords) {
+            generateTangents(mesh);
+        } else {
+            for (Vertex& vertex : mesh.vertices) {
+                vertex.TexCoords = glm::vec2(0.0f);
+            }
+        }
+    }
+
+    // smooth normals averaged over every face sharing a position, as aiProcess_GenSmoothNormals does
+    static void generateNormals(ObjMesh& mesh, const std::vector<int>& positionOf) {
+        std::unordered_map<int, glm::vec3> sums;
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            const glm::vec3& a = mesh.vertices[mesh.indices[i]].Position;
+            const glm::vec3& b = mesh.vertices[mesh.indices[i + 1]].Position;
+            const glm::vec3& c = mesh.vertices[mesh.indices[i + 2]].Position;
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            for (size_t j = 0; j < 3; ++j) {
+                sums[positionOf[mesh.indices[i + j]]] += normal;
+            }
+        }
+        for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+            glm::vec3 sum = sums[positionOf[i]];
+            float length = glm::length(sum);
+            mesh.vertices[i].Normal = length > 0.0f ? sum / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    }
+
+    // per-vertex tangent frame from the UV gradients, made orthogonal to the normal
+    static void generateTangents(ObjMesh& mesh) {
+        std::vector<glm::vec3> tangents(mesh.vertices.size(), glm::vec3(0.0f));
+        std::vector<glm::vec3> bitangents(mesh.vertices.size(), glm::vec3(0.0f));
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            const Vertex& a = mesh.vertices[mesh.indices[i]];
+            const Vertex& b = mesh.vertices[mesh.indices[i + 1]];
+            const Vertex& c = mesh.vertices[mesh.indices[i + 2]];
+            glm::vec3 edge1 = b.Position - a.Position;
+            glm::vec3 edge2 = c.Position - a.Position;
+            glm::vec2 delta1 = b.TexCoords - a.TexCoords;
+            glm::vec2 delta2 = c.TexCoords - a.TexCoords;
+            float determinant = delta1.x * delta2.y - delta2.x * delta1.y;
+            if (std::fabs(determinant) < 1e-12f) {
+                continue;
+            }
+            float inverse = 1.0f / determinant;
+            glm::vec3 tangent = (edge1 * delta2.y - edge2 * delta1.y) * inverse;
+            glm::vec3 bitangent = (edge2 * delta1.x - edge1 * delta2.x) * inverse;
+            for (size_t j = 0; j < 3; ++j) {
+                tangents[mesh.indices[i + j]] += tangent;
+                bitangents[mesh.indices[i + j]] += bitangent;
+            }
+        }
+        for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+            Vertex& vertex = mesh.vertices[i];
+            vertex.Tangent = orthonormalize(tangents[i], vertex.Normal);
+            vertex.Bitangent = orthonormalize(bitangents[i], vertex.Normal);
+        }
+    }
+
+    static glm::vec3 orthonormalize(const glm::vec3& v, const glm::vec3& normal) {
+        glm::vec3 projected = v - normal * glm::dot(v, normal);
+        float length = glm::length(projected);
+        return length > 0.0f ? projected / length : glm::vec3(0.0f);
+    }
+
+    static bool startsWith(const std::string& line, size_t position, const char* keyword) {
+        size_t length = std::strlen(keyword);
+        if (line.size() < position + length || (line.size() > position + length && !isSpace(line[position + length]))) {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            if (std::tolower(line[position + i]) != std::tolower(keyword[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static const char* tokenEnd(const char* p, const char* end) {
+        while (p < end && !isSpace(*p)) {
+            ++p;
+        }
+        return p;
+    }
+
+    static bool isNumber(const char* begin, const char* end) {
+        std::string token(begin, end);
+        char* parsed = nullptr;
+        std::strtod(token.c_str(), &parsed);
+        return !token.empty() && *parsed == '\0';
+    }
+
+    // "map_Kd -bm 1.0 -o 0 0 0 my file.png" -> "my file.png"
+    static std::string textureFile(const char* p, const char* end) {
+        p = skipSpaces(p, end);
+        while (p < end && *p == '-' && !isNumber(p, tokenEnd(p, end))) {
+            // options take one argument (-bm 1, -clamp on) or up to three numbers (-o u v w)
+            p = skipSpaces(tokenEnd(p, end), end);
+            p = skipSpaces(tokenEnd(p, end), end);
+            while (p < end && isNumber(p, tokenEnd(p, end))) {
+                p = skipSpaces(tokenEnd(p, end), end);
+            }
+        }
+        return restOfLine(p, end);
+    }
+
+    static bool loadMaterials(const std::string& path, std::map<std::string, ObjMaterial>& materials) {
+        VfsFile file = Vfs::instance().open(path);
+        if (!file.isOpen()) {
+            return false;
+        }
+        ObjMaterial* material = nullptr;
+        for (const char* next = file.begin(); next < file.end();) {
+            const char* newline = (const char*)std::memchr(next, '\n', file.end() - next);
+            std::string line(next, newline ? newline : file.end());
+            next = newline ? newline + 1 : file.end();
+            const char* end = line.c_str() + line.size();
+            size_t start = skipSpaces(line.c_str(), end) - line.c_str();
+            std::string* target = nullptr;
+            size_t keyword = 0;
+            if (startsWith(line, start, "newmtl")) {
+                material = &materials[restOfLine(line.c_str() + start + 6, end)];
+                continue;
+            } else if (!material) {
+                continue;
+            } else if (startsWith(line, start, "map_Kd")) {
+                target = &material->diffuse;
+                keyword = 6;
+            } else if (startsWith(line, start, "map_Ks")) {
+                target = &material->specular;
+                keyword = 6;
+            } else if (startsWith(line, start, "map_Bump")) {
+                target = &material->normal;
+                keyword = 8;
+            } else if (startsWith(line, start, "bump")) {
+                target = &material->normal;
+                keyword = 4;
+            } else if (startsWith(line, start, "map_Ka")) {
+                target = &material->height;
+                keyword = 6;
+            }
+            if (target) {
+                // a repeated map statement replaces the previous one
+                *target = textureFile(line.c_str() + start + keyword, end);
+            }
+        }
+        return true;
+    }
+};
+
+};
+#endif //PROJECT_BASE_OBJLOADER_H
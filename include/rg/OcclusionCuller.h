@@ -0,0 +1,193 @@
+#ifndef PROJECT_BASE_OCCLUSIONCULLER_H
+#define PROJECT_BASE_OCCLUSIONCULLER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include <cstdint>
+#include <vector>
+#include <rg/Bounds.h>
+#include <rg/Error.h>
+
+namespace rg {
+
+// Hardware occlusion culling with GL_ANY_SAMPLES_PASSED queries on instance bounding boxes.
+//
+// An instance's own depth always lies behind the front faces of its box, so a box can only be
+// tested before the instance is drawn. A frame therefore has two halves:
+//   1. instances that passed their last query are drawn directly, which fills in most of the
+//      depth buffer;
+//   2. the others (occluded last time, never tested, or due for a re-test) get their box drawn
+//      with color and depth writes off inside a query, and are then drawn inside
+//      glBeginConditionalRender on that query.
+// The GPU decides whether the conditional draws run, so an instance that comes out from behind
+// the table is drawn in the same frame and nothing waits on the CPU. The query results are read
+// back a frame later, without waiting for the ones that aren't available yet, and decide which
+// half the instance goes to next. Visible instances are re-tested every RetestInterval frames
+// (staggered by id) to notice when they become occluded.
+class OcclusionCuller {
+public:
+    static const unsigned int RetestInterval = 8;
+
+    struct Stats {
+        // box queries issued this frame
+        unsigned int queries = 0;
+        // results read back this frame that found the instance occluded, i.e. draws the GPU skipped
+        unsigned int occluded = 0;
+        // conditional draws that reused a query still in flight from an earlier frame
+        unsigned int lateQueries = 0;
+    };
+
+    OcclusionCuller() {
+        // unit cube, mapped onto the box in the vertex shader
+        static const float corners[] = {
+                0, 0, 0,  1, 0, 0,  0, 1, 0,  1, 1, 0,
+                0, 0, 1,  1, 0, 1,  0, 1, 1,  1, 1, 1,
+        };
+        static const GLubyte indices[] = {
+                0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,
+                0, 1, 4, 1, 5, 4,  2, 6, 3, 3, 6, 7,
+                0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5,
+        };
+        glGenVertexArrays(1, &m_VAO);
+        glGenBuffers(1, &m_VBO);
+        glGenBuffers(1, &m_EBO);
+        glBindVertexArray(m_VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindVertexArray(0);
+    }
+
+    ~OcclusionCuller() {
+        release();
+    }
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // Deletes the queries and the cube, has to run while the context still exists (the destructor
+    // calls it too).
+    void release() {
+        if (!m_VAO) {
+            return;
+        }
+        if (!m_Queries.empty()) {
+            glDeleteQueries((GLsizei)m_Queries.size(), m_Queries.data());
+        }
+        glDeleteVertexArrays(1, &m_VAO);
+        glDeleteBuffers(1, &m_VBO);
+        glDeleteBuffers(1, &m_EBO);
+        m_Queries.clear();
+        m_VAO = m_VBO = m_EBO = 0;
+    }
+
+    // One query per instance; instances start out visible so the first frames look as without
+    // occlusion culling while the first results come in.
+    void resize(size_t instances) {
+        size_t previous = m_Queries.size();
+        if (instances > previous) {
+            m_Queries.resize(instances);
+            glGenQueries((GLsizei)(instances - previous), m_Queries.data() + previous);
+            m_Visible.resize(instances, 1);
+            m_Pending.resize(instances, 0);
+        }
+    }
+
+    // Reads back the results that are available and starts a new frame. Call once per frame
+    // before drawDirectly().
+    void collect() {
+        m_Frame++;
+        m_Stats = Stats();
+        size_t kept = 0;
+        for (uint32_t instance : m_PendingInstances) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(m_Queries[instance], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                m_PendingInstances[kept++] = instance;
+                continue;
+            }
+            GLuint passed = 0;
+            glGetQueryObjectuiv(m_Queries[instance], GL_QUERY_RESULT, &passed);
+            m_Visible[instance] = passed != 0;
+            m_Pending[instance] = 0;
+            m_Stats.occluded += passed == 0;
+        }
+        m_PendingInstances.resize(kept);
+    }
+
+    // True if the instance is drawn normally in the first half of the frame, false if it goes
+    // through query() and a conditional draw. Safe to call from several threads.
+    bool drawDirectly(uint32_t instance, const Aabb& bounds, const glm::vec3& cameraPosition, float nearPlane) const {
+        bool retest = (m_Frame + instance) % RetestInterval == 0;
+        // the near plane would cut the box open, and the hidden back faces can't prove anything
+        Aabb margin(bounds.min - glm::vec3(nearPlane * 2.0f), bounds.max + glm::vec3(nearPlane * 2.0f));
+        bool close = margin.min.x <= cameraPosition.x && cameraPosition.x <= margin.max.x &&
+                     margin.min.y <= cameraPosition.y && cameraPosition.y <= margin.max.y &&
+                     margin.min.z <= cameraPosition.z && cameraPosition.z <= margin.max.z;
+        return close || (m_Visible[instance] && !retest);
+    }
+
+    // Sets up drawing boxes into queries: the shader is occlusion_box.vs/fs, the depth buffer holds
+    // what the first half of the frame drew.
+    void beginQueries(Shader& shader, const glm::mat4& viewProjection) {
+        m_Shader = &shader;
+        shader.use();
+        shader.setMat4("viewProjection", viewProjection);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glBindVertexArray(m_VAO);
+    }
+
+    // Draws the instance's box inside its query and returns the query to condition its draws on.
+    GLuint query(uint32_t instance, const Aabb& bounds) {
+        // a query that is still in flight would lose its result if it were started again, the
+        // draws are conditioned on that one instead
+        if (m_Pending[instance]) {
+            m_Stats.lateQueries++;
+            return m_Queries[instance];
+        }
+        m_Shader->setVec3("boxMin", bounds.min);
+        m_Shader->setVec3("boxMax", bounds.max);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, m_Queries[instance]);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        m_Pending[instance] = 1;
+        m_PendingInstances.push_back(instance);
+        m_Stats.queries++;
+        return m_Queries[instance];
+    }
+
+    void endQueries() {
+        glBindVertexArray(0);
+        glDepthMask(GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        m_Shader = nullptr;
+    }
+
+    const Stats& stats() const {
+        return m_Stats;
+    }
+
+private:
+    GLuint m_VAO = 0;
+    GLuint m_VBO = 0;
+    GLuint m_EBO = 0;
+    std::vector<GLuint> m_Queries;
+    // result of the instance's last query that was read back
+    std::vector<uint8_t> m_Visible;
+    // the instance's query was issued and its result not read yet
+    std::vector<uint8_t> m_Pending;
+    std::vector<uint32_t> m_PendingInstances;
+    Shader* m_Shader = nullptr;
+    uint32_t m_Frame = 0;
+    Stats m_Stats;
+};
+
+};
+#endif //PROJECT_BASE_OCCLUSIONCULLER_H
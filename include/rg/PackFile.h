@@ -0,0 +1,138 @@
+#ifndef PROJECT_BASE_PACKFILE_H
+#define PROJECT_BASE_PACKFILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <rg/FileView.h>
+
+namespace rg {
+
+// Pack file layout, all integers little endian:
+//
+//   PackHeader
+//   entry data, every entry starting at a multiple of PackHeader::alignment
+//   PackEntry[entryCount], sorted by name (byte wise)
+//   names, not null terminated
+//
+// An entry with PACK_ENTRY_LZ is stored compressed (see rg/Lz.h) and expands to size bytes,
+// otherwise storedSize == size and its data can be used in place.
+const uint32_t PACK_VERSION = 1;
+const uint32_t PACK_ENTRY_LZ = 1;
+
+struct PackHeader {
+    char magic[4]; // "RGPK"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t alignment;
+    uint64_t tocOffset;
+    uint64_t namesOffset;
+};
+
+struct PackEntry {
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(PackHeader) == 32, "PackHeader has to match the file layout");
+static_assert(sizeof(PackEntry) == 40, "PackEntry has to match the file layout");
+
+// Read-only view of a pack file. The whole file is mapped, lookups binary search the table of contents.
+class PackFile {
+public:
+    bool open(const std::string& path) {
+        m_File = std::make_shared<FileView>();
+        if (!m_File->open(path) || m_File->size() < sizeof(PackHeader)) {
+            m_File.reset();
+            return false;
+        }
+        std::memcpy(&m_Header, m_File->data(), sizeof(m_Header));
+        // bounds are checked as sizes against what is left of the file, offset + size could wrap
+        uint64_t fileSize = m_File->size();
+        if (std::memcmp(m_Header.magic, "RGPK", 4) != 0 || m_Header.version != PACK_VERSION ||
+            m_Header.tocOffset > fileSize || m_Header.tocOffset % 8 != 0 || m_Header.namesOffset > fileSize ||
+            (uint64_t)m_Header.entryCount * sizeof(PackEntry) > fileSize - m_Header.tocOffset) {
+            m_File.reset();
+            return false;
+        }
+        m_Entries = (const PackEntry*)(m_File->data() + m_Header.tocOffset);
+        for (uint32_t i = 0; i < m_Header.entryCount; ++i) {
+            const PackEntry& entry = m_Entries[i];
+            if (entry.offset > fileSize || entry.storedSize > fileSize - entry.offset ||
+                (uint64_t)entry.nameOffset + entry.nameLength > fileSize - m_Header.namesOffset) {
+                m_File.reset();
+                return false;
+            }
+        }
+        struct stat info;
+        m_Stamp = stat(path.c_str(), &info) == 0 ? std::to_string((long long)info.st_mtime) : std::string();
+        return true;
+    }
+
+    bool isOpen() const {
+        return m_File != nullptr;
+    }
+
+    const PackEntry* find(const std::string& name) const {
+        if (!m_File) {
+            return nullptr;
+        }
+        const PackEntry* end = m_Entries + m_Header.entryCount;
+        const PackEntry* it = std::lower_bound(m_Entries, end, name, [this](const PackEntry& entry, const std::string& key) {
+            return compareName(entry, key) < 0;
+        });
+        return it != end && compareName(*it, name) == 0 ? it : nullptr;
+    }
+
+    const unsigned char* data(const PackEntry& entry) const {
+        return m_File->data() + entry.offset;
+    }
+
+    std::string name(const PackEntry& entry) const {
+        return std::string((const char*)m_File->data() + m_Header.namesOffset + entry.nameOffset, entry.nameLength);
+    }
+
+    uint32_t entryCount() const {
+        return m_Header.entryCount;
+    }
+
+    const PackEntry& entry(uint32_t index) const {
+        return m_Entries[index];
+    }
+
+    // keeps the mapping alive for views into it
+    const std::shared_ptr<FileView>& mapping() const {
+        return m_File;
+    }
+
+    // modification time of the pack, stands in for that of the files inside it
+    const std::string& stamp() const {
+        return m_Stamp;
+    }
+
+private:
+    std::shared_ptr<FileView> m_File;
+    PackHeader m_Header = {};
+    const PackEntry* m_Entries = nullptr;
+    std::string m_Stamp;
+
+    int compareName(const PackEntry& entry, const std::string& key) const {
+        const char* name = (const char*)m_File->data() + m_Header.namesOffset + entry.nameOffset;
+        int result = std::memcmp(name, key.data(), std::min<size_t>(entry.nameLength, key.size()));
+        if (result != 0) {
+            return result;
+        }
+        return entry.nameLength < key.size() ? -1 : (entry.nameLength > key.size() ? 1 : 0);
+    }
+};
+
+};
+#endif //PROJECT_BASE_PACKFILE_H
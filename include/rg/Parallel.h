@@ -0,0 +1,38 @@
+#ifndef PROJECT_BASE_PARALLEL_H
+#define PROJECT_BASE_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace rg {
+
+inline unsigned int hardwareThreads() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// Calls function(i) for every i in [0, count) on up to `threads` threads, the calling thread
+// included, and returns once all calls finished. Indices are handed out one at a time, so tasks
+// of very different size (e.g. the meshes of one model) still balance.
+template<typename Function>
+inline void parallelFor(size_t count, Function function, unsigned int threads = hardwareThreads()) {
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            function(i);
+        }
+    };
+    std::vector<std::thread> workers;
+    size_t workerCount = std::min<size_t>(std::max(threads, 1u), count);
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+};
+#endif //PROJECT_BASE_PARALLEL_H
@@ -0,0 +1,199 @@
+#ifndef PROJECT_BASE_PROGRAMCACHE_H
+#define PROJECT_BASE_PROGRAMCACHE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/filesystem.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <rg/FileView.h>
+#include <rg/GLExtensions.h>
+
+namespace rg {
+
+// On-disk cache of linked program binaries (ARB_get_program_binary).
+//
+// Programs are stored under cache/programs, named by a 64-bit hash of everything that goes into
+// them: the shader sources, the defines they were compiled with and the driver's vendor,
+// renderer and version strings. Editing a shader or updating the driver therefore changes the
+// key and the stale entry is simply never read again. A binary the driver rejects anyway (it is
+// allowed to, e.g. after a driver update that kept the version string) counts as a miss and is
+// overwritten by the next store().
+//
+// Without program binary support load() always misses and store() does nothing.
+class ProgramCache {
+public:
+    struct Stats {
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        double hitMilliseconds = 0.0;
+        double missMilliseconds = 0.0;
+    };
+
+    static ProgramCache& instance() {
+        static ProgramCache cache;
+        return cache;
+    }
+
+    bool enabled() const {
+        return m_Enabled && programBinaryFunctions().available();
+    }
+
+    void setEnabled(bool enabled) {
+        m_Enabled = enabled;
+    }
+
+    // Key for a program built from sources (in stage order) with the given defines. Needs a current context.
+    std::string key(const std::vector<std::string>& sources, const std::string& defines) const {
+        uint64_t hash = 14695981039346656037ull;
+        for (const std::string& source : sources) {
+            hash = hashBytes(hash, source.data(), source.size());
+            hash = hashBytes(hash, "\0", 1);
+        }
+        hash = hashBytes(hash, defines.data(), defines.size());
+        hash = hashBytes(hash, driver().data(), driver().size());
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+        return name;
+    }
+
+    // Loads the cached binary for key into program, returns false if the program has to be
+    // compiled from source. program has to be freshly created.
+    bool load(const std::string& key, GLuint program) {
+        if (!enabled()) {
+            return false;
+        }
+        FileView file(cacheFilePath(key));
+        if (!file.isOpen() || file.size() <= sizeof(Header)) {
+            return false;
+        }
+        Header header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, "RGPB", 4) != 0 || header.length != file.size() - sizeof(Header)) {
+            return false;
+        }
+        programBinaryFunctions().programBinary(program, header.format, file.data() + sizeof(Header), header.length);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        return linked == GL_TRUE;
+    }
+
+    // Call before linking a program that will be stored, some drivers only keep the binary around when asked to.
+    void prepare(GLuint program) {
+        if (enabled()) {
+            programBinaryFunctions().programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+    }
+
+    // Writes the binary of a successfully linked program.
+    void store(const std::string& key, GLuint program) {
+        if (!enabled()) {
+            return;
+        }
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+        std::vector<unsigned char> binary(length);
+        Header header;
+        std::memcpy(header.magic, "RGPB", 4);
+        GLsizei written = 0;
+        programBinaryFunctions().getProgramBinary(program, length, &written, &header.format, binary.data());
+        if (written <= 0) {
+            return;
+        }
+        header.length = written;
+
+        makeDirectories(cacheDirectory());
+        std::string path = cacheFilePath(key);
+        std::string temporaryPath = path + ".tmp";
+        std::ofstream out(temporaryPath, std::ios::binary);
+        if (!out) {
+            return;
+        }
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)binary.data(), written);
+        out.close();
+        if (!out.good() || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            std::remove(temporaryPath.c_str());
+        }
+    }
+
+    void recordHit(double milliseconds) {
+        m_Stats.hits++;
+        m_Stats.hitMilliseconds += milliseconds;
+    }
+
+    void recordMiss(double milliseconds) {
+        m_Stats.misses++;
+        m_Stats.missMilliseconds += milliseconds;
+    }
+
+    const Stats& stats() const {
+        return m_Stats;
+    }
+
+    void printStats() const {
+        std::cout << "Program cache" << (enabled() ? "" : " (unavailable)") << ": "
+                  << m_Stats.hits << " programs loaded in " << m_Stats.hitMilliseconds << " ms, "
+                  << m_Stats.misses << " compiled in " << m_Stats.missMilliseconds << " ms" << std::endl;
+    }
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    struct Header {
+        char magic[4]; // "RGPB"
+        GLenum format;
+        uint32_t length;
+    };
+
+    bool m_Enabled = true;
+    Stats m_Stats;
+
+    ProgramCache() = default;
+
+    static uint64_t hashBytes(uint64_t hash, const char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static const std::string& driver() {
+        static std::string value = std::string((const char*)glGetString(GL_VENDOR)) + '\n' +
+                                   (const char*)glGetString(GL_RENDERER) + '\n' +
+                                   (const char*)glGetString(GL_VERSION);
+        return value;
+    }
+
+    static std::string cacheDirectory() {
+        return FileSystem::getPath("cache/programs");
+    }
+
+    static std::string cacheFilePath(const std::string& key) {
+        return cacheDirectory() + "/" + key + ".bin";
+    }
+
+    static void makeDirectories(const std::string& path) {
+        for (size_t i = 1; i <= path.size(); ++i) {
+            if (i == path.size() || path[i] == '/') {
+                mkdir(path.substr(0, i).c_str(), 0755);
+            }
+        }
+    }
+};
+
+};
+#endif //PROJECT_BASE_PROGRAMCACHE_H
@@ -0,0 +1,423 @@
+#ifndef PROJECT_BASE_RENDERQUEUE_H
+#define PROJECT_BASE_RENDERQUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/model.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <rg/Error.h>
+#include <rg/UniformRing.h>
+
+namespace rg {
+
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+    Transparent = 1,
+    Overlay = 2
+};
+
+// Draws are recorded as 64-bit sort keys and executed in key order once per frame.
+//
+// Key layout, most significant bits first:
+//   opaque/overlay: | pass:2 | shader:8 | material:16 | condition:14 | depth:24 |
+//   transparent:    | pass:2 | ~depth:24 | shader:8 | material:16 | condition:14 |
+// so opaque geometry is grouped by program, then by texture set, then by occlusion query (see
+// setCondition()) and drawn front to back, while transparent geometry is drawn back to front
+// regardless of state changes. Keeping a query's draws together means conditional rendering is
+// switched once per query and material instead of around every draw.
+//
+// Per-draw data isn't set with glUniform calls: flush() writes the PerDraw block of every draw
+// into a UniformRing up front and each draw binds its range of it. Shaders drawn through the
+// queue declare the block (see object.vs) and leave it at binding point PER_DRAW_BINDING.
+class RenderQueue {
+public:
+    struct Stats {
+        unsigned int draws = 0;
+        unsigned int programBinds = 0;
+        unsigned int materialBinds = 0;
+        unsigned int vertexArrayBinds = 0;
+        // draws executed inside glBeginConditionalRender, see setCondition()
+        unsigned int conditionalDraws = 0;
+        size_t uniformBytes = 0;
+    };
+
+    // std140 layout of the PerDraw uniform block
+    struct PerDraw {
+        glm::mat4 model;
+        // transpose(inverse(model)), so the vertex shader doesn't invert a matrix per vertex
+        glm::mat4 normalMatrix;
+    };
+
+    // every uniform block defaults to binding point 0, so the shaders need no setup for this one
+    static constexpr GLuint PER_DRAW_BINDING = 0;
+
+    static constexpr unsigned int MAX_SHADERS = 1u << 8;
+    static constexpr unsigned int MAX_MATERIALS = 1u << 16;
+    static constexpr unsigned int DEPTH_BITS = 24;
+    static constexpr unsigned int CONDITION_BITS = 14;
+
+private:
+    struct DrawCommand {
+        const Mesh* mesh;
+        PerDraw perDraw;
+        unsigned int shader;
+        // NoMaterial until merge() resolves it, for meshes record() saw first
+        unsigned int material;
+        GLuint condition;
+        RenderPass pass;
+    };
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    static constexpr unsigned int NoMaterial = ~0u;
+
+public:
+    // Draws recorded with record() for merging into the queue later, one list per thread builds
+    // the draw list of a frame in parallel.
+    class DrawList {
+    public:
+        void clear() {
+            m_Commands.clear();
+            m_Entries.clear();
+        }
+
+        size_t size() const {
+            return m_Commands.size();
+        }
+
+    private:
+        friend class RenderQueue;
+        std::vector<DrawCommand> m_Commands;
+        std::vector<SortEntry> m_Entries;
+    };
+
+    // flushesPerFrame sizes the uniform ring, so a second flush() in a frame doesn't eat into the
+    // frames the CPU may run ahead of the GPU
+    explicit RenderQueue(unsigned int flushesPerFrame = 1) : m_Uniforms(256 * 1024, flushesPerFrame) {
+    }
+
+    // Shaders have to be registered once, the registration order has no effect on the draw order
+    // other than deciding which program goes first.
+    unsigned int registerShader(Shader& shader) {
+        ASSERT(m_Shaders.size() < MAX_SHADERS, "Too many shaders registered in the render queue");
+        m_Shaders.push_back(&shader);
+        return m_Shaders.size() - 1;
+    }
+
+    // Replaces the shader behind a registered id, e.g. with another variant of it. The id keeps its
+    // place in the draw order.
+    void setShader(unsigned int shaderId, Shader& shader) {
+        ASSERT(shaderId < m_Shaders.size(), "Replacing an unregistered shader");
+        m_Shaders[shaderId] = &shader;
+    }
+
+    // Call at the start of the frame with the camera that the depth part of the key is computed for.
+    void begin(const glm::vec3& cameraPosition, const glm::vec3& cameraFront, float farPlane) {
+        m_CameraPosition = cameraPosition;
+        m_CameraFront = cameraFront;
+        m_FarPlane = farPlane;
+        m_Commands.clear();
+        m_Entries.clear();
+        m_Condition = 0;
+        m_ConditionIndex = 0;
+        m_ConditionCount = 0;
+    }
+
+    // Draws submitted after this only run if the occlusion query passed (GL_QUERY_WAIT, the GPU
+    // waits for the result, the CPU doesn't); 0 draws unconditionally again. Each query gets the
+    // next index of the frame for the key, past the last one queries share it, which only costs
+    // extra switches.
+    void setCondition(GLuint query) {
+        if (query == m_Condition) {
+            return;
+        }
+        m_Condition = query;
+        if (!query) {
+            m_ConditionIndex = 0;
+            return;
+        }
+        m_ConditionCount = std::min(m_ConditionCount + 1, (1u << CONDITION_BITS) - 1);
+        m_ConditionIndex = m_ConditionCount;
+    }
+
+    // normalMatrix is transpose(inverse(model)), pass one that is kept around (see SceneGraph)
+    // to not compute it again every frame.
+    void submit(unsigned int shaderId, const Mesh& mesh, const glm::mat4& model, const glm::mat4& normalMatrix,
+                RenderPass pass = RenderPass::Opaque) {
+        ASSERT(shaderId < m_Shaders.size(), "Submitting with an unregistered shader");
+        unsigned int material = materialId(mesh);
+        uint64_t key = makeKey(pass, shaderId, material, quantizeDepth(glm::vec3(model[3])), m_ConditionIndex);
+
+        m_Entries.push_back(SortEntry{key, (uint32_t)m_Commands.size()});
+        m_Commands.push_back(DrawCommand{&mesh, PerDraw{model, normalMatrix}, shaderId, material, m_Condition, pass});
+    }
+
+    void submit(unsigned int shaderId, const Mesh& mesh, const glm::mat4& model,
+                RenderPass pass = RenderPass::Opaque) {
+        submit(shaderId, mesh, model, glm::transpose(glm::inverse(model)), pass);
+    }
+
+    void submit(unsigned int shaderId, const Model& model, const glm::mat4& transform, const glm::mat4& normalMatrix,
+                RenderPass pass = RenderPass::Opaque) {
+        for (const Mesh& mesh : model.meshes) {
+            submit(shaderId, mesh, transform, normalMatrix, pass);
+        }
+    }
+
+    void submit(unsigned int shaderId, const Model& model, const glm::mat4& transform,
+                RenderPass pass = RenderPass::Opaque) {
+        submit(shaderId, model, transform, glm::transpose(glm::inverse(transform)), pass);
+    }
+
+    // Like submit(), into list. Doesn't change the queue, so threads can record into their own
+    // lists at once, as long as nothing submits, merges or invalidates meanwhile.
+    void record(DrawList& list, unsigned int shaderId, const Mesh& mesh, const glm::mat4& model,
+                const glm::mat4& normalMatrix, RenderPass pass = RenderPass::Opaque) const {
+        // a mesh the queue hasn't seen yet may need a new material, that is left to merge()
+        auto cached = m_MeshMaterials.find(&mesh);
+        unsigned int material = cached != m_MeshMaterials.end() ? cached->second : NoMaterial;
+        uint64_t key = material != NoMaterial ? makeKey(pass, shaderId, material, quantizeDepth(glm::vec3(model[3]))) : 0;
+
+        list.m_Entries.push_back(SortEntry{key, (uint32_t)list.m_Commands.size()});
+        list.m_Commands.push_back(DrawCommand{&mesh, PerDraw{model, normalMatrix}, shaderId, material, 0, pass});
+    }
+
+    void record(DrawList& list, unsigned int shaderId, const Model& model, const glm::mat4& transform,
+                const glm::mat4& normalMatrix, RenderPass pass = RenderPass::Opaque) const {
+        for (const Mesh& mesh : model.meshes) {
+            record(list, shaderId, mesh, transform, normalMatrix, pass);
+        }
+    }
+
+    // Adds the draws recorded into lists as if they were submitted now (under the current
+    // condition) and clears the lists.
+    void merge(std::vector<DrawList>& lists) {
+        size_t total = m_Commands.size();
+        for (const DrawList& list : lists) {
+            total += list.size();
+        }
+        m_Commands.reserve(total);
+        m_Entries.reserve(total);
+        for (DrawList& list : lists) {
+            uint32_t offset = (uint32_t)m_Commands.size();
+            m_Commands.insert(m_Commands.end(), list.m_Commands.begin(), list.m_Commands.end());
+            for (const SortEntry& entry : list.m_Entries) {
+                DrawCommand& command = m_Commands[offset + entry.index];
+                command.condition = m_Condition;
+                uint64_t key = entry.key | conditionKey(command.pass, m_ConditionIndex);
+                if (command.material == NoMaterial) {
+                    command.material = materialId(*command.mesh);
+                    key = makeKey(command.pass, command.shader, command.material,
+                                  quantizeDepth(glm::vec3(command.perDraw.model[3])), m_ConditionIndex);
+                }
+                m_Entries.push_back(SortEntry{key, offset + entry.index});
+            }
+            list.clear();
+        }
+    }
+
+    // Material ids are cached per mesh, call this after changing the textures of a mesh that was drawn before.
+    void invalidate(const Mesh& mesh) {
+        m_MeshMaterials.erase(&mesh);
+    }
+
+    // Sorts the recorded draws and executes them, skipping redundant program, texture and VAO binds.
+    void flush() {
+        sortEntries();
+
+        m_Stats = Stats();
+        if (m_Entries.empty()) {
+            return;
+        }
+        // all per-draw data is written before the first draw, which also is what a buffer that
+        // isn't persistently mapped requires
+        size_t stride = m_Uniforms.align(sizeof(PerDraw));
+        unsigned char* perDraw = m_Uniforms.begin(m_Entries.size() * stride);
+        for (size_t i = 0; i < m_Entries.size(); ++i) {
+            std::memcpy(perDraw + i * stride, &m_Commands[m_Entries[i].index].perDraw, sizeof(PerDraw));
+        }
+        m_Uniforms.end();
+        m_Stats.uniformBytes = m_Entries.size() * stride;
+
+        unsigned int currentShader = ~0u;
+        unsigned int currentMaterial = ~0u;
+        unsigned int currentVAO = 0;
+        GLuint currentCondition = 0;
+
+        for (size_t i = 0; i < m_Entries.size(); ++i) {
+            const DrawCommand& command = m_Commands[m_Entries[i].index];
+            Shader& shader = *m_Shaders[command.shader];
+
+            bool shaderChanged = command.shader != currentShader;
+            if (shaderChanged) {
+                shader.use();
+                currentShader = command.shader;
+                ++m_Stats.programBinds;
+            }
+            // sampler uniforms are program state, so a program switch also invalidates the material
+            if (shaderChanged || command.material != currentMaterial) {
+                command.mesh->BindTextures(shader);
+                currentMaterial = command.material;
+                ++m_Stats.materialBinds;
+            }
+            if (command.mesh->VAO != currentVAO) {
+                glBindVertexArray(command.mesh->VAO);
+                currentVAO = command.mesh->VAO;
+                ++m_Stats.vertexArrayBinds;
+            }
+
+            if (command.condition != currentCondition) {
+                if (currentCondition) {
+                    glEndConditionalRender();
+                }
+                if (command.condition) {
+                    glBeginConditionalRender(command.condition, GL_QUERY_WAIT);
+                }
+                currentCondition = command.condition;
+            }
+
+            glBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, m_Uniforms.buffer(),
+                              m_Uniforms.offset() + i * stride, sizeof(PerDraw));
+            glDrawElements(GL_TRIANGLES, command.mesh->indices.size(), GL_UNSIGNED_INT, 0);
+            ++m_Stats.draws;
+            m_Stats.conditionalDraws += currentCondition != 0;
+        }
+        if (currentCondition) {
+            glEndConditionalRender();
+        }
+
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    const Stats& stats() const {
+        return m_Stats;
+    }
+
+    // Releases the GL objects of the queue, call before the context goes away.
+    void shutdown() {
+        m_Uniforms.release();
+    }
+
+    static uint64_t makeKey(RenderPass pass, uint32_t shader, uint32_t material, uint32_t depth,
+                            uint32_t condition = 0) {
+        uint64_t key = (uint64_t)pass << 62;
+        if (pass == RenderPass::Transparent) {
+            key |= (uint64_t)(~depth & ((1u << DEPTH_BITS) - 1)) << 38;
+            key |= (uint64_t)shader << 30;
+            key |= (uint64_t)material << 14;
+        } else {
+            key |= (uint64_t)shader << 54;
+            key |= (uint64_t)material << 38;
+            key |= (uint64_t)depth;
+        }
+        return key | conditionKey(pass, condition);
+    }
+
+    static uint64_t conditionKey(RenderPass pass, uint32_t condition) {
+        return (uint64_t)condition << (pass == RenderPass::Transparent ? 0 : DEPTH_BITS);
+    }
+
+private:
+    std::vector<Shader*> m_Shaders;
+    std::vector<DrawCommand> m_Commands;
+    std::vector<SortEntry> m_Entries;
+    std::vector<SortEntry> m_Scratch;
+
+    // meshes sharing the same set of texture objects share a material id
+    std::map<std::vector<unsigned int>, unsigned int> m_Materials;
+    std::unordered_map<const Mesh*, unsigned int> m_MeshMaterials;
+
+    glm::vec3 m_CameraPosition = glm::vec3(0.0f);
+    glm::vec3 m_CameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+    float m_FarPlane = 100.0f;
+    GLuint m_Condition = 0;
+    // m_Condition's index in the key, 0 for unconditional draws
+    uint32_t m_ConditionIndex = 0;
+    uint32_t m_ConditionCount = 0;
+    Stats m_Stats;
+    UniformRing m_Uniforms;
+
+    unsigned int materialId(const Mesh& mesh) {
+        auto cached = m_MeshMaterials.find(&mesh);
+        if (cached != m_MeshMaterials.end()) {
+            return cached->second;
+        }
+
+        std::vector<unsigned int> textureIds;
+        textureIds.reserve(mesh.textures.size());
+        for (const Texture& texture : mesh.textures) {
+            textureIds.push_back(texture.id);
+        }
+        auto it = m_Materials.find(textureIds);
+        if (it == m_Materials.end()) {
+            ASSERT(m_Materials.size() < MAX_MATERIALS, "Too many materials in the render queue");
+            unsigned int id = m_Materials.size();
+            it = m_Materials.emplace(std::move(textureIds), id).first;
+        }
+        m_MeshMaterials[&mesh] = it->second;
+        return it->second;
+    }
+
+    uint32_t quantizeDepth(const glm::vec3& position) const {
+        float depth = glm::dot(position - m_CameraPosition, m_CameraFront) / m_FarPlane;
+        depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+        return (uint32_t)(depth * (float)((1u << DEPTH_BITS) - 1));
+    }
+
+    // LSD radix sort over 8-bit digits, digits that are equal for every key are skipped.
+    void sortEntries() {
+        size_t count = m_Entries.size();
+        if (count < 2) {
+            return;
+        }
+        m_Scratch.resize(count);
+
+        size_t histograms[8][256] = {};
+        for (const SortEntry& entry : m_Entries) {
+            for (unsigned int digit = 0; digit < 8; ++digit) {
+                ++histograms[digit][(entry.key >> (digit * 8)) & 0xff];
+            }
+        }
+
+        SortEntry* src = m_Entries.data();
+        SortEntry* dst = m_Scratch.data();
+        for (unsigned int digit = 0; digit < 8; ++digit) {
+            size_t* histogram = histograms[digit];
+            unsigned int shift = digit * 8;
+            if (histogram[(src[0].key >> shift) & 0xff] == count) {
+                continue;
+            }
+
+            size_t offset = 0;
+            for (unsigned int bucket = 0; bucket < 256; ++bucket) {
+                size_t bucketSize = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += bucketSize;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+            }
+            std::swap(src, dst);
+        }
+
+        if (src != m_Entries.data()) {
+            m_Entries.swap(m_Scratch);
+        }
+    }
+};
+
+};
+#endif //PROJECT_BASE_RENDERQUEUE_H
@@ -0,0 +1,514 @@
+#ifndef PROJECT_BASE_SCENEFILE_H
+#define PROJECT_BASE_SCENEFILE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <rg/Json.h>
+#include <rg/Vfs.h>
+
+namespace rg {
+
+enum class SceneShader : uint32_t {
+    Object = 0,
+    // unlit, for the lamps
+    Light = 1
+};
+
+struct SceneMaterial {
+    std::string name;
+    std::string diffuse;
+    std::string specular;
+};
+
+struct SceneModel {
+    std::string name;
+    // model file, or empty for the built-in primitive
+    std::string path;
+    // "plane": the unit quad in the xz plane, textured with material
+    std::string primitive;
+    int32_t material = -1;
+    SceneShader shader = SceneShader::Object;
+};
+
+struct SceneNode {
+    std::string name;
+    // index of the parent in SceneDescription::nodes, always lower than the node's own
+    int32_t parent = -1;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+    float rotationDegrees = 0.0f;
+    glm::vec3 scale = glm::vec3(1.0f);
+    // index into SceneDescription::models, -1 for nodes that only group or place others
+    int32_t model = -1;
+
+    // translate * rotate * scale
+    glm::mat4 local() const {
+        glm::mat4 result = glm::translate(glm::mat4(1.0f), position);
+        if (rotationDegrees != 0.0f) {
+            result = glm::rotate(result, glm::radians(rotationDegrees), rotationAxis);
+        }
+        return glm::scale(result, scale);
+    }
+};
+
+enum class SceneLightType : uint32_t {
+    Point = 0,
+    Spot = 1
+};
+
+struct SceneLight {
+    SceneLightType type = SceneLightType::Point;
+    // the light sits at this node, spot lights without one follow the camera
+    int32_t node = -1;
+    glm::vec3 ambient = glm::vec3(0.05f);
+    glm::vec3 diffuse = glm::vec3(0.8f);
+    glm::vec3 specular = glm::vec3(1.0f);
+    float constant = 1.0f;
+    float linear = 0.09f;
+    float quadratic = 0.032f;
+    float cutOffDegrees = 12.5f;
+    float outerCutOffDegrees = 15.0f;
+
+    // Distance at which the attenuated light falls below threshold of its brightest diffuse
+    // channel, i.e. where it stops making a visible difference. Instances further away than this
+    // are not lit by it.
+    float range(float threshold = 1.0f / 256.0f) const {
+        // solves quadratic * d^2 + linear * d + constant = intensity / threshold for d
+        float intensity = std::max(diffuse.x, std::max(diffuse.y, diffuse.z));
+        float c = constant - intensity / threshold;
+        if (c >= 0.0f) {
+            return 0.0f;
+        }
+        if (quadratic > 0.0f) {
+            return (-linear + std::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+        }
+        return linear > 0.0f ? -c / linear : FLT_MAX;
+    }
+};
+
+// Rotates a node back and forth around axis on top of its local transform:
+// amplitudeDegrees * sin(phase + frequency * time).
+struct SceneSwing {
+    int32_t node = -1;
+    glm::vec3 axis = glm::vec3(0.0f, 0.0f, 1.0f);
+    float amplitudeDegrees = 0.0f;
+    float frequency = 1.0f;
+    float phase = 0.0f;
+};
+
+// A box in the node's local space that is solid, i.e. hides everything behind it: the table top,
+// the floor. Used by the CPU occlusion culler, so it has to lie inside the visible geometry.
+struct SceneOccluder {
+    int32_t node = -1;
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+struct SceneDescription {
+    std::vector<SceneModel> models;
+    std::vector<SceneMaterial> materials;
+    std::vector<SceneNode> nodes;
+    std::vector<SceneLight> lights;
+    std::vector<SceneSwing> swings;
+    std::vector<SceneOccluder> occluders;
+};
+
+// Scene files, as JSON for writing them by hand or as the binary form tools/scene_compiler.cpp
+// compiles the JSON to. load() tells them apart by the binary header.
+//
+// In JSON, nodes nest through "children" and refer to models, materials and each other by
+// name; the nesting is flattened parents first, which is the order SceneGraph wants, and the
+// names are resolved to indices. The binary form stores the result: fixed-size records for
+// each array plus one table of the strings they point into, so loading it is a single pass
+// over the file without any parsing or lookups. See resources/scenes/dining_room.json.
+class SceneFile {
+public:
+    static bool load(const std::string& path, SceneDescription& scene, std::string& error) {
+        VfsFile file = Vfs::instance().open(path);
+        if (!file.isOpen()) {
+            error = "can't open " + path;
+            return false;
+        }
+        if (file.size() >= 4 && std::memcmp(file.data(), Magic, 4) == 0) {
+            return readBinary(file.data(), file.size(), scene, error);
+        }
+        JsonValue json;
+        if (!JsonValue::parse(file.begin(), file.end(), json, error)) {
+            error = path + ": " + error;
+            return false;
+        }
+        if (!fromJson(json, scene, error)) {
+            error = path + ": " + error;
+            return false;
+        }
+        return true;
+    }
+
+    static bool fromJson(const JsonValue& json, SceneDescription& scene, std::string& error) {
+        scene = SceneDescription();
+        std::unordered_map<std::string, int32_t> materials;
+        for (const JsonValue& value : json["materials"].elements()) {
+            SceneMaterial material;
+            material.name = value["name"].asString("");
+            material.diffuse = value["diffuse"].asString("");
+            material.specular = value["specular"].asString(material.diffuse);
+            materials[material.name] = (int32_t)scene.materials.size();
+            scene.materials.push_back(material);
+        }
+
+        std::unordered_map<std::string, int32_t> models;
+        for (const JsonValue& value : json["models"].elements()) {
+            SceneModel model;
+            model.name = value["name"].asString("");
+            model.path = value["path"].asString("");
+            model.primitive = value["primitive"].asString("");
+            if (model.path.empty() == model.primitive.empty()) {
+                error = "model '" + model.name + "' needs either a path or a primitive";
+                return false;
+            }
+            if (value.has("material") && !lookup(materials, value["material"].asString(""), "material", model.material, error)) {
+                return false;
+            }
+            std::string shader = value["shader"].asString("object");
+            if (shader != "object" && shader != "light") {
+                error = "model '" + model.name + "' has unknown shader '" + shader + "'";
+                return false;
+            }
+            model.shader = shader == "light" ? SceneShader::Light : SceneShader::Object;
+            models[model.name] = (int32_t)scene.models.size();
+            scene.models.push_back(model);
+        }
+
+        for (const JsonValue& value : json["nodes"].elements()) {
+            if (!addNode(value, -1, models, scene, error)) {
+                return false;
+            }
+        }
+
+        // camera lights
+        for (const JsonValue& value : json["lights"].elements()) {
+            if (!addLight(value, -1, scene, error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool writeBinary(const SceneDescription& scene, const std::string& path) {
+        std::string strings;
+        auto string = [&strings](const std::string& value) {
+            uint32_t offset = (uint32_t)strings.size();
+            strings += value;
+            strings += '\0';
+            return offset;
+        };
+
+        std::vector<MaterialRecord> materials;
+        for (const SceneMaterial& material : scene.materials) {
+            materials.push_back(MaterialRecord{string(material.name), string(material.diffuse), string(material.specular)});
+        }
+        std::vector<ModelRecord> models;
+        for (const SceneModel& model : scene.models) {
+            models.push_back(ModelRecord{string(model.name), string(model.path), string(model.primitive),
+                                         model.material, (uint32_t)model.shader});
+        }
+        std::vector<NodeRecord> nodes;
+        for (const SceneNode& node : scene.nodes) {
+            nodes.push_back(NodeRecord{string(node.name), node.parent, node.position, node.rotationAxis,
+                                       node.rotationDegrees, node.scale, node.model});
+        }
+
+        Header header = {};
+        std::memcpy(header.magic, Magic, 4);
+        header.version = Version;
+        header.models = (uint32_t)models.size();
+        header.materials = (uint32_t)materials.size();
+        header.nodes = (uint32_t)nodes.size();
+        header.lights = (uint32_t)scene.lights.size();
+        header.swings = (uint32_t)scene.swings.size();
+        header.occluders = (uint32_t)scene.occluders.size();
+        header.stringBytes = (uint32_t)strings.size();
+
+        std::ofstream out(path, std::ios::binary);
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)models.data(), models.size() * sizeof(ModelRecord));
+        out.write((const char*)materials.data(), materials.size() * sizeof(MaterialRecord));
+        out.write((const char*)nodes.data(), nodes.size() * sizeof(NodeRecord));
+        out.write((const char*)scene.lights.data(), scene.lights.size() * sizeof(SceneLight));
+        out.write((const char*)scene.swings.data(), scene.swings.size() * sizeof(SceneSwing));
+        out.write((const char*)scene.occluders.data(), scene.occluders.size() * sizeof(SceneOccluder));
+        out.write(strings.data(), strings.size());
+        return out.good();
+    }
+
+    static bool readBinary(const unsigned char* data, size_t size, SceneDescription& scene, std::string& error) {
+        scene = SceneDescription();
+        Header header;
+        if (size < sizeof(header)) {
+            error = "truncated scene file";
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (header.version != Version) {
+            error = "scene file has version " + std::to_string(header.version) + ", expected " +
+                    std::to_string(Version) + ", compile it again";
+            return false;
+        }
+        size_t expected = sizeof(header) + (size_t)header.models * sizeof(ModelRecord) +
+                          (size_t)header.materials * sizeof(MaterialRecord) + (size_t)header.nodes * sizeof(NodeRecord) +
+                          (size_t)header.lights * sizeof(SceneLight) + (size_t)header.swings * sizeof(SceneSwing) +
+                          (size_t)header.occluders * sizeof(SceneOccluder) + header.stringBytes;
+        if (size != expected || header.stringBytes == 0 || data[size - 1] != '\0') {
+            error = "corrupt scene file";
+            return false;
+        }
+
+        const unsigned char* position = data + sizeof(header);
+        const char* strings = (const char*)data + size - header.stringBytes;
+        auto string = [&](uint32_t offset) {
+            return offset < header.stringBytes ? std::string(strings + offset) : std::string();
+        };
+        auto records = [&position](auto& out, uint32_t count) {
+            out.resize(count);
+            std::memcpy(out.data(), position, count * sizeof(out[0]));
+            position += count * sizeof(out[0]);
+        };
+
+        std::vector<ModelRecord> models;
+        std::vector<MaterialRecord> materials;
+        std::vector<NodeRecord> nodes;
+        records(models, header.models);
+        records(materials, header.materials);
+        records(nodes, header.nodes);
+        records(scene.lights, header.lights);
+        records(scene.swings, header.swings);
+        records(scene.occluders, header.occluders);
+
+        scene.models.resize(models.size());
+        for (size_t i = 0; i < models.size(); ++i) {
+            SceneModel& model = scene.models[i];
+            model.name = string(models[i].name);
+            model.path = string(models[i].path);
+            model.primitive = string(models[i].primitive);
+            model.material = models[i].material;
+            model.shader = (SceneShader)models[i].shader;
+        }
+        scene.materials.resize(materials.size());
+        for (size_t i = 0; i < materials.size(); ++i) {
+            scene.materials[i].name = string(materials[i].name);
+            scene.materials[i].diffuse = string(materials[i].diffuse);
+            scene.materials[i].specular = string(materials[i].specular);
+        }
+        scene.nodes.resize(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            SceneNode& node = scene.nodes[i];
+            node.name = string(nodes[i].name);
+            node.parent = nodes[i].parent;
+            node.position = nodes[i].position;
+            node.rotationAxis = nodes[i].rotationAxis;
+            node.rotationDegrees = nodes[i].rotationDegrees;
+            node.scale = nodes[i].scale;
+            node.model = nodes[i].model;
+        }
+        return validate(scene, error);
+    }
+
+    // What fromJson enforces: indices in range or -1 where that is allowed, parents before children,
+    // known enum values and placed point lights. The binary form can't be trusted with any of it.
+    static bool validate(const SceneDescription& scene, std::string& error) {
+        for (size_t i = 0; i < scene.models.size(); ++i) {
+            const SceneModel& model = scene.models[i];
+            if (model.path.empty() == model.primitive.empty()) {
+                error = "model " + std::to_string(i) + " needs either a path or a primitive";
+                return false;
+            }
+            if (model.material < -1 || model.material >= (int32_t)scene.materials.size()) {
+                error = "model " + std::to_string(i) + " has an invalid material";
+                return false;
+            }
+            if (model.shader != SceneShader::Object && model.shader != SceneShader::Light) {
+                error = "model " + std::to_string(i) + " has an invalid shader";
+                return false;
+            }
+        }
+        for (size_t i = 0; i < scene.nodes.size(); ++i) {
+            const SceneNode& node = scene.nodes[i];
+            if (node.parent < -1 || node.parent >= (int32_t)i || node.model < -1 ||
+                node.model >= (int32_t)scene.models.size()) {
+                error = "node " + std::to_string(i) + " has an invalid parent or model";
+                return false;
+            }
+        }
+        for (const SceneLight& light : scene.lights) {
+            if (light.type != SceneLightType::Point && light.type != SceneLightType::Spot) {
+                error = "light with an invalid type";
+                return false;
+            }
+            if (light.node < -1 || light.node >= (int32_t)scene.nodes.size() ||
+                (light.type == SceneLightType::Point && light.node < 0)) {
+                error = "light with an invalid node";
+                return false;
+            }
+        }
+        for (const SceneSwing& swing : scene.swings) {
+            if (swing.node < 0 || swing.node >= (int32_t)scene.nodes.size()) {
+                error = "swing with an invalid node";
+                return false;
+            }
+        }
+        for (const SceneOccluder& occluder : scene.occluders) {
+            if (occluder.node < 0 || occluder.node >= (int32_t)scene.nodes.size()) {
+                error = "occluder with an invalid node";
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr const char* Magic = "RGSC";
+    // bump when a record changes
+    static const uint32_t Version = 2;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t models;
+        uint32_t materials;
+        uint32_t nodes;
+        uint32_t lights;
+        uint32_t swings;
+        uint32_t occluders;
+        uint32_t stringBytes;
+    };
+
+    // strings are offsets into the string table
+    struct ModelRecord {
+        uint32_t name;
+        uint32_t path;
+        uint32_t primitive;
+        int32_t material;
+        uint32_t shader;
+    };
+
+    struct MaterialRecord {
+        uint32_t name;
+        uint32_t diffuse;
+        uint32_t specular;
+    };
+
+    struct NodeRecord {
+        uint32_t name;
+        int32_t parent;
+        glm::vec3 position;
+        glm::vec3 rotationAxis;
+        float rotationDegrees;
+        glm::vec3 scale;
+        int32_t model;
+    };
+
+    static bool lookup(const std::unordered_map<std::string, int32_t>& names, const std::string& name,
+                       const char* kind, int32_t& index, std::string& error) {
+        auto it = names.find(name);
+        if (it == names.end()) {
+            error = std::string("unknown ") + kind + " '" + name + "'";
+            return false;
+        }
+        index = it->second;
+        return true;
+    }
+
+    static glm::vec3 vec3(const JsonValue& value, const glm::vec3& fallback) {
+        if (value.isNumber()) {
+            return glm::vec3((float)value.asNumber());
+        }
+        if (!value.isArray() || value.size() != 3) {
+            return fallback;
+        }
+        return glm::vec3((float)value[0].asNumber(), (float)value[1].asNumber(), (float)value[2].asNumber());
+    }
+
+    static bool addNode(const JsonValue& value, int32_t parent, const std::unordered_map<std::string, int32_t>& models,
+                        SceneDescription& scene, std::string& error) {
+        SceneNode node;
+        node.name = value["name"].asString("");
+        node.parent = parent;
+        node.position = vec3(value["position"], node.position);
+        node.scale = vec3(value["scale"], node.scale);
+        const JsonValue& rotation = value["rotation"];
+        node.rotationAxis = vec3(rotation["axis"], node.rotationAxis);
+        node.rotationDegrees = (float)rotation["degrees"].asNumber(0.0);
+        if (value.has("model") && !lookup(models, value["model"].asString(""), "model", node.model, error)) {
+            error = "node '" + node.name + "': " + error;
+            return false;
+        }
+        int32_t index = (int32_t)scene.nodes.size();
+        scene.nodes.push_back(node);
+
+        if (value.has("light") && !addLight(value["light"], index, scene, error)) {
+            return false;
+        }
+        const JsonValue& swing = value["swing"];
+        if (swing.isObject()) {
+            SceneSwing result;
+            result.node = index;
+            result.axis = vec3(swing["axis"], result.axis);
+            result.amplitudeDegrees = (float)swing["degrees"].asNumber(0.0);
+            result.frequency = (float)swing["frequency"].asNumber(result.frequency);
+            result.phase = (float)swing["phase"].asNumber(result.phase);
+            scene.swings.push_back(result);
+        }
+        const JsonValue& occluder = value["occluder"];
+        if (occluder.isObject()) {
+            SceneOccluder result;
+            result.node = index;
+            result.min = vec3(occluder["min"], result.min);
+            result.max = vec3(occluder["max"], result.max);
+            scene.occluders.push_back(result);
+        }
+        for (const JsonValue& child : value["children"].elements()) {
+            if (!addNode(child, index, models, scene, error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool addLight(const JsonValue& value, int32_t node, SceneDescription& scene, std::string& error) {
+        SceneLight light;
+        std::string type = value["type"].asString("point");
+        if (type != "point" && type != "spot") {
+            error = "unknown light type '" + type + "'";
+            return false;
+        }
+        light.type = type == "spot" ? SceneLightType::Spot : SceneLightType::Point;
+        if (light.type == SceneLightType::Point && node < 0) {
+            error = "point lights have to be placed in a node";
+            return false;
+        }
+        light.node = node;
+        light.ambient = vec3(value["ambient"], light.ambient);
+        light.diffuse = vec3(value["diffuse"], light.diffuse);
+        light.specular = vec3(value["specular"], light.specular);
+        light.constant = (float)value["constant"].asNumber(light.constant);
+        light.linear = (float)value["linear"].asNumber(light.linear);
+        light.quadratic = (float)value["quadratic"].asNumber(light.quadratic);
+        light.cutOffDegrees = (float)value["cutOff"].asNumber(light.cutOffDegrees);
+        light.outerCutOffDegrees = (float)value["outerCutOff"].asNumber(light.outerCutOffDegrees);
+        scene.lights.push_back(light);
+        return true;
+    }
+};
+
+};
+#endif //PROJECT_BASE_SCENEFILE_H
@@ -0,0 +1,154 @@
+#ifndef PROJECT_BASE_SCENEGRAPH_H
+#define PROJECT_BASE_SCENEGRAPH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <rg/Error.h>
+#include <rg/JobSystem.h>
+
+namespace rg {
+
+// Transform hierarchy stored as flat arrays indexed by node id.
+//
+// A node's parent is always added before it, so walking the arrays in id order visits parents
+// before their children and one pass computes every world transform. Changing a local transform
+// only marks the node dirty; update() starts at the first dirty node and recomputes the world
+// transforms (and normal matrices) of dirty nodes and of the nodes below them, everything else
+// is skipped. A scene whose only moving parts are a few lamps therefore updates those lamps'
+// subtrees and leaves the static objects alone, and an update with nothing dirty does no work.
+//
+// Given a JobSystem, update() spreads the normal matrices, an inverse each and most of the cost,
+// over its threads; the world transforms stay one pass in id order since each needs its parent's.
+class SceneGraph {
+public:
+    typedef uint32_t NodeId;
+    static const NodeId None = ~0u;
+
+    struct Stats {
+        // world transforms recomputed by the last update()
+        unsigned int updatedNodes = 0;
+    };
+
+    NodeId add(NodeId parent, const glm::mat4& local = glm::mat4(1.0f)) {
+        ASSERT(parent == None || parent < m_Parents.size(), "Scene graph parent has to be added before its children");
+        NodeId id = (NodeId)m_Parents.size();
+        m_Parents.push_back(parent);
+        m_Locals.push_back(local);
+        m_Worlds.push_back(glm::mat4(1.0f));
+        m_NormalMatrices.push_back(glm::mat4(1.0f));
+        m_Dirty.push_back(1);
+        m_Updated.push_back(0);
+        m_FirstDirty = std::min(m_FirstDirty, id);
+        return id;
+    }
+
+    void reserve(size_t count) {
+        m_Parents.reserve(count);
+        m_Locals.reserve(count);
+        m_Worlds.reserve(count);
+        m_NormalMatrices.reserve(count);
+        m_Dirty.reserve(count);
+        m_Updated.reserve(count);
+    }
+
+    void setLocal(NodeId node, const glm::mat4& local) {
+        m_Locals[node] = local;
+        m_Dirty[node] = 1;
+        m_FirstDirty = std::min(m_FirstDirty, node);
+    }
+
+    const glm::mat4& local(NodeId node) const {
+        return m_Locals[node];
+    }
+
+    // Brings the world transforms up to date with the local ones.
+    void update(JobSystem* jobs = nullptr) {
+        m_Version++;
+        m_Stats = Stats();
+        m_UpdatedNodes.clear();
+        NodeId count = (NodeId)m_Parents.size();
+        for (NodeId node = m_FirstDirty; node < count; ++node) {
+            NodeId parent = m_Parents[node];
+            bool parentUpdated = parent != None && m_Updated[parent] == m_Version;
+            if (!m_Dirty[node] && !parentUpdated) {
+                continue;
+            }
+            m_Worlds[node] = parent != None ? m_Worlds[parent] * m_Locals[node] : m_Locals[node];
+            m_Dirty[node] = 0;
+            m_Updated[node] = m_Version;
+            m_UpdatedNodes.push_back(node);
+            m_Stats.updatedNodes++;
+        }
+        m_FirstDirty = None;
+
+        auto normalMatrices = [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                NodeId node = m_UpdatedNodes[i];
+                m_NormalMatrices[node] = glm::transpose(glm::inverse(m_Worlds[node]));
+            }
+        };
+        if (jobs && m_UpdatedNodes.size() > ParallelGrain) {
+            jobs->parallelFor(m_UpdatedNodes.size(), ParallelGrain, normalMatrices);
+        } else {
+            normalMatrices(0, m_UpdatedNodes.size());
+        }
+    }
+
+    // world transform as of the last update()
+    const glm::mat4& world(NodeId node) const {
+        return m_Worlds[node];
+    }
+
+    // transpose(inverse(world(node))), for the normals
+    const glm::mat4& normalMatrix(NodeId node) const {
+        return m_NormalMatrices[node];
+    }
+
+    glm::vec3 worldPosition(NodeId node) const {
+        return glm::vec3(m_Worlds[node][3]);
+    }
+
+    // true if the last update() changed the node's world transform
+    bool updated(NodeId node) const {
+        return m_Updated[node] == m_Version;
+    }
+
+    // the nodes whose world transform the last update() changed, in id order
+    const std::vector<NodeId>& updatedNodes() const {
+        return m_UpdatedNodes;
+    }
+
+    NodeId parent(NodeId node) const {
+        return m_Parents[node];
+    }
+
+    size_t size() const {
+        return m_Parents.size();
+    }
+
+    const Stats& stats() const {
+        return m_Stats;
+    }
+
+private:
+    // normal matrices per job
+    static const size_t ParallelGrain = 512;
+
+    std::vector<NodeId> m_Parents;
+    std::vector<glm::mat4> m_Locals;
+    std::vector<glm::mat4> m_Worlds;
+    std::vector<glm::mat4> m_NormalMatrices;
+    std::vector<uint8_t> m_Dirty;
+    // the m_Version of the update() that last changed the world transform
+    std::vector<uint32_t> m_Updated;
+    std::vector<NodeId> m_UpdatedNodes;
+    uint32_t m_Version = 1;
+    NodeId m_FirstDirty = None;
+    Stats m_Stats;
+};
+
+};
+#endif //PROJECT_BASE_SCENEGRAPH_H
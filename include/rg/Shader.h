@@ -12,6 +12,7 @@
 #include <sstream>
 #include <rg/Error.h>
 #include <common.h>
+#include <rg/Vfs.h>
 #include <glm/glm.hpp>
 class Shader {
     unsigned int m_Id;
@@ -22,11 +23,12 @@ public:
         // build and compile our shader program
         // ------------------------------------
         // vertex shader
-        std::string vsString = readFileContents(vertexShaderPath);
-        ASSERT(!vsString.empty(), "Vertex shader source is empty!");
-        const char* vertexShaderSource = vsString.c_str();
+        rg::VfsFile vsFile = rg::Vfs::instance().open(vertexShaderPath);
+        ASSERT(vsFile.size() != 0, "Vertex shader source is empty!");
+        const char* vertexShaderSource = vsFile.begin();
+        GLint vertexShaderLength = (GLint)vsFile.size();
         int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+        glShaderSource(vertexShader, 1, &vertexShaderSource, &vertexShaderLength);
         glCompileShader(vertexShader);
         // check for shader compile errors
         int success;
@@ -39,10 +41,11 @@ public:
         }
         // fragment shader
         int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        std::string fsString = readFileContents(fragmentShaderPath);
-        ASSERT(!fsString.empty(), "Fragment shader empty!");
-        const char* fragmentShaderSource = fsString.c_str();
-        glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+        rg::VfsFile fsFile = rg::Vfs::instance().open(fragmentShaderPath);
+        ASSERT(fsFile.size() != 0, "Fragment shader empty!");
+        const char* fragmentShaderSource = fsFile.begin();
+        GLint fragmentShaderLength = (GLint)fsFile.size();
+        glShaderSource(fragmentShader, 1, &fragmentShaderSource, &fragmentShaderLength);
         glCompileShader(fragmentShader);
         // check for shader compile errors
         glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
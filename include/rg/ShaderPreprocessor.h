@@ -0,0 +1,136 @@
+#ifndef PROJECT_BASE_SHADERPREPROCESSOR_H
+#define PROJECT_BASE_SHADERPREPROCESSOR_H
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <rg/FileView.h>
+#include <rg/Vfs.h>
+
+namespace rg {
+
+// A shader stage with its includes resolved.
+struct ShaderSource {
+    std::string text;
+    // every file the text was built from, the stage's own file first. A "#line N i" directive
+    // in text refers to files[i], which is also what the source string number in the driver's
+    // error messages means.
+    std::vector<std::string> files;
+};
+
+// Resolves #include "file" in GLSL sources, which the GL doesn't support itself.
+//
+// Include paths are relative to the including file. A file containing #pragma once is inserted
+// only the first time it is included; #ifndef guards work as well, through the GLSL preprocessor.
+// #line directives are written around every inserted file so compile errors point at the file
+// and line they come from. The list of files feeds hot reload, and since the program cache key
+// hashes the resolved text, editing an included file also selects a new cache entry.
+class ShaderPreprocessor {
+public:
+    static const int MaxDepth = 32;
+
+    // fromDisk reads loose files even when a pack is mounted, for hot reload.
+    static bool process(const std::string& path, ShaderSource& source, bool fromDisk = false) {
+        source = ShaderSource();
+        std::vector<std::string> once;
+        return append(path, source, once, fromDisk, 0);
+    }
+
+private:
+    static bool read(const std::string& path, bool fromDisk, std::string& contents) {
+        if (fromDisk) {
+            FileView file(path);
+            contents.assign(file.begin(), file.end());
+            return file.isOpen();
+        }
+        VfsFile file = Vfs::instance().open(path);
+        contents.assign(file.begin(), file.end());
+        return file.isOpen();
+    }
+
+    static std::string directoryOf(const std::string& path) {
+        size_t slash = path.find_last_of('/');
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    // the directive's argument if line is a preprocessor directive with that name, e.g. "#  include <a>"
+    static bool directive(const std::string& line, const char* name, std::string& argument) {
+        size_t i = line.find_first_not_of(" \t");
+        if (i == std::string::npos || line[i] != '#') {
+            return false;
+        }
+        i = line.find_first_not_of(" \t", i + 1);
+        size_t length = std::strlen(name);
+        if (i == std::string::npos || line.compare(i, length, name) != 0) {
+            return false;
+        }
+        i += length;
+        if (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r') {
+            return false;
+        }
+        size_t first = line.find_first_not_of(" \t", i);
+        size_t last = line.find_last_not_of(" \t\r");
+        argument = first != std::string::npos && first <= last ? line.substr(first, last + 1 - first) : std::string();
+        return true;
+    }
+
+    static bool append(const std::string& path, ShaderSource& source, std::vector<std::string>& once,
+                       bool fromDisk, int depth) {
+        std::string name = Vfs::entryName(path);
+        if (std::find(once.begin(), once.end(), name) != once.end()) {
+            return true;
+        }
+        if (depth > MaxDepth) {
+            std::cout << "ERROR::SHADER::INCLUDE_TOO_DEEP " << path << " (circular #include?)" << std::endl;
+            return false;
+        }
+        std::string contents;
+        if (!read(path, fromDisk, contents)) {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+            return false;
+        }
+        size_t fileIndex = source.files.size();
+        source.files.push_back(path);
+        if (depth > 0) {
+            source.text += "#line 1 " + std::to_string(fileIndex) + "\n";
+        }
+
+        size_t lineNumber = 0;
+        for (size_t start = 0; start < contents.size();) {
+            size_t end = contents.find('\n', start);
+            end = end == std::string::npos ? contents.size() : end;
+            std::string line = contents.substr(start, end - start);
+            start = end + 1;
+            ++lineNumber;
+
+            std::string argument;
+            if (directive(line, "pragma", argument) && argument == "once") {
+                once.push_back(name);
+                source.text += "\n";
+                continue;
+            }
+            if (!directive(line, "include", argument)) {
+                source.text += line;
+                source.text += "\n";
+                continue;
+            }
+            if (argument.size() < 2 || !((argument.front() == '"' && argument.back() == '"') ||
+                                         (argument.front() == '<' && argument.back() == '>'))) {
+                std::cout << "ERROR::SHADER::BAD_INCLUDE " << path << ":" << lineNumber << ": " << line << std::endl;
+                return false;
+            }
+            std::string included = directoryOf(path) + argument.substr(1, argument.size() - 2);
+            if (!append(included, source, once, fromDisk, depth + 1)) {
+                std::cout << "  included from " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            source.text += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+        }
+        return true;
+    }
+};
+
+};
+#endif //PROJECT_BASE_SHADERPREPROCESSOR_H
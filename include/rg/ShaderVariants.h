@@ -0,0 +1,85 @@
+#ifndef PROJECT_BASE_SHADERVARIANTS_H
+#define PROJECT_BASE_SHADERVARIANTS_H
+
+#include <learnopengl/shader_m.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace rg {
+
+// Preprocessor defines a shader variant is compiled with. Kept sorted by name, so the same set
+// always produces the same source text and with it the same program cache entry.
+class ShaderDefines {
+public:
+    ShaderDefines& set(const std::string& name, int value) {
+        m_Values[name] = std::to_string(value);
+        return *this;
+    }
+
+    // defines name (as 1) or leaves it undefined, for #ifdef switches
+    ShaderDefines& enable(const std::string& name, bool enabled) {
+        if (enabled) {
+            m_Values[name] = "1";
+        } else {
+            m_Values.erase(name);
+        }
+        return *this;
+    }
+
+    std::string source() const {
+        std::string result;
+        for (const auto& define : m_Values) {
+            result += "#define " + define.first + " " + define.second + "\n";
+        }
+        return result;
+    }
+
+private:
+    std::map<std::string, std::string> m_Values;
+};
+
+// Compiled permutations of one vertex/fragment pair, keyed by their defines.
+//
+// Features are selected with #ifdef in the shader instead of uniforms branched on per fragment,
+// so each variant only contains the work it does. A variant is compiled the first time it is
+// requested; requesting the ones a toggle can switch to at startup submits their compiles
+// together with the rest, after which switching is a map lookup.
+class ShaderVariants {
+public:
+    ShaderVariants(std::string vertexPath, std::string fragmentPath)
+    : m_VertexPath(std::move(vertexPath)), m_FragmentPath(std::move(fragmentPath)) {
+    }
+
+    // The returned shader lives as long as this object.
+    Shader& get(const ShaderDefines& defines) {
+        std::string source = defines.source();
+        auto it = m_Variants.find(source);
+        if (it == m_Variants.end()) {
+            std::unique_ptr<Shader> shader(new Shader(m_VertexPath.c_str(), m_FragmentPath.c_str(), source));
+            it = m_Variants.emplace(source, std::move(shader)).first;
+        }
+        return *it->second;
+    }
+
+    size_t size() const {
+        return m_Variants.size();
+    }
+
+    template<typename Function>
+    void forEach(Function function) {
+        for (auto& variant : m_Variants) {
+            function(*variant.second);
+        }
+    }
+
+private:
+    std::string m_VertexPath;
+    std::string m_FragmentPath;
+    std::map<std::string, std::unique_ptr<Shader>> m_Variants;
+};
+
+};
+#endif //PROJECT_BASE_SHADERVARIANTS_H
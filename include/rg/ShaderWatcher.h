@@ -0,0 +1,132 @@
+#ifndef PROJECT_BASE_SHADERWATCHER_H
+#define PROJECT_BASE_SHADERWATCHER_H
+
+#include <learnopengl/shader_m.h>
+
+#include <functional>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <rg/ShaderVariants.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace rg {
+
+// Rebuilds shaders whose source files change on disk, for editing them while the program runs.
+//
+// The shader directory is watched with inotify (non-blocking, Linux only, elsewhere nothing is
+// ever reported). update() runs at the frame boundary on the render thread: it collects what
+// changed since the last frame and reloads every watched shader built from one of those files.
+// Shader::reload only swaps the program once the new one linked, a broken edit prints its
+// errors and the frame keeps rendering with the previous program.
+class ShaderWatcher {
+public:
+    explicit ShaderWatcher(const std::string& directory) : m_Directory(directory) {
+#ifdef __linux__
+        m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_Fd >= 0 && inotify_add_watch(m_Fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            close(m_Fd);
+            m_Fd = -1;
+        }
+#endif
+        if (m_Fd < 0) {
+            std::cout << "ShaderWatcher: can't watch " << directory << ", shader hot reload is off" << std::endl;
+        }
+    }
+
+    ~ShaderWatcher() {
+#ifdef __linux__
+        if (m_Fd >= 0) {
+            close(m_Fd);
+        }
+#endif
+    }
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    void watch(Shader& shader) {
+        m_Shaders.push_back(&shader);
+    }
+
+    // includes variants compiled after this call
+    void watch(ShaderVariants& variants) {
+        m_Variants.push_back(&variants);
+    }
+
+    // Reloads the shaders affected by changes since the last call, returns how many were replaced.
+    // A shader built from several changed files is reloaded once.
+    unsigned int update() {
+        std::set<std::string> changed = readChanges();
+        if (changed.empty()) {
+            return 0;
+        }
+        // the affected shaders in watch order, each with the first changed file it depends on
+        std::vector<std::pair<Shader*, std::string>> affected;
+        std::set<Shader*> seen;
+        auto collect = [&](Shader& shader) {
+            for (const std::string& path : changed) {
+                if (shader.dependsOn(path)) {
+                    if (seen.insert(&shader).second) {
+                        affected.emplace_back(&shader, path);
+                    }
+                    return;
+                }
+            }
+        };
+        for (Shader* shader : m_Shaders) {
+            collect(*shader);
+        }
+        for (ShaderVariants* variants : m_Variants) {
+            variants->forEach(collect);
+        }
+
+        unsigned int reloaded = 0;
+        for (const auto& entry : affected) {
+            bool success = entry.first->reload();
+            reloaded += success;
+            std::cout << (success ? "Reloaded shader after a change to " : "Failed to reload shader after a change to ")
+                      << entry.second << std::endl;
+        }
+        return reloaded;
+    }
+
+private:
+    std::string m_Directory;
+    int m_Fd = -1;
+    std::vector<Shader*> m_Shaders;
+    std::vector<ShaderVariants*> m_Variants;
+
+    // an editor saving a file usually produces several events, they collapse into one path here
+    std::set<std::string> readChanges() {
+        std::set<std::string> changed;
+#ifdef __linux__
+        if (m_Fd < 0) {
+            return changed;
+        }
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            ssize_t length = read(m_Fd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break;
+            }
+            for (char* cursor = buffer; cursor < buffer + length;) {
+                const inotify_event* event = (const inotify_event*)cursor;
+                if (event->len > 0 && !(event->mask & IN_ISDIR)) {
+                    changed.insert(m_Directory + "/" + event->name);
+                }
+                cursor += sizeof(inotify_event) + event->len;
+            }
+        }
+#endif
+        return changed;
+    }
+};
+
+};
+#endif //PROJECT_BASE_SHADERWATCHER_H
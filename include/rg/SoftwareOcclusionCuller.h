@@ -0,0 +1,362 @@
+#ifndef PROJECT_BASE_SOFTWAREOCCLUSIONCULLER_H
+#define PROJECT_BASE_SOFTWAREOCCLUSIONCULLER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <rg/Bounds.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RG_OCCLUSION_SSE2 1
+#endif
+
+namespace rg {
+
+// Occlusion culling on the CPU, for drivers that rasterize in software (llvmpipe), where a GPU
+// occlusion query costs about as much as drawing what it tests.
+//
+// A few large occluders, given as boxes that lie inside solid geometry (the table top, the
+// floor), are rasterized into a Width x Height depth buffer, four pixels at a time with SSE2
+// where available. Each pyramid level above it keeps the farthest depth of the 2x2 texels below,
+// so testing an instance projects its bounds, picks the level at which the screen rectangle spans
+// at most 4x4 texels, and calls it occluded if its nearest point is behind all of them. Bounds
+// that cross the near plane or lie off screen are never occluded.
+//
+// begin() hands the occluders to a worker thread (started by the first begin()) and returns; the
+// renderer sets up the rest of the frame (texture uploads, uniforms) while the driver may still be
+// drawing the previous one, and calls wait() right before it needs the results.
+class SoftwareOcclusionCuller {
+public:
+    static const int Width = 256;
+    static const int Height = 128;
+    // down to 2x1
+    static const int Levels = 8;
+
+    struct Occluder {
+        glm::mat4 transform;
+        // in the space transform maps from
+        Aabb box;
+    };
+
+    struct Stats {
+        unsigned int occluderTriangles = 0;
+        // time the worker spent on the last frame's depth buffer and pyramid
+        double rasterMilliseconds = 0.0;
+    };
+
+    SoftwareOcclusionCuller() {
+        for (int level = 0; level < Levels; ++level) {
+            m_Levels[level].assign((size_t)levelWidth(level) * levelHeight(level), 1.0f);
+        }
+    }
+
+    ~SoftwareOcclusionCuller() {
+        if (!m_Worker.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        m_Worker.join();
+    }
+
+    SoftwareOcclusionCuller(const SoftwareOcclusionCuller&) = delete;
+    SoftwareOcclusionCuller& operator=(const SoftwareOcclusionCuller&) = delete;
+
+    // Starts rendering the occluders as seen through viewProjection on the worker thread.
+    void begin(const glm::mat4& viewProjection, const std::vector<Occluder>& occluders) {
+        // a renderer on the GPU occlusion path never gets here and never pays for the thread
+        if (!m_Worker.joinable()) {
+            m_Worker = std::thread([this]() { run(); });
+        }
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_ViewProjection = viewProjection;
+            m_Occluders = occluders;
+            m_Busy = true;
+        }
+        m_Wake.notify_all();
+    }
+
+    // Blocks until the depth pyramid of the last begin() is complete.
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Done.wait(lock, [this]() { return !m_Busy; });
+    }
+
+    // True if the bounds are hidden behind the occluders. Only between wait() and the next begin(),
+    // from any number of threads.
+    bool occluded(const Aabb& bounds) const {
+        if (bounds.empty()) {
+            return false;
+        }
+        glm::vec3 ndcMin(FLT_MAX);
+        glm::vec3 ndcMax(-FLT_MAX);
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec4 clip = m_ViewProjection * glm::vec4(corner & 1 ? bounds.max.x : bounds.min.x,
+                                                          corner & 2 ? bounds.max.y : bounds.min.y,
+                                                          corner & 4 ? bounds.max.z : bounds.min.z, 1.0f);
+            if (clip.w <= 0.0f || clip.z < -clip.w) {
+                return false;
+            }
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+        float left = (ndcMin.x * 0.5f + 0.5f) * Width;
+        float right = (ndcMax.x * 0.5f + 0.5f) * Width;
+        float bottom = (ndcMin.y * 0.5f + 0.5f) * Height;
+        float top = (ndcMax.y * 0.5f + 0.5f) * Height;
+        if (right < 0.0f || left >= Width || top < 0.0f || bottom >= Height) {
+            return false;
+        }
+        int x0 = std::max((int)left, 0);
+        int x1 = std::min((int)right, Width - 1);
+        int y0 = std::max((int)bottom, 0);
+        int y1 = std::min((int)top, Height - 1);
+
+        // at most 4x4 texels: a coarser level reads less but its texels reach further past the
+        // bounds, over pixels no occluder covers
+        int level = 0;
+        while (level < Levels - 1 && ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3)) {
+            ++level;
+        }
+        const float* depth = m_Levels[level].data();
+        int width = levelWidth(level);
+        float farthest = 0.0f;
+        for (int y = y0 >> level; y <= y1 >> level; ++y) {
+            for (int x = x0 >> level; x <= x1 >> level; ++x) {
+                farthest = std::max(farthest, depth[y * width + x]);
+            }
+        }
+        return ndcMin.z > farthest;
+    }
+
+    const Stats& stats() const {
+        return m_Stats;
+    }
+
+    // the full resolution depth buffer, NDC depth with 1 where no occluder was drawn
+    const std::vector<float>& depth() const {
+        return m_Levels[0];
+    }
+
+private:
+    struct ScreenVertex {
+        float x;
+        float y;
+        float z;
+    };
+
+    std::vector<float> m_Levels[Levels];
+    glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+    std::vector<Occluder> m_Occluders;
+    Stats m_Stats;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::condition_variable m_Done;
+    bool m_Busy = false;
+    bool m_Stop = false;
+    std::thread m_Worker;
+
+    static int levelWidth(int level) {
+        return std::max(Width >> level, 1);
+    }
+
+    static int levelHeight(int level) {
+        return std::max(Height >> level, 1);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (true) {
+            m_Wake.wait(lock, [this]() { return m_Busy || m_Stop; });
+            if (m_Stop) {
+                return;
+            }
+            // begin() doesn't touch the inputs until wait() saw m_Busy go false
+            lock.unlock();
+            render();
+            lock.lock();
+            m_Busy = false;
+            m_Done.notify_all();
+        }
+    }
+
+    void render() {
+        auto start = std::chrono::steady_clock::now();
+        std::fill(m_Levels[0].begin(), m_Levels[0].end(), 1.0f);
+        m_Stats.occluderTriangles = 0;
+        static const uint8_t triangles[36] = {
+                0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,
+                0, 1, 4, 1, 5, 4,  2, 6, 3, 3, 6, 7,
+                0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5,
+        };
+        for (const Occluder& occluder : m_Occluders) {
+            glm::mat4 transform = m_ViewProjection * occluder.transform;
+            glm::vec4 corners[8];
+            for (int corner = 0; corner < 8; ++corner) {
+                corners[corner] = transform * glm::vec4(corner & 1 ? occluder.box.max.x : occluder.box.min.x,
+                                                        corner & 2 ? occluder.box.max.y : occluder.box.min.y,
+                                                        corner & 4 ? occluder.box.max.z : occluder.box.min.z, 1.0f);
+            }
+            // back faces are drawn too: they are farther than the front faces over the same pixels
+            // and so never win the depth test, and it spares getting the winding right for flat boxes
+            for (int i = 0; i < 36; i += 3) {
+                clipTriangle(corners[triangles[i]], corners[triangles[i + 1]], corners[triangles[i + 2]]);
+            }
+        }
+        buildPyramid();
+        m_Stats.rasterMilliseconds =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Clips against the near plane (z >= -w), the other planes are handled by the scissoring in
+    // rasterize(), then draws the one or two triangles that are left.
+    void clipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+        const glm::vec4 input[3] = {a, b, c};
+        glm::vec4 clipped[4];
+        int count = 0;
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec4& from = input[i];
+            const glm::vec4& to = input[(i + 1) % 3];
+            float fromDistance = from.z + from.w;
+            float toDistance = to.z + to.w;
+            if (fromDistance >= 0.0f) {
+                clipped[count++] = from;
+            }
+            if ((fromDistance >= 0.0f) != (toDistance >= 0.0f)) {
+                float t = fromDistance / (fromDistance - toDistance);
+                clipped[count++] = from + (to - from) * t;
+            }
+        }
+        if (count < 3) {
+            return;
+        }
+        ScreenVertex screen[4];
+        for (int i = 0; i < count; ++i) {
+            float inverseW = 1.0f / clipped[i].w;
+            screen[i] = ScreenVertex{(clipped[i].x * inverseW * 0.5f + 0.5f) * Width,
+                                     (clipped[i].y * inverseW * 0.5f + 0.5f) * Height, clipped[i].z * inverseW};
+        }
+        rasterize(screen[0], screen[1], screen[2]);
+        if (count == 4) {
+            rasterize(screen[0], screen[2], screen[3]);
+        }
+    }
+
+    // Writes the nearer of the stored and the triangle's depth at every pixel center inside it.
+    void rasterize(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2) {
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (std::fabs(area) < 1e-6f) {
+            return;
+        }
+        if (area < 0.0f) {
+            std::swap(v1, v2);
+            area = -area;
+        }
+        int minX = std::max((int)std::floor(std::min(v0.x, std::min(v1.x, v2.x))), 0);
+        int maxX = std::min((int)std::ceil(std::max(v0.x, std::max(v1.x, v2.x))), Width - 1);
+        int minY = std::max((int)std::floor(std::min(v0.y, std::min(v1.y, v2.y))), 0);
+        int maxY = std::min((int)std::ceil(std::max(v0.y, std::max(v1.y, v2.y))), Height - 1);
+        if (minX > maxX || minY > maxY) {
+            return;
+        }
+        m_Stats.occluderTriangles++;
+        // rows are processed in groups of four pixels, Width is a multiple of four
+        minX &= ~3;
+
+        // edge functions e = a * x + b * y + c, positive inside, and the depth plane over the
+        // same pixel coordinates
+        float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = -(a0 * v1.x + b0 * v1.y);
+        float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = -(a1 * v2.x + b1 * v2.y);
+        float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = -(a2 * v0.x + b2 * v0.y);
+        float zA = (a0 * v0.z + a1 * v1.z + a2 * v2.z) / area;
+        float zB = (b0 * v0.z + b1 * v1.z + b2 * v2.z) / area;
+        float zC = (c0 * v0.z + c1 * v1.z + c2 * v2.z) / area;
+
+        float* depth = m_Levels[0].data();
+#ifdef RG_OCCLUSION_SSE2
+        const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        for (int y = minY; y <= maxY; ++y) {
+            float py = y + 0.5f;
+            __m128 row0 = _mm_set1_ps(b0 * py + c0);
+            __m128 row1 = _mm_set1_ps(b1 * py + c1);
+            __m128 row2 = _mm_set1_ps(b2 * py + c2);
+            __m128 rowZ = _mm_set1_ps(zB * py + zC);
+            float* line = depth + y * Width;
+            for (int x = minX; x <= maxX; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), row0);
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), row1);
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), row2);
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                           _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0) {
+                    continue;
+                }
+                __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), px), rowZ);
+                __m128 stored = _mm_loadu_ps(line + x);
+                __m128 nearer = _mm_min_ps(stored, z);
+                _mm_storeu_ps(line + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+            }
+        }
+#else
+        for (int y = minY; y <= maxY; ++y) {
+            float py = y + 0.5f;
+            float* line = depth + y * Width;
+            for (int x = minX; x <= maxX; ++x) {
+                float px = x + 0.5f;
+                if (a0 * px + b0 * py + c0 >= 0.0f && a1 * px + b1 * py + c1 >= 0.0f && a2 * px + b2 * py + c2 >= 0.0f) {
+                    line[x] = std::min(line[x], zA * px + zB * py + zC);
+                }
+            }
+        }
+#endif
+    }
+
+    void buildPyramid() {
+        for (int level = 1; level < Levels; ++level) {
+            const float* below = m_Levels[level - 1].data();
+            float* out = m_Levels[level].data();
+            int belowWidth = levelWidth(level - 1);
+            int width = levelWidth(level);
+            int height = levelHeight(level);
+            for (int y = 0; y < height; ++y) {
+                const float* row0 = below + (2 * y) * belowWidth;
+                const float* row1 = below + (2 * y + 1) * belowWidth;
+                int x = 0;
+#ifdef RG_OCCLUSION_SSE2
+                // eight texels of each row below give four here
+                for (; x + 4 <= width; x += 4) {
+                    __m128 left = _mm_max_ps(_mm_loadu_ps(row0 + 2 * x), _mm_loadu_ps(row1 + 2 * x));
+                    __m128 right = _mm_max_ps(_mm_loadu_ps(row0 + 2 * x + 4), _mm_loadu_ps(row1 + 2 * x + 4));
+                    __m128 even = _mm_shuffle_ps(left, right, _MM_SHUFFLE(2, 0, 2, 0));
+                    __m128 odd = _mm_shuffle_ps(left, right, _MM_SHUFFLE(3, 1, 3, 1));
+                    _mm_storeu_ps(out + y * width + x, _mm_max_ps(even, odd));
+                }
+#endif
+                for (; x < width; ++x) {
+                    out[y * width + x] = std::max(std::max(row0[2 * x], row0[2 * x + 1]),
+                                                  std::max(row1[2 * x], row1[2 * x + 1]));
+                }
+            }
+        }
+    }
+};
+
+};
+#endif //PROJECT_BASE_SOFTWAREOCCLUSIONCULLER_H
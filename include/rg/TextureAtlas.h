@@ -0,0 +1,326 @@
+#ifndef PROJECT_BASE_TEXTUREATLAS_H
+#define PROJECT_BASE_TEXTUREATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+
+#include <learnopengl/model.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <rg/Error.h>
+#include <rg/MipChain.h>
+#include <rg/TextureRegistry.h>
+#include <rg/Vfs.h>
+
+// implementation in libs/stb_rect_pack.cpp
+#include <imstb_rectpack.h>
+
+namespace rg {
+
+// Import step that packs small material textures into shared atlas pages and rewrites the
+// texture coordinates of the meshes using them, so those meshes end up with identical texture
+// sets and the render queue can draw them without rebinding.
+//
+// A material (the set of textures a mesh binds) is packed only if all of its textures have the
+// same size, none is larger than maxTextureSize and every mesh using it keeps its UVs inside
+// [0, 1] -- repeating textures like the floor cannot live in an atlas. Materials with the same
+// texture types (e.g. diffuse + specular) share pages, one page texture per type, and each
+// material gets the same rectangle in all of them so a single UV rewrite serves every type.
+//
+// Page textures are owned by TextureRegistry: every mesh texture pointing at a page holds a
+// reference, like a loaded texture, so the page goes away with the last model using it.
+class TextureAtlasBuilder {
+public:
+    struct Stats {
+        unsigned int packedMaterials = 0;
+        unsigned int packedMeshes = 0;
+        unsigned int pages = 0;
+        unsigned int freedTextures = 0;
+    };
+
+    explicit TextureAtlasBuilder(int pageSize = 1024, int maxTextureSize = 512, int padding = 4)
+    : m_PageSize(pageSize), m_MaxTextureSize(maxTextureSize), m_Padding(padding) {
+    }
+
+    void addModel(Model& model) {
+        m_Models.push_back(&model);
+    }
+
+    Stats build() {
+        Stats stats;
+        std::map<std::vector<unsigned int>, Material> materials;
+        std::map<std::string, Image> images;
+
+        for (Model* model : m_Models) {
+            for (Mesh& mesh : model->meshes) {
+                if (mesh.textures.empty() || !hasUnitTexCoords(mesh)) {
+                    continue;
+                }
+                std::vector<unsigned int> ids = textureIds(mesh);
+                auto it = materials.find(ids);
+                if (it == materials.end()) {
+                    Material material;
+                    if (!loadMaterial(*model, mesh, images, material)) {
+                        continue;
+                    }
+                    it = materials.emplace(ids, material).first;
+                }
+                it->second.meshes.push_back(&mesh);
+            }
+        }
+
+        // materials with the same texture types go to the same pages
+        std::map<std::string, std::vector<Material*>> groups;
+        for (auto& entry : materials) {
+            groups[entry.second.signature].push_back(&entry.second);
+        }
+        for (auto& group : groups) {
+            packGroup(group.second, stats);
+        }
+
+        for (auto& entry : materials) {
+            Material& material = entry.second;
+            if (material.page < 0) {
+                continue;
+            }
+            stats.freedTextures += rewriteMeshes(material);
+            ++stats.packedMaterials;
+            stats.packedMeshes += material.meshes.size();
+        }
+        // the meshes hold their own references now
+        for (unsigned int texture : m_PageTextures) {
+            TextureRegistry::instance().release(texture);
+        }
+        m_PageTextures.clear();
+        updateLoadedTextures();
+        return stats;
+    }
+
+private:
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> pixels; // RGBA8
+    };
+
+    struct Material {
+        std::string signature;
+        std::vector<std::string> types;
+        std::vector<const Image*> images;
+        std::vector<Mesh*> meshes;
+        int width = 0;
+        int height = 0;
+        int page = -1;
+        int x = 0;
+        int y = 0;
+        std::vector<unsigned int> pageTextures;
+    };
+
+    int m_PageSize;
+    int m_MaxTextureSize;
+    int m_Padding;
+    std::vector<Model*> m_Models;
+    // one registry reference each while build() runs
+    std::vector<unsigned int> m_PageTextures;
+
+    static std::vector<unsigned int> textureIds(const Mesh& mesh) {
+        std::vector<unsigned int> ids;
+        for (const Texture& texture : mesh.textures) {
+            ids.push_back(texture.id);
+        }
+        return ids;
+    }
+
+    static bool hasUnitTexCoords(const Mesh& mesh) {
+        const float epsilon = 1e-4f;
+        for (const Vertex& vertex : mesh.vertices) {
+            if (vertex.TexCoords.x < -epsilon || vertex.TexCoords.x > 1.0f + epsilon ||
+                vertex.TexCoords.y < -epsilon || vertex.TexCoords.y > 1.0f + epsilon) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool loadMaterial(const Model& model, const Mesh& mesh, std::map<std::string, Image>& images,
+                      Material& material) {
+        for (const Texture& texture : mesh.textures) {
+            std::string path = model.directory + '/' + texture.path;
+            auto it = images.find(path);
+            if (it == images.end()) {
+                Image image;
+                int components;
+                VfsFile file = Vfs::instance().open(path);
+                unsigned char* data = file.isOpen() ? stbi_load_from_memory(file.data(), (int)file.size(), &image.width,
+                                                                            &image.height, &components, 4) : nullptr;
+                if (data) {
+                    image.pixels.assign(data, data + image.width * image.height * 4);
+                    stbi_image_free(data);
+                }
+                it = images.emplace(path, std::move(image)).first;
+            }
+            const Image& image = it->second;
+            if (image.pixels.empty() || image.width > m_MaxTextureSize || image.height > m_MaxTextureSize) {
+                return false;
+            }
+            if (!material.images.empty() && (image.width != material.width || image.height != material.height)) {
+                return false;
+            }
+            material.width = image.width;
+            material.height = image.height;
+            material.images.push_back(&image);
+            material.types.push_back(texture.type);
+            material.signature += texture.type + ';';
+        }
+        return true;
+    }
+
+    void packGroup(std::vector<Material*>& group, Stats& stats) {
+        std::vector<Material*> remaining = group;
+        std::vector<stbrp_node> nodes(m_PageSize);
+
+        while (!remaining.empty()) {
+            std::vector<stbrp_rect> rects(remaining.size());
+            for (size_t i = 0; i < remaining.size(); ++i) {
+                rects[i].id = (int)i;
+                rects[i].w = remaining[i]->width + 2 * m_Padding;
+                rects[i].h = remaining[i]->height + 2 * m_Padding;
+            }
+            stbrp_context context;
+            stbrp_init_target(&context, m_PageSize, m_PageSize, nodes.data(), (int)nodes.size());
+            stbrp_pack_rects(&context, rects.data(), (int)rects.size());
+
+            std::vector<Material*> packed;
+            std::vector<Material*> leftover;
+            for (const stbrp_rect& rect : rects) {
+                Material* material = remaining[rect.id];
+                if (rect.was_packed) {
+                    material->x = rect.x;
+                    material->y = rect.y;
+                    packed.push_back(material);
+                } else {
+                    leftover.push_back(material);
+                }
+            }
+            if (packed.empty()) {
+                break;
+            }
+            // a page holding a single material saves nothing
+            if (packed.size() > 1) {
+                uploadPage(packed, stats.pages++);
+            }
+            remaining.swap(leftover);
+        }
+    }
+
+    void uploadPage(const std::vector<Material*>& packed, int page) {
+        const std::vector<std::string>& types = packed.front()->types;
+        std::vector<unsigned int> pageTextures(types.size());
+        glGenTextures(pageTextures.size(), pageTextures.data());
+        for (unsigned int texture : pageTextures) {
+            TextureRegistry::instance().adopt(texture);
+            m_PageTextures.push_back(texture);
+        }
+
+        std::vector<unsigned char> pixels((size_t)m_PageSize * m_PageSize * 4);
+        for (size_t slot = 0; slot < types.size(); ++slot) {
+            std::fill(pixels.begin(), pixels.end(), 0);
+            for (const Material* material : packed) {
+                blit(*material->images[slot], material->x, material->y, pixels);
+            }
+
+            // stop at the mip level where neighbouring materials would bleed through the gutter
+            std::vector<MipLevel> levels = MipChain::generate(pixels.data(), m_PageSize, m_PageSize, 4,
+                                                              types[slot] == "texture_diffuse");
+            levels.resize(std::min<size_t>(levels.size(), maxMipLevel() + 1));
+
+            glBindTexture(GL_TEXTURE_2D, pageTextures[slot]);
+            MipChain::upload(levels, 4);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        for (Material* material : packed) {
+            material->page = page;
+            material->pageTextures = pageTextures;
+        }
+    }
+
+    int maxMipLevel() const {
+        int level = 0;
+        while ((2 << level) <= m_Padding) {
+            ++level;
+        }
+        return level;
+    }
+
+    // copies the image into the page, extending its border pixels into the padding
+    void blit(const Image& image, int x, int y, std::vector<unsigned char>& pixels) const {
+        int width = image.width + 2 * m_Padding;
+        int height = image.height + 2 * m_Padding;
+        for (int row = 0; row < height; ++row) {
+            int srcRow = std::min(std::max(row - m_Padding, 0), image.height - 1);
+            for (int column = 0; column < width; ++column) {
+                int srcColumn = std::min(std::max(column - m_Padding, 0), image.width - 1);
+                const unsigned char* src = &image.pixels[((size_t)srcRow * image.width + srcColumn) * 4];
+                unsigned char* dst = &pixels[((size_t)(y + row) * m_PageSize + x + column) * 4];
+                std::copy(src, src + 4, dst);
+            }
+        }
+    }
+
+    // points the meshes at the page textures, each replaced texture gives its registry reference back
+    // and each page texture slot takes one
+    unsigned int rewriteMeshes(const Material& material) const {
+        glm::vec2 scale((float)material.width / m_PageSize, (float)material.height / m_PageSize);
+        glm::vec2 offset((float)(material.x + m_Padding) / m_PageSize, (float)(material.y + m_Padding) / m_PageSize);
+
+        unsigned int released = 0;
+        for (Mesh* mesh : material.meshes) {
+            for (Vertex& vertex : mesh->vertices) {
+                vertex.TexCoords = offset + vertex.TexCoords * scale;
+            }
+            mesh->UpdateVertices();
+            for (size_t slot = 0; slot < mesh->textures.size(); ++slot) {
+                if (TextureRegistry::instance().contains(mesh->textures[slot].id) &&
+                    TextureRegistry::instance().release(mesh->textures[slot].id)) {
+                    ++released;
+                }
+                mesh->textures[slot].id = TextureRegistry::instance().retain(material.pageTextures[slot]);
+                mesh->textures[slot].path = "atlas#" + std::to_string(material.page);
+            }
+        }
+        return released;
+    }
+
+    // forgets the textures the registry deleted and lists the pages the meshes use now
+    void updateLoadedTextures() {
+        for (Model* model : m_Models) {
+            std::vector<Texture>& loaded = model->textures_loaded;
+            loaded.erase(std::remove_if(loaded.begin(), loaded.end(), [&](const Texture& texture) {
+                if (TextureRegistry::instance().contains(texture.id)) {
+                    return false;
+                }
+                model->loaded_ids.erase(texture.id);
+                return true;
+            }), loaded.end());
+            for (const Mesh& mesh : model->meshes) {
+                for (const Texture& texture : mesh.textures) {
+                    if (model->loaded_ids.insert(texture.id).second) {
+                        loaded.push_back(texture);
+                    }
+                }
+            }
+        }
+    }
+};
+
+};
+#endif //PROJECT_BASE_TEXTUREATLAS_H
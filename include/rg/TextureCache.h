@@ -0,0 +1,446 @@
+#ifndef PROJECT_BASE_TEXTURECACHE_H
+#define PROJECT_BASE_TEXTURECACHE_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/filesystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <rg/BlockCompression.h>
+#include <rg/GLExtensions.h>
+#include <rg/FileView.h>
+#include <rg/MipChain.h>
+#include <rg/TextureUploadQueue.h>
+#include <rg/Vfs.h>
+#include <memory>
+
+namespace rg {
+
+// On-disk cache of textures with precomputed mip chains.
+//
+// The first time a texture is loaded it is decoded, its mip chain is built on the CPU (see
+// MipChain) and, when S3TC is supported, compressed (BC1 for RGB, BC3 for RGBA, BC4/BC5 for
+// one/two channel images). The levels are written as a KTX 1.1 file under cache/textures.
+// Later loads map that file and upload it level by level, with glCompressedTexImage2D for
+// compressed entries. An entry is rebuilt when the size or modification time of its source
+// image changes, both are stored in the KTX key/value data.
+//
+// With streamMips set and an upload queue given only the levels up to residentSize are
+// uploaded at load time. The texture starts out sampling those through GL_TEXTURE_BASE_LEVEL
+// and the larger levels go through the queue, each lowering the base level once it is issued.
+class TextureCache {
+public:
+    struct Options {
+        bool enabled = true;
+        bool compress = true;
+        bool streamMips = false;
+        int residentSize = 64;
+        TextureUploadQueue* uploadQueue = nullptr;
+    };
+
+    struct Stats {
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        double hitMilliseconds = 0.0;
+        double missMilliseconds = 0.0;
+        double decodeMilliseconds = 0.0;
+        size_t compressedBytes = 0;
+        size_t uncompressedBytes = 0;
+    };
+
+    static Options& options() {
+        static Options value;
+        return value;
+    }
+
+    // snapshot of the counters, which the loader thread and the conversion workers update
+    static Stats stats() {
+        const Counters& c = counters();
+        Stats s;
+        s.hits = c.hits.load(std::memory_order_relaxed);
+        s.misses = c.misses.load(std::memory_order_relaxed);
+        s.hitMilliseconds = c.hitMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+        s.missMilliseconds = c.missMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+        s.decodeMilliseconds = c.decodeMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+        s.compressedBytes = c.compressedBytes.load(std::memory_order_relaxed);
+        s.uncompressedBytes = c.uncompressedBytes.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Uploads the image at path into texture, returns false if the texture has to be loaded
+    // the regular way (cache disabled or an unreadable image). srgb selects gamma correct
+    // filtering of the color channels when the mip chain is built.
+    static bool load(const std::string& path, unsigned int texture, bool srgb) {
+        if (!options().enabled) {
+            return false;
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::string stamp = sourceStamp(path);
+        if (stamp.empty()) {
+            return false;
+        }
+
+        bool compress = options().compress && hasExtension("GL_EXT_texture_compression_s3tc");
+        std::string cachePath = cacheFilePath(path, compress, srgb);
+        if (uploadCached(cachePath, stamp, texture)) {
+            counters().hits++;
+            counters().hitMicroseconds += microsecondsSince(start);
+            return true;
+        }
+        if (!build(path, cachePath, stamp, compress, srgb) || !uploadCached(cachePath, stamp, texture)) {
+            return false;
+        }
+        counters().misses++;
+        counters().missMicroseconds += microsecondsSince(start);
+        return true;
+    }
+
+    static void printStats() {
+        Stats s = stats();
+        std::cout << "Texture cache: " << s.hits << " hits in " << s.hitMilliseconds << " ms, "
+                  << s.misses << " misses in " << s.missMilliseconds << " ms ("
+                  << s.decodeMilliseconds << " ms of it decoding the source images)\n"
+                  << "Texture memory: " << s.compressedBytes / 1024 << " KB as stored, "
+                  << s.uncompressedBytes / 1024 << " KB uncompressed" << std::endl;
+    }
+
+private:
+    struct LevelView {
+        int width;
+        int height;
+        const unsigned char* data;
+        uint32_t size;
+    };
+
+    struct KtxHeader {
+        unsigned char identifier[12];
+        uint32_t endianness;
+        uint32_t glType;
+        uint32_t glTypeSize;
+        uint32_t glFormat;
+        uint32_t glInternalFormat;
+        uint32_t glBaseInternalFormat;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t numberOfArrayElements;
+        uint32_t numberOfFaces;
+        uint32_t numberOfMipmapLevels;
+        uint32_t bytesOfKeyValueData;
+    };
+
+    static const unsigned char* ktxIdentifier() {
+        static const unsigned char identifier[12] = {
+            0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+        };
+        return identifier;
+    }
+
+    static const char* stampKey() {
+        return "rg.source";
+    }
+
+    // Stats as atomics, times in microseconds so they can be summed without a lock
+    struct Counters {
+        std::atomic<unsigned int> hits{0};
+        std::atomic<unsigned int> misses{0};
+        std::atomic<uint64_t> hitMicroseconds{0};
+        std::atomic<uint64_t> missMicroseconds{0};
+        std::atomic<uint64_t> decodeMicroseconds{0};
+        std::atomic<size_t> compressedBytes{0};
+        std::atomic<size_t> uncompressedBytes{0};
+    };
+
+    static Counters& counters() {
+        static Counters value;
+        return value;
+    }
+
+    static uint64_t microsecondsSince(std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+
+    static std::string sourceStamp(const std::string& path) {
+        return Vfs::instance().stamp(path);
+    }
+
+    static std::string cacheDirectory() {
+        return FileSystem::getPath("cache/textures");
+    }
+
+    static std::string cacheFilePath(const std::string& path, bool compressed, bool srgb) {
+        std::string name = path;
+        for (char& c : name) {
+            if (c == '/' || c == '\\' || c == ':' || c == ' ') {
+                c = '_';
+            }
+        }
+        return cacheDirectory() + "/" + name + (srgb ? ".srgb" : "") + (compressed ? ".bc" : "") + ".ktx";
+    }
+
+    static void makeDirectories(const std::string& path) {
+        for (size_t i = 1; i <= path.size(); ++i) {
+            if (i == path.size() || path[i] == '/') {
+                mkdir(path.substr(0, i).c_str(), 0755);
+            }
+        }
+    }
+
+    static bc::Format formatFor(int components) {
+        switch (components) {
+            case 1: return bc::Format::BC4;
+            case 2: return bc::Format::BC5;
+            case 3: return bc::Format::BC1;
+        }
+        return bc::Format::BC3;
+    }
+
+    static GLenum internalFormat(bc::Format format) {
+        switch (format) {
+            case bc::Format::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case bc::Format::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case bc::Format::BC4: return GL_COMPRESSED_RED_RGTC1;
+            case bc::Format::BC5: return GL_COMPRESSED_RG_RGTC2;
+        }
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+
+    static GLenum uncompressedFormat(int components) {
+        switch (components) {
+            case 1: return GL_R8;
+            case 2: return GL_RG8;
+            case 3: return GL_RGB8;
+        }
+        return GL_RGBA8;
+    }
+
+    // KTX requires uncompressed rows to be padded to four bytes
+    static std::vector<unsigned char> padRows(const MipLevel& level, int components) {
+        size_t rowSize = (size_t)level.width * components;
+        size_t paddedRowSize = (rowSize + 3) / 4 * 4;
+        if (rowSize == paddedRowSize) {
+            return level.pixels;
+        }
+        std::vector<unsigned char> result(paddedRowSize * level.height, 0);
+        for (int y = 0; y < level.height; ++y) {
+            std::copy(level.pixels.begin() + y * rowSize, level.pixels.begin() + (y + 1) * rowSize,
+                      result.begin() + y * paddedRowSize);
+        }
+        return result;
+    }
+
+    static bool build(const std::string& path, const std::string& cachePath, const std::string& stamp,
+                      bool compress, bool srgb) {
+        auto decodeStart = std::chrono::steady_clock::now();
+        int width, height, components;
+        VfsFile file = Vfs::instance().open(path);
+        unsigned char* data = file.isOpen() ? stbi_load_from_memory(file.data(), (int)file.size(), &width, &height,
+                                                                    &components, 0) : nullptr;
+        if (!data) {
+            return false;
+        }
+        counters().decodeMicroseconds += microsecondsSince(decodeStart);
+        std::vector<MipLevel> mips = MipChain::generate(data, width, height, components, srgb);
+        stbi_image_free(data);
+
+        bc::Format format = formatFor(components);
+        std::vector<std::vector<unsigned char>> levels;
+        for (const MipLevel& mip : mips) {
+            if (compress) {
+                levels.push_back(bc::compress(format, mip.pixels.data(), mip.width, mip.height, components));
+            } else {
+                levels.push_back(padRows(mip, components));
+            }
+        }
+
+        std::string keyValue = std::string(stampKey()) + '\0' + stamp + '\0';
+        uint32_t keyValueSize = keyValue.size();
+        keyValue.resize((keyValue.size() + 3) / 4 * 4, '\0');
+
+        KtxHeader header;
+        std::memcpy(header.identifier, ktxIdentifier(), sizeof(header.identifier));
+        header.endianness = 0x04030201;
+        header.glType = compress ? 0 : GL_UNSIGNED_BYTE;
+        header.glTypeSize = 1;
+        header.glFormat = compress ? 0 : MipChain::format(components);
+        header.glInternalFormat = compress ? internalFormat(format) : uncompressedFormat(components);
+        header.glBaseInternalFormat = MipChain::format(components);
+        header.pixelWidth = width;
+        header.pixelHeight = height;
+        header.pixelDepth = 0;
+        header.numberOfArrayElements = 0;
+        header.numberOfFaces = 1;
+        header.numberOfMipmapLevels = levels.size();
+        header.bytesOfKeyValueData = sizeof(uint32_t) + keyValue.size();
+
+        makeDirectories(cacheDirectory());
+        std::string temporaryPath = cachePath + ".tmp";
+        std::ofstream out(temporaryPath, std::ios::binary);
+        if (!out) {
+            return false;
+        }
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)&keyValueSize, sizeof(keyValueSize));
+        out.write(keyValue.data(), keyValue.size());
+        for (const std::vector<unsigned char>& level : levels) {
+            uint32_t imageSize = level.size();
+            out.write((const char*)&imageSize, sizeof(imageSize));
+            out.write((const char*)level.data(), level.size());
+        }
+        out.close();
+        // the rename makes a half written entry impossible to observe
+        return out.good() && std::rename(temporaryPath.c_str(), cachePath.c_str()) == 0;
+    }
+
+    static bool uploadCached(const std::string& cachePath, const std::string& stamp, unsigned int texture) {
+        std::shared_ptr<FileView> file = std::make_shared<FileView>(cachePath);
+        if (!file->isOpen() || file->size() < sizeof(KtxHeader)) {
+            return false;
+        }
+        KtxHeader header;
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.identifier, ktxIdentifier(), sizeof(header.identifier)) != 0 ||
+            header.endianness != 0x04030201 || header.numberOfMipmapLevels == 0) {
+            return false;
+        }
+
+        const unsigned char* cursor = file->data() + sizeof(KtxHeader);
+        const unsigned char* end = file->data() + file->size();
+        if (!validStamp(cursor, header.bytesOfKeyValueData, end, stamp)) {
+            return false;
+        }
+        cursor += header.bytesOfKeyValueData;
+
+        std::vector<LevelView> levels;
+        int width = header.pixelWidth;
+        int height = header.pixelHeight;
+        size_t stored = 0;
+        for (uint32_t level = 0; level < header.numberOfMipmapLevels; ++level) {
+            if (cursor + sizeof(uint32_t) > end) {
+                return false;
+            }
+            uint32_t imageSize;
+            std::memcpy(&imageSize, cursor, sizeof(imageSize));
+            cursor += sizeof(uint32_t);
+            if (cursor + imageSize > end) {
+                return false;
+            }
+            levels.push_back(LevelView{width, height, cursor, imageSize});
+            cursor += (imageSize + 3) / 4 * 4;
+            stored += imageSize;
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+
+        // with streaming only the small levels go up now, the upload queue brings in the rest
+        int firstLevel = 0;
+        if (options().streamMips && options().uploadQueue) {
+            while (firstLevel + 1 < (int)levels.size() &&
+                   std::max(levels[firstLevel].width, levels[firstLevel].height) > options().residentSize) {
+                ++firstLevel;
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, texture);
+        for (int level = 0; level < (int)levels.size(); ++level) {
+            if (level < firstLevel) {
+                // allocate only, the contents arrive through the queue
+                uploadLevel(header, level, LevelView{levels[level].width, levels[level].height, nullptr, levels[level].size});
+            } else {
+                uploadLevel(header, level, levels[level]);
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+        if (firstLevel > 0) {
+            // the queue may be updated on another context, which has to see the allocated levels first
+            std::shared_ptr<__GLsync> allocated(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+                                                [](GLsync sync) { glDeleteSync(sync); });
+            glFlush();
+            for (int level = firstLevel - 1; level >= 0; --level) {
+                options().uploadQueue->push(streamRequest(header, texture, level, levels[level], file, allocated));
+            }
+        }
+
+        int components = header.glBaseInternalFormat == GL_RED ? 1 : (header.glBaseInternalFormat == GL_RG ? 2 :
+                         (header.glBaseInternalFormat == GL_RGB ? 3 : 4));
+        counters().compressedBytes += stored;
+        counters().uncompressedBytes += (size_t)header.pixelWidth * header.pixelHeight * components * 4 / 3;
+        return true;
+    }
+
+    static TextureUploadQueue::Request streamRequest(const KtxHeader& header, unsigned int texture, int level,
+                                                     const LevelView& view, const std::shared_ptr<FileView>& file,
+                                                     const std::shared_ptr<__GLsync>& allocated) {
+        TextureUploadQueue::Request request;
+        request.texture = texture;
+        request.level = level;
+        request.width = view.width;
+        request.height = view.height;
+        request.data = view.data;
+        request.owner = file;
+        request.ready = allocated;
+        if (header.glType == 0) {
+            request.format = header.glInternalFormat;
+            request.type = 0;
+            request.rowSize = view.size / ((view.height + 3) / 4);
+        } else {
+            request.format = header.glFormat;
+            request.type = header.glType;
+            request.rowSize = view.size / view.height;
+        }
+        // levels arrive smallest first, so each one can lower the base level
+        request.onComplete = [texture, level] {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+        };
+        return request;
+    }
+
+    static void uploadLevel(const KtxHeader& header, int level, const LevelView& view) {
+        if (header.glType == 0) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, header.glInternalFormat, view.width, view.height, 0,
+                                   view.size, view.data);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, level, header.glInternalFormat, view.width, view.height, 0,
+                         header.glFormat, header.glType, view.data);
+        }
+    }
+
+    static bool validStamp(const unsigned char* cursor, uint32_t size, const unsigned char* end,
+                           const std::string& stamp) {
+        const unsigned char* keyValueEnd = cursor + size;
+        if (keyValueEnd > end) {
+            return false;
+        }
+        while (cursor + sizeof(uint32_t) <= keyValueEnd) {
+            uint32_t pairSize;
+            std::memcpy(&pairSize, cursor, sizeof(pairSize));
+            const char* pair = (const char*)cursor + sizeof(uint32_t);
+            if ((const unsigned char*)pair + pairSize > keyValueEnd) {
+                return false;
+            }
+            size_t keyLength = strnlen(pair, pairSize);
+            if (keyLength < pairSize && std::strcmp(pair, stampKey()) == 0) {
+                return std::string(pair + keyLength + 1, strnlen(pair + keyLength + 1, pairSize - keyLength - 1)) == stamp;
+            }
+            cursor += sizeof(uint32_t) + (pairSize + 3) / 4 * 4;
+        }
+        return false;
+    }
+};
+
+};
+#endif //PROJECT_BASE_TEXTURECACHE_H
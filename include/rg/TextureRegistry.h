@@ -0,0 +1,283 @@
+#ifndef PROJECT_BASE_TEXTUREREGISTRY_H
+#define PROJECT_BASE_TEXTUREREGISTRY_H
+
+#include <glad/glad.h>
+
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <rg/Error.h>
+#include <rg/TextureCache.h>
+#include <rg/Vfs.h>
+
+// defined in learnopengl/model.h
+unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma);
+
+namespace rg {
+
+// Process wide cache of loaded textures, shared by every Model.
+//
+// Textures are found by canonical path, size and modification time first. On a miss the file
+// contents are hashed, but only if an image of the same size is loaded already, as no other can
+// be a copy of it; otherwise the file isn't read here at all and TextureFromFile gets it from the
+// texture cache. So the same image reached through different paths or copied next to another
+// model is still loaded once. Every acquire() takes a reference and every release() drops one;
+// the texture is deleted when the last reference goes away. The lock is only held for lookups,
+// not while files are read or textures loaded, so models can be loaded on background threads
+// while the render thread releases textures.
+class TextureRegistry {
+public:
+    struct Stats {
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        unsigned int evictions = 0;
+        // size of the source files that did not have to be read and decoded again
+        size_t bytesSaved = 0;
+    };
+
+    static TextureRegistry& instance() {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    // Returns the texture for the image at path with one more reference.
+    unsigned int acquire(const std::string& path, bool srgb) {
+        // an image changed on disk gets a new key and loads again
+        std::string stamp = Vfs::instance().stamp(path);
+        std::string key = canonicalPath(path) + '#' + stamp + (srgb ? "#srgb" : "");
+        size_t fileSize = std::strtoull(stamp.c_str(), nullptr, 10);
+        uint64_t sizeKey = stamp.empty() ? NoSize : (uint64_t)fileSize << 1 | (srgb ? 1 : 0);
+
+        unsigned int id;
+        std::vector<std::pair<unsigned int, std::string>> unhashed;
+        bool sameSize = false;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (find(key, false, 0, id)) {
+                return id;
+            }
+            auto range = m_BySize.equal_range(sizeKey);
+            for (auto it = range.first; it != range.second && sizeKey != NoSize; ++it) {
+                sameSize = true;
+                const Entry& entry = m_Entries[it->second];
+                if (!entry.hashed) {
+                    unhashed.emplace_back(it->second, entry.source);
+                }
+            }
+        }
+
+        bool hashed = false;
+        uint64_t contentKey = 0;
+        if (sameSize) {
+            // the loaded images of that size are hashed the first time another one shows up
+            std::vector<std::pair<unsigned int, uint64_t>> loadedKeys;
+            for (const auto& candidate : unhashed) {
+                VfsFile file = Vfs::instance().open(candidate.second);
+                if (file.isOpen()) {
+                    loadedKeys.emplace_back(candidate.first, hashContents(file) ^ (srgb ? 1 : 0));
+                }
+            }
+            VfsFile file = Vfs::instance().open(path);
+            hashed = file.isOpen();
+            contentKey = hashed ? hashContents(file) ^ (srgb ? 1 : 0) : 0;
+            file = VfsFile();
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (const auto& loaded : loadedKeys) {
+                auto it = m_Entries.find(loaded.first);
+                if (it != m_Entries.end() && !it->second.hashed) {
+                    it->second.hashed = true;
+                    it->second.contentKey = loaded.second;
+                    m_ByContent.emplace(loaded.second, loaded.first);
+                }
+            }
+            if (find(key, hashed, contentKey, id)) {
+                return id;
+            }
+        }
+
+        size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+        std::string filename = slash == std::string::npos ? path : path.substr(slash + 1);
+        unsigned int loaded = TextureFromFile(filename.c_str(), directory, srgb);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        // another thread may have loaded the same image meanwhile
+        if (find(key, hashed, contentKey, id)) {
+            glDeleteTextures(1, &loaded);
+            return id;
+        }
+        Entry& entry = m_Entries[loaded];
+        entry.references = 1;
+        entry.bytes = fileSize;
+        entry.source = path;
+        entry.sizeKey = sizeKey;
+        entry.hashed = hashed;
+        entry.contentKey = contentKey;
+        entry.paths.push_back(key);
+        m_ByPath.emplace(key, loaded);
+        if (sizeKey != NoSize) {
+            m_BySize.emplace(sizeKey, loaded);
+        }
+        if (hashed) {
+            m_ByContent.emplace(contentKey, loaded);
+        }
+        ++m_Stats.misses;
+        return loaded;
+    }
+
+    // Takes ownership of a texture created elsewhere (e.g. an atlas page) with one reference, so
+    // release() deletes it like a loaded one. It can't be found by path.
+    void adopt(unsigned int id) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ASSERT(m_Entries.count(id) == 0, "Adopting a texture that is already in the registry");
+        m_Entries[id].references = 1;
+    }
+
+    // Adds a reference to a texture that is in the registry.
+    unsigned int retain(unsigned int id) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Entries.find(id);
+        ASSERT(it != m_Entries.end(), "Retaining a texture that is not in the registry");
+        ++it->second.references;
+        return id;
+    }
+
+    // Drops a reference, returns true if that deleted the texture.
+    bool release(unsigned int id) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Entries.find(id);
+        ASSERT(it != m_Entries.end(), "Releasing a texture that is not in the registry");
+        if (--it->second.references > 0) {
+            return false;
+        }
+        for (const std::string& key : it->second.paths) {
+            m_ByPath.erase(key);
+        }
+        auto range = m_BySize.equal_range(it->second.sizeKey);
+        for (auto bySize = range.first; bySize != range.second; ++bySize) {
+            if (bySize->second == id) {
+                m_BySize.erase(bySize);
+                break;
+            }
+        }
+        auto byContent = it->second.hashed ? m_ByContent.find(it->second.contentKey) : m_ByContent.end();
+        if (byContent != m_ByContent.end() && byContent->second == id) {
+            m_ByContent.erase(byContent);
+        }
+        m_Entries.erase(it);
+        // streamed mip levels still on their way would write into a freed or reused name
+        if (TextureCache::options().uploadQueue) {
+            TextureCache::options().uploadQueue->cancel(id);
+        }
+        glDeleteTextures(1, &id);
+        ++m_Stats.evictions;
+        return true;
+    }
+
+    bool contains(unsigned int id) const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Entries.count(id) != 0;
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+    void printStats() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::cout << "Texture registry: " << m_Entries.size() << " textures, " << m_Stats.hits << " hits, "
+                  << m_Stats.misses << " misses, " << m_Stats.evictions << " evictions, "
+                  << m_Stats.bytesSaved / 1024 << " KB of source images not loaded twice" << std::endl;
+    }
+
+private:
+    // sizeKey of textures that don't come from a file
+    static const uint64_t NoSize = ~0ull;
+
+    struct Entry {
+        unsigned int references = 0;
+        size_t bytes = 0;
+        // path it was loaded from, to hash it once another image of its size is acquired
+        std::string source;
+        // file size and srgb flag
+        uint64_t sizeKey = NoSize;
+        bool hashed = false;
+        uint64_t contentKey = 0;
+        std::vector<std::string> paths;
+    };
+
+    mutable std::mutex m_Mutex;
+    std::unordered_map<std::string, unsigned int> m_ByPath;
+    std::unordered_multimap<uint64_t, unsigned int> m_BySize;
+    std::unordered_map<uint64_t, unsigned int> m_ByContent;
+    std::unordered_map<unsigned int, Entry> m_Entries;
+    Stats m_Stats;
+
+    TextureRegistry() = default;
+
+    // Looks the image up by key and, if hashed, by contents, which also makes key find it from now
+    // on. Takes a reference on a match. Has to be called with the lock held.
+    bool find(const std::string& key, bool hashed, uint64_t contentKey, unsigned int& id) {
+        auto byPath = m_ByPath.find(key);
+        if (byPath != m_ByPath.end()) {
+            id = hit(byPath->second);
+            return true;
+        }
+        auto byContent = hashed ? m_ByContent.find(contentKey) : m_ByContent.end();
+        if (byContent == m_ByContent.end()) {
+            return false;
+        }
+        m_ByPath.emplace(key, byContent->second);
+        m_Entries[byContent->second].paths.push_back(key);
+        id = hit(byContent->second);
+        return true;
+    }
+
+    unsigned int hit(unsigned int id) {
+        Entry& entry = m_Entries[id];
+        ++entry.references;
+        ++m_Stats.hits;
+        m_Stats.bytesSaved += entry.bytes;
+        return id;
+    }
+
+    static std::string canonicalPath(const std::string& path) {
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved)) {
+            return resolved;
+        }
+        // only in a pack
+        return Vfs::entryName(path);
+    }
+
+    // 64-bit multiply/rotate hash over 8-byte words
+    static uint64_t hashContents(const VfsFile& file) {
+        const uint64_t prime = 0x9E3779B97F4A7C15ull;
+        uint64_t hash = file.size() * prime;
+        const unsigned char* data = file.data();
+        size_t size = file.size();
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * prime;
+            hash = (hash << 31) | (hash >> 33);
+        }
+        for (; i < size; ++i) {
+            hash = (hash ^ data[i]) * prime;
+        }
+        return hash ^ (hash >> 29);
+    }
+};
+
+};
+#endif //PROJECT_BASE_TEXTUREREGISTRY_H
@@ -0,0 +1,259 @@
+#ifndef PROJECT_BASE_TEXTUREUPLOADQUEUE_H
+#define PROJECT_BASE_TEXTUREUPLOADQUEUE_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+// Uploads texture levels through pixel unpack buffers, a limited number of bytes per frame.
+//
+// Pixels are copied into one of a few staging buffers and glTexSubImage2D reads them from there,
+// so the driver doesn't have to copy client memory synchronously. Each staging buffer gets a
+// fence after use and is only written again once the GPU is done with it. Levels larger than
+// the budget or a staging buffer are split into row slices spread over several frames.
+// Pending uploads are served smallest level first, so low resolution mips of every texture
+// arrive before the full resolution ones. Requests may be pushed from a loader thread with its
+// own shared context; such a request carries a fence that must signal before its level is written.
+class TextureUploadQueue {
+public:
+    struct Request {
+        unsigned int texture = 0;
+        int level = 0;
+        int width = 0;
+        int height = 0;
+        // pixel format and type, or the compressed internal format with type 0
+        GLenum format = GL_RGBA;
+        GLenum type = GL_UNSIGNED_BYTE;
+        const unsigned char* data = nullptr;
+        // bytes per row, or per row of 4x4 blocks for compressed formats
+        size_t rowSize = 0;
+        int alignment = 4;
+        // keeps data alive until the upload is issued
+        std::shared_ptr<const void> owner;
+        // runs right after the last slice was issued
+        std::function<void()> onComplete;
+        // set when the level storage was allocated on another context, the upload waits for it
+        std::shared_ptr<__GLsync> ready;
+    };
+
+    struct Stats {
+        size_t bytesLastFrame = 0;
+        size_t bytesTotal = 0;
+        unsigned int slicesLastFrame = 0;
+        unsigned int completed = 0;
+    };
+
+    explicit TextureUploadQueue(size_t stagingBufferSize = 2 << 20, unsigned int stagingBuffers = 4)
+    : m_StagingSize(stagingBufferSize), m_Staging(stagingBuffers) {
+    }
+
+    ~TextureUploadQueue() {
+        release();
+    }
+
+    TextureUploadQueue(const TextureUploadQueue&) = delete;
+    TextureUploadQueue& operator=(const TextureUploadQueue&) = delete;
+
+    // Drops the pending uploads and deletes the staging buffers and their fences, has to run while
+    // the context still exists (the destructor calls it too).
+    void release() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Requests.clear();
+        for (Staging& staging : m_Staging) {
+            if (staging.fence) {
+                glDeleteSync(staging.fence);
+                staging.fence = nullptr;
+            }
+            if (staging.buffer) {
+                glDeleteBuffers(1, &staging.buffer);
+                staging.buffer = 0;
+            }
+        }
+    }
+
+    // The level storage has to exist already (glTexImage2D / glCompressedTexImage2D with no data).
+    // Safe to call from any thread.
+    void push(Request request) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        size_t area = (size_t)request.width * request.height;
+        m_Requests.emplace(std::make_pair(area, m_Sequence++), Pending{std::move(request), 0});
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Requests.empty();
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Requests.size();
+    }
+
+    const Stats& stats() const {
+        return m_Stats;
+    }
+
+    // Drops the pending uploads into texture, call before the texture is deleted so its name
+    // isn't written once it is freed or reused. Safe to call from any thread.
+    void cancel(unsigned int texture) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto it = m_Requests.begin(); it != m_Requests.end();) {
+            it = it->second.request.texture == texture ? m_Requests.erase(it) : std::next(it);
+        }
+    }
+
+    // Issues uploads worth at most byteBudget bytes. Call once per frame. onComplete callbacks
+    // run after the queue is unlocked, so they may push() the next request.
+    void update(size_t byteBudget) {
+        std::vector<std::function<void()>> completed;
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Stats.bytesLastFrame = 0;
+        m_Stats.slicesLastFrame = 0;
+        GLint previousAlignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+
+        auto it = m_Requests.begin();
+        while (it != m_Requests.end() && m_Stats.bytesLastFrame < byteBudget) {
+            if (!isReady(it->second.request)) {
+                ++it;
+                continue;
+            }
+            Staging* staging = acquireStaging();
+            if (!staging) {
+                break;
+            }
+            Pending& pending = it->second;
+            const Request& request = pending.request;
+
+            size_t available = std::min(m_StagingSize, byteBudget - m_Stats.bytesLastFrame);
+            int rows = std::min<int>(totalRows(request) - pending.rowsDone,
+                                     std::max<size_t>(available / request.rowSize, 1));
+            size_t bytes = rows * request.rowSize;
+            const unsigned char* source = request.data + pending.rowsDone * request.rowSize;
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, request.alignment);
+            glBindTexture(GL_TEXTURE_2D, request.texture);
+            if (bytes <= m_StagingSize) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging->buffer);
+                // the fence guarantees the GPU is done with this buffer, no need to synchronize again
+                void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                std::memcpy(mapped, source, bytes);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                uploadSlice(request, pending.rowsDone, rows, bytes, nullptr);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                staging->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            } else {
+                // a single row that doesn't fit in a staging buffer goes up directly
+                uploadSlice(request, pending.rowsDone, rows, bytes, source);
+            }
+
+            pending.rowsDone += rows;
+            m_Stats.bytesLastFrame += bytes;
+            m_Stats.bytesTotal += bytes;
+            ++m_Stats.slicesLastFrame;
+
+            if (pending.rowsDone == totalRows(request)) {
+                if (request.onComplete) {
+                    completed.push_back(std::move(pending.request.onComplete));
+                }
+                ++m_Stats.completed;
+                it = m_Requests.erase(it);
+            }
+        }
+        lock.unlock();
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+        for (std::function<void()>& onComplete : completed) {
+            onComplete();
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+private:
+    struct Staging {
+        unsigned int buffer = 0;
+        GLsync fence = nullptr;
+    };
+
+    struct Pending {
+        Request request;
+        int rowsDone;
+    };
+
+    mutable std::mutex m_Mutex;
+    size_t m_StagingSize;
+    std::vector<Staging> m_Staging;
+    std::map<std::pair<size_t, uint64_t>, Pending> m_Requests;
+    uint64_t m_Sequence = 0;
+    Stats m_Stats;
+
+    static bool isReady(Request& request) {
+        if (!request.ready) {
+            return true;
+        }
+        GLenum status = glClientWaitSync(request.ready.get(), 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            request.ready.reset();
+            return true;
+        }
+        return false;
+    }
+
+    static bool compressed(const Request& request) {
+        return request.type == 0;
+    }
+
+    static int totalRows(const Request& request) {
+        return compressed(request) ? (request.height + 3) / 4 : request.height;
+    }
+
+    static void uploadSlice(const Request& request, int firstRow, int rows, size_t bytes, const void* data) {
+        int rowHeight = compressed(request) ? 4 : 1;
+        int y = firstRow * rowHeight;
+        int height = std::min(rows * rowHeight, request.height - y);
+        if (compressed(request)) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, request.level, 0, y, request.width, height,
+                                      request.format, bytes, data);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, request.level, 0, y, request.width, height,
+                            request.format, request.type, data);
+        }
+    }
+
+    Staging* acquireStaging() {
+        for (Staging& staging : m_Staging) {
+            if (staging.buffer == 0) {
+                glGenBuffers(1, &staging.buffer);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, m_StagingSize, nullptr, GL_STREAM_DRAW);
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                return &staging;
+            }
+            if (!staging.fence) {
+                return &staging;
+            }
+            GLenum status = glClientWaitSync(staging.fence, 0, 0);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+                glDeleteSync(staging.fence);
+                staging.fence = nullptr;
+                return &staging;
+            }
+        }
+        return nullptr;
+    }
+};
+
+};
+#endif //PROJECT_BASE_TEXTUREUPLOADQUEUE_H
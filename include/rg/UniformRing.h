@@ -0,0 +1,186 @@
+#ifndef PROJECT_BASE_UNIFORMRING_H
+#define PROJECT_BASE_UNIFORMRING_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <rg/Error.h>
+#include <rg/GLExtensions.h>
+
+namespace rg {
+
+// Uniform buffer that per-draw data is written into once per frame and bound with glBindBufferRange.
+//
+// The buffer is split into parts used round robin, one per begin()/end(). Before a part is
+// written again begin() waits on the fence placed after the draws that last read it. With
+// FramesAhead parts per begin() in a frame the CPU only waits if it gets that many frames ahead
+// of the GPU.
+//
+// With ARB_buffer_storage the buffer is mapped once, persistent and coherent, and written
+// directly. Otherwise begin() maps just the part with GL_MAP_UNSYNCHRONIZED_BIT, as the fence
+// already guarantees the GPU is done with it, and end() unmaps it again; either way nothing in
+// here makes the driver synchronize.
+class UniformRing {
+public:
+    static const unsigned int FramesAhead = 3;
+
+    // writesPerFrame: begin()/end() pairs per frame
+    explicit UniformRing(size_t regionSize = 256 * 1024, unsigned int writesPerFrame = 1)
+    : m_Fences(FramesAhead * std::max(writesPerFrame, 1u), nullptr) {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_Alignment = alignment > 0 ? (size_t)alignment : 256;
+        allocate(align(regionSize));
+    }
+
+    ~UniformRing() {
+        release();
+    }
+
+    // Deletes the buffer, has to run while the context still exists (the destructor calls it too).
+    void release() {
+        if (!m_Buffer) {
+            return;
+        }
+        for (GLsync& fence : m_Fences) {
+            if (fence) {
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+        if (m_Persistent) {
+            glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &m_Buffer);
+        m_Buffer = 0;
+        m_Mapped = nullptr;
+        m_Used = false;
+    }
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    // size rounded up to the offset alignment glBindBufferRange requires
+    size_t align(size_t size) const {
+        return (size + m_Alignment - 1) / m_Alignment * m_Alignment;
+    }
+
+    // Returns size bytes to write this frame's data to, starting at offset() in buffer(). Call
+    // after the draws of the previous part were issued, the buffer grows if size doesn't fit.
+    unsigned char* begin(size_t size) {
+        ASSERT(!m_Writing, "UniformRing::begin called twice without end");
+        // fence the part the last draws read, then move on to the oldest one
+        if (m_Used) {
+            m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_Region = (m_Region + 1) % regions();
+        }
+        if (size > m_RegionSize) {
+            // the old buffer is only released by the GL once the GPU is done with it
+            release();
+            allocate(align(size + size / 2));
+            std::cout << "UniformRing: grew to " << m_RegionSize / 1024 << " KB per frame" << std::endl;
+        }
+        wait(m_Region);
+
+        m_Used = true;
+        m_Writing = true;
+        if (m_Persistent) {
+            return m_Mapped + offset();
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+        void* data = glMapBufferRange(GL_UNIFORM_BUFFER, offset(), m_RegionSize,
+                                      GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        return (unsigned char*)data;
+    }
+
+    // Finishes writing, the part can be bound for drawing afterwards.
+    void end() {
+        ASSERT(m_Writing, "UniformRing::end called without begin");
+        m_Writing = false;
+        if (!m_Persistent) {
+            glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+    }
+
+    GLuint buffer() const {
+        return m_Buffer;
+    }
+
+    // start of the current part in buffer()
+    GLintptr offset() const {
+        return (GLintptr)(m_Region * m_RegionSize);
+    }
+
+    bool persistent() const {
+        return m_Persistent;
+    }
+
+private:
+    GLuint m_Buffer = 0;
+    size_t m_Alignment = 256;
+    size_t m_RegionSize = 0;
+    unsigned int m_Region = 0;
+    bool m_Persistent = false;
+    bool m_Used = false;
+    bool m_Writing = false;
+    unsigned char* m_Mapped = nullptr;
+    // one per part
+    std::vector<GLsync> m_Fences;
+
+    unsigned int regions() const {
+        return (unsigned int)m_Fences.size();
+    }
+
+    void allocate(size_t regionSize) {
+        m_RegionSize = regionSize;
+        m_Region = 0;
+        m_Used = false;
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+        RG_PFNGLBUFFERSTORAGEPROC bufferStorage = bufferStorageFunction();
+        m_Persistent = bufferStorage != nullptr;
+        if (m_Persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage(GL_UNIFORM_BUFFER, m_RegionSize * regions(), nullptr, flags);
+            m_Mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, m_RegionSize * regions(), flags);
+            m_Persistent = m_Mapped != nullptr;
+        }
+        if (!m_Persistent) {
+            // can't respecify immutable storage, so start over with a mutable buffer
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            glDeleteBuffers(1, &m_Buffer);
+            glGenBuffers(1, &m_Buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+            glBufferData(GL_UNIFORM_BUFFER, m_RegionSize * regions(), nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void wait(unsigned int region) {
+        GLsync& fence = m_Fences[region];
+        if (!fence) {
+            return;
+        }
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (true) {
+            GLenum status = glClientWaitSync(fence, flags, 1000000000);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED) {
+                break;
+            }
+            flags = 0;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+};
+
+};
+#endif //PROJECT_BASE_UNIFORMRING_H
@@ -0,0 +1,171 @@
+#ifndef PROJECT_BASE_VFS_H
+#define PROJECT_BASE_VFS_H
+
+#include <learnopengl/filesystem.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <rg/Lz.h>
+#include <rg/FileView.h>
+#include <rg/PackFile.h>
+
+namespace rg {
+
+// Contents of a file opened through the Vfs. Uncompressed pack entries and loose files are
+// views into a FileView (usually a memory mapping), compressed entries own their decompressed
+// bytes; either way the view keeps its storage alive, so it can be copied around and outlive
+// the Vfs call.
+class VfsFile {
+public:
+    VfsFile() = default;
+
+    VfsFile(const unsigned char* data, size_t size, std::shared_ptr<const void> owner)
+    : m_Data(data), m_Size(size), m_Owner(std::move(owner)) {
+    }
+
+    bool isOpen() const {
+        return m_Owner != nullptr;
+    }
+
+    const unsigned char* data() const {
+        return m_Data;
+    }
+
+    size_t size() const {
+        return m_Size;
+    }
+
+    const char* begin() const {
+        return (const char*)m_Data;
+    }
+
+    const char* end() const {
+        return (const char*)m_Data + m_Size;
+    }
+
+    std::string string() const {
+        return std::string(begin(), end());
+    }
+
+private:
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+    std::shared_ptr<const void> m_Owner;
+};
+
+// Resolves asset paths against the mounted pack files first and the real filesystem second.
+//
+// Paths may be absolute (FileSystem::getPath) or relative to the project root, both map to the
+// same pack entry ("resources/shaders/object.vs"). Packs are mounted once at startup, lookups
+// afterwards only read and are safe from any thread.
+class Vfs {
+public:
+    static Vfs& instance() {
+        static Vfs vfs;
+        return vfs;
+    }
+
+    // Packs mounted later take precedence over earlier ones.
+    bool mount(const std::string& path) {
+        PackFile pack;
+        if (!pack.open(path)) {
+            return false;
+        }
+        m_Packs.insert(m_Packs.begin(), std::move(pack));
+        return true;
+    }
+
+    VfsFile open(const std::string& path) const {
+        const PackFile* pack;
+        const PackEntry* entry = find(path, pack);
+        if (entry) {
+            if (!(entry->flags & PACK_ENTRY_LZ)) {
+                return VfsFile(pack->data(*entry), entry->size, pack->mapping());
+            }
+            auto buffer = std::make_shared<std::vector<unsigned char>>(entry->size);
+            if (!lz::decompress(pack->data(*entry), entry->storedSize, buffer->data(), buffer->size())) {
+                return VfsFile();
+            }
+            return VfsFile(buffer->data(), buffer->size(), buffer);
+        }
+
+        auto file = std::make_shared<FileView>();
+        if (!file->open(path)) {
+            return VfsFile();
+        }
+        return VfsFile(file->data(), file->size(), file);
+    }
+
+    bool exists(const std::string& path) const {
+        const PackFile* pack;
+        struct stat info;
+        return find(path, pack) != nullptr || stat(path.c_str(), &info) == 0;
+    }
+
+    // Changes whenever the file does, for cache invalidation: size and modification time, where
+    // packed files use the time of their pack. Empty if the file doesn't exist.
+    std::string stamp(const std::string& path) const {
+        const PackFile* pack;
+        const PackEntry* entry = find(path, pack);
+        if (entry) {
+            return std::to_string((unsigned long long)entry->size) + ":pack" + pack->stamp();
+        }
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            return std::string();
+        }
+        return std::to_string((long long)info.st_size) + ":" + std::to_string((long long)info.st_mtime);
+    }
+
+    // "/root/resources/objects/../shaders//a.vs" -> "resources/shaders/a.vs"
+    static std::string entryName(const std::string& path) {
+        std::string root = FileSystem::getPath("");
+        size_t start = root.size() > 1 && path.compare(0, root.size(), root) == 0 ? root.size() : 0;
+
+        std::vector<std::string> parts;
+        while (start <= path.size()) {
+            size_t slash = path.find('/', start);
+            if (slash == std::string::npos) {
+                slash = path.size();
+            }
+            std::string part = path.substr(start, slash - start);
+            if (part == ".." && !parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+            } else if (!part.empty() && part != ".") {
+                parts.push_back(part);
+            }
+            start = slash + 1;
+        }
+        std::string name;
+        for (const std::string& part : parts) {
+            name += (name.empty() ? "" : "/") + part;
+        }
+        return name;
+    }
+
+private:
+    std::vector<PackFile> m_Packs;
+
+    Vfs() = default;
+
+    const PackEntry* find(const std::string& path, const PackFile*& pack) const {
+        if (m_Packs.empty()) {
+            return nullptr;
+        }
+        std::string name = entryName(path);
+        for (const PackFile& candidate : m_Packs) {
+            const PackEntry* entry = candidate.find(name);
+            if (entry) {
+                pack = &candidate;
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+};
+
+};
+#endif //PROJECT_BASE_VFS_H
@@ -5,7 +5,11 @@ layout (location = 2) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 
-uniform mat4 model;
+// written per draw by rg::RenderQueue
+layout (std140) uniform PerDraw {
+    mat4 model;
+    mat4 normalMatrix;
+};
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -0,0 +1,75 @@
+#pragma once
+// Light types and Blinn-Phong shading shared by the lit shaders. The material colors are passed
+// in, so a shader samples its textures once no matter how many lights it evaluates.
+
+struct PointLight {
+    vec3 position;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+float Attenuation(float constant, float linear, float quadratic, float distance)
+{
+    return 1.0 / (constant + linear * distance + quadratic * (distance * distance));
+}
+
+// ambient + diffuse + specular of one light, before attenuation
+vec3 BlinnPhong(vec3 lightDir, vec3 normal, vec3 viewDir, vec3 ambient, vec3 diffuse, vec3 specular,
+                vec3 diffuseColor, vec3 specularColor, float shininess)
+{
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
+    return ambient * diffuseColor + diffuse * diff * diffuseColor + specular * spec * specularColor;
+}
+
+// calculates the color when using a point light.
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor,
+                    float shininess)
+{
+    vec3 toLight = light.position - fragPos;
+    float distance = length(toLight);
+    vec3 lightDir = toLight / distance;
+    float attenuation = Attenuation(light.constant, light.linear, light.quadratic, distance);
+    return attenuation * BlinnPhong(lightDir, normal, viewDir, light.ambient, light.diffuse, light.specular,
+                                    diffuseColor, specularColor, shininess);
+}
+
+// calculates the color when using a spot light.
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor,
+                   float shininess)
+{
+    vec3 toLight = light.position - fragPos;
+    float distance = length(toLight);
+    vec3 lightDir = toLight / distance;
+    float attenuation = Attenuation(light.constant, light.linear, light.quadratic, distance);
+    // spotlight intensity
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    return attenuation * intensity * BlinnPhong(lightDir, normal, viewDir, light.ambient, light.diffuse, light.specular,
+                                                diffuseColor, specularColor, shininess);
+}
@@ -8,14 +8,18 @@ out vec3 Normal;
 out vec2 TexCoords;
 
 
-uniform mat4 model;
+// written per draw by rg::RenderQueue
+layout (std140) uniform PerDraw {
+    mat4 model;
+    mat4 normalMatrix;
+};
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = mat3(normalMatrix) * aNormal;
     TexCoords = aTexCoords;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,6 @@
+#version 330 core
+
+// color writes are off while the boxes are drawn, only whether any sample passed the depth test counts
+void main()
+{
+}
@@ -4,22 +4,27 @@ out vec4 FragColor;
 in vec2 TexCoords;
 
 uniform sampler2DMS screenTexture;
-uniform bool effect;
+
+// Variant defines, set by the application (see rg::ShaderVariants):
+//   MSAA_SAMPLES  sample count of screenTexture
+//   GRAYSCALE     the grayscale effect is on
+#ifndef MSAA_SAMPLES
+#define MSAA_SAMPLES 4
+#endif
 
 void main()
 {
     ivec2 viewportDim = ivec2(800, 600);
     ivec2 coords = ivec2(viewportDim * TexCoords);
-    vec3 sample0 = texelFetch(screenTexture, coords, 0).rgb;
-    vec3 sample1 = texelFetch(screenTexture, coords, 1).rgb;
-    vec3 sample2 = texelFetch(screenTexture, coords, 2).rgb;
-    vec3 sample3 = texelFetch(screenTexture, coords, 3).rgb;
+    vec3 col = vec3(0.0);
+    for (int i = 0; i < MSAA_SAMPLES; i++)
+        col += texelFetch(screenTexture, coords, i).rgb;
+    col *= 1.0 / float(MSAA_SAMPLES);
 
-    vec3 col = 0.25 * (sample0 + sample1 + sample2 + sample3);
-    if (effect) {
-        float grayscale = 0.2126 * col.r + 0.7152 * col.g + 0.0722 * col.b;
-        FragColor = vec4(vec3(grayscale), 1.0);
-    } else {
-        FragColor = vec4(vec3(col), 1.0);
-    }
+#ifdef GRAYSCALE
+    float grayscale = 0.2126 * col.r + 0.7152 * col.g + 0.0722 * col.b;
+    FragColor = vec4(vec3(grayscale), 1.0);
+#else
+    FragColor = vec4(vec3(col), 1.0);
+#endif
 }
\ No newline at end of file
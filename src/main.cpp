@@ -9,24 +9,53 @@
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
-
+#include <rg/AssetStreamer.h>
+#include <rg/Bvh.h>
+#include <rg/FrameGraph.h>
+#include <rg/GLDebug.h>
+#include <rg/GLTrace.h>
+#include <rg/JobSystem.h>
+#include <rg/OcclusionCuller.h>
+#include <rg/RenderQueue.h>
+#include <rg/SceneFile.h>
+#include <rg/SceneGraph.h>
+#include <rg/ShaderVariants.h>
+#include <rg/ShaderWatcher.h>
+#include <rg/SoftwareOcclusionCuller.h>
+#include <rg/TextureAtlas.h>
+#include <rg/TextureUploadQueue.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 
-void draw_cake(Model& model, Shader& shader, const glm::vec3& translation_vec);
-void set_light_bulb(Model& lightModel, Shader& lightShader, glm::vec3& pointLightPositions, float angle, const glm::vec3& translation_vec);
-void set_spot_light(Shader& shader, Camera& camera);
-void set_point_light(Shader& objectShader, glm::vec3& point_light_position, int i, float point_light_linear, float point_light_quadratic);
+void set_spot_light(Shader& objectShader, Camera& camera, const rg::SceneLight* spotLight, const glm::vec3& position,
+                    const glm::vec3& direction);
+void set_point_light(Shader& objectShader, const rg::SceneLight& light, const glm::vec3& position, int i);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+rg::Aabb localBounds(const Model& model);
+rg::Aabb localBounds(const Mesh& mesh);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod);
 void processInput(GLFWwindow *window);
+rg::ShaderDefines objectShaderDefines(bool spotlight);
+rg::ShaderDefines screenShaderDefines(bool grayscale);
 
 
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+const unsigned int MSAA_SAMPLES = 4;
+// the object shader is compiled for the scene's number of point lights, up to this many
+const unsigned int MAX_POINT_LIGHTS = 16;
+unsigned int numPointLights = 1;
+// instances that cover less than this many pixels on screen aren't drawn
+const float MIN_INSTANCE_PIXELS = 1.0f;
 
 // camera
 Camera camera(glm::vec3(0.0f, 1.0f, 12.0f));
@@ -37,6 +66,10 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// O toggles occlusion culling, to compare with and without it
+bool occlusionCulling = true;
+// set by a left click, the object under the crosshair is printed next frame
+bool pickRequested = false;
 bool isSpotlightActivated = false;
 bool effect = false;    // da li stavljamo efekat (grayscale)
 
@@ -50,6 +83,9 @@ int main()
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+#ifdef RG_GL_DEBUG
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
 
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
     if (window == NULL)
@@ -62,6 +98,7 @@ int main()
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetKeyCallback(window, key_callback);
 
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -72,19 +109,97 @@ int main()
         return -1;
     }
 
+    // errors are reported by the driver's debug callback, see rg/GLDebug.h
+    if (rg::GLDebug::instance().install())
+        std::cout << "GL debug output enabled" << (rg::GLDebug::debugContext() ? " (debug context)" : "") << std::endl;
+
+    // RG_GL_TRACE=<file> counts the GL calls of every frame and logs them to file, see rg/GLTrace.h
+    if (const char* tracePath = std::getenv("RG_GL_TRACE"))
+        rg::GLTrace::instance().install(tracePath);
+
     stbi_set_flip_vertically_on_load(true);
 
     glEnable(GL_DEPTH_TEST);
 
-    // shaders
-    Shader objectShader("resources/shaders/object.vs", "resources/shaders/object.fs");
+    // assets come from resources.pack when it was built (see tools/pack_builder.cpp), loose files otherwise
+    if (rg::Vfs::instance().mount(FileSystem::getPath("resources.pack")))
+        std::cout << "Mounted resources.pack" << std::endl;
+
+    // the scene: models, materials, transforms and lights, see resources/scenes and rg/SceneFile.h.
+    // RG_SCENE=<file> loads another one, e.g. a benchmark scene from tools/scene_compiler.cpp
+    const char* scenePath = std::getenv("RG_SCENE");
+    auto sceneLoadStart = std::chrono::steady_clock::now();
+    rg::SceneDescription sceneDescription;
+    std::string sceneError;
+    if (!rg::SceneFile::load(scenePath ? scenePath : FileSystem::getPath("resources/scenes/dining_room.json"),
+                             sceneDescription, sceneError))
+    {
+        std::cout << "Failed to load the scene: " << sceneError << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    vector<const rg::SceneLight*> pointLights;
+    const rg::SceneLight* spotLight = nullptr;
+    for (const rg::SceneLight& light : sceneDescription.lights) {
+        if (light.type == rg::SceneLightType::Point && pointLights.size() < MAX_POINT_LIGHTS)
+            pointLights.push_back(&light);
+        else if (light.type == rg::SceneLightType::Spot && !spotLight)
+            spotLight = &light;
+    }
+    // GLSL has no empty arrays, a scene without point lights gets one that is black
+    numPointLights = std::max<unsigned int>(pointLights.size(), 1);
+
+    // shaders, compiled in the background where the driver supports it and
+    // resolved on first use, so the setup below overlaps with compilation
+    // the spot light (L) and grayscale (E) toggles pick between specialized variants of the
+    // object and screen shaders, both variants of each are compiled up front
+    rg::ShaderVariants objectShaders("resources/shaders/object.vs", "resources/shaders/object.fs");
+    rg::ShaderVariants screenShaders("resources/shaders/screen.vs", "resources/shaders/screen.fs");
+    for (bool enabled : {false, true}) {
+        objectShaders.get(objectShaderDefines(enabled));
+        screenShaders.get(screenShaderDefines(enabled));
+    }
     Shader lightShader("resources/shaders/light_source.vs", "resources/shaders/light_source.fs");
-    Shader screenShader("resources/shaders/screen.vs", "resources/shaders/screen.fs");
+    Shader occlusionShader("resources/shaders/occlusion_box.vs", "resources/shaders/occlusion_box.fs");
+
+    // saving a shader while the program runs rebuilds the programs using it
+    rg::ShaderWatcher shaderWatcher(FileSystem::getPath("resources/shaders"));
+    shaderWatcher.watch(objectShaders);
+    shaderWatcher.watch(screenShaders);
+    shaderWatcher.watch(lightShader);
+    shaderWatcher.watch(occlusionShader);
+
+    // upload only the small mip levels at load time, the rest streams in over the first frames
+    // through pixel buffers, at most 4 MB per frame
+    rg::TextureUploadQueue uploadQueue;
+    rg::TextureCache::options().streamMips = true;
+    rg::TextureCache::options().uploadQueue = &uploadQueue;
+
+    // models and textures load on a background thread, the scene fills in as they arrive
+    rg::AssetStreamer streamer(window);
+
+    // pack small material textures into shared atlas pages so those meshes batch together
+    auto packAtlas = [](Model& model) {
+        rg::TextureAtlasBuilder atlasBuilder;
+        atlasBuilder.addModel(model);
+        rg::TextureAtlasBuilder::Stats atlasStats = atlasBuilder.build();
+        std::cout << "Texture atlas: " << atlasStats.packedMaterials << " materials (" << atlasStats.packedMeshes
+                  << " meshes) packed into " << atlasStats.pages << " pages, "
+                  << atlasStats.freedTextures << " textures released" << std::endl;
+    };
 
-    // models
-    Model tableModel(FileSystem::getPath("resources/objects/dining_table/dining_table.obj"));
-    Model cakeModel(FileSystem::getPath("resources/objects/slice_of_cake/cake.obj"));
-    Model lightModel(FileSystem::getPath("resources/objects/light/light.obj"));
+    // models and material textures of the scene
+    vector<rg::ModelHandle> sceneModels(sceneDescription.models.size());
+    for (size_t i = 0; i < sceneDescription.models.size(); i++) {
+        if (!sceneDescription.models[i].path.empty())
+            sceneModels[i] = streamer.loadModel(FileSystem::getPath(sceneDescription.models[i].path), false, packAtlas);
+    }
+    vector<rg::TextureHandle> diffuseTextures;
+    vector<rg::TextureHandle> specularTextures;
+    for (const rg::SceneMaterial& material : sceneDescription.materials) {
+        diffuseTextures.push_back(streamer.loadTexture(material.diffuse, true));
+        specularTextures.push_back(streamer.loadTexture(material.specular, false));
+    }
 
     // screen vertexes
     float quadVertices[] = {
@@ -110,28 +225,6 @@ int main()
             0, 1, 3, // first triangle
             0, 2, 3  // second triangle
     };
-    unsigned int floorVBO, floorVAO, floorEBO;
-    glGenVertexArrays(1, &floorVAO);
-    glGenBuffers(1, &floorVBO);
-    glGenBuffers(1, &floorEBO);
-
-    glBindVertexArray(floorVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, floorVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(floorVertices), floorVertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, floorEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(floorIndices), floorIndices, GL_STATIC_DRAW);
-
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // normals attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // texture coord attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
 
     // setup screen VAO
     unsigned int quadVAO, quadVBO;
@@ -154,14 +247,14 @@ int main()
     unsigned int textureColorBufferMultiSampled;
     glGenTextures(1, &textureColorBufferMultiSampled);
     glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled);
-    glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, SCR_WIDTH, SCR_HEIGHT, GL_TRUE);
+    glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, MSAA_SAMPLES, GL_RGB, SCR_WIDTH, SCR_HEIGHT, GL_TRUE);
     glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled, 0);
     // create a (also multisampled) renderbuffer object for depth and stencil attachments
     unsigned int rbo;
     glGenRenderbuffers(1, &rbo);
     glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, MSAA_SAMPLES, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
 
@@ -169,12 +262,268 @@ int main()
         cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << endl;
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    screenShader.setInt("screenTexture", 0);
+    // planes (the floor) go through the same path as the model meshes so the render queue can batch them
+    vector<Vertex> floorMeshVertices;
+    for (unsigned int i = 0; i < 4; i++) {
+        const float* v = &floorVertices[i * 8];
+        Vertex vertex;
+        vertex.Position = glm::vec3(v[0], v[1], v[2]);
+        vertex.Normal = glm::vec3(v[3], v[4], v[5]);
+        vertex.TexCoords = glm::vec2(v[6], v[7]);
+        vertex.Tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+        vertex.Bitangent = glm::vec3(0.0f, 0.0f, 1.0f);
+        floorMeshVertices.push_back(vertex);
+    }
+    vector<std::unique_ptr<Mesh>> scenePlanes(sceneDescription.models.size());
+    for (size_t i = 0; i < sceneDescription.models.size(); i++) {
+        const rg::SceneModel& sceneModel = sceneDescription.models[i];
+        if (sceneModel.primitive != "plane")
+            continue;
+        vector<Texture> textures;
+        if (sceneModel.material >= 0) {
+            const rg::SceneMaterial& material = sceneDescription.materials[sceneModel.material];
+            textures.push_back({diffuseTextures[sceneModel.material].id(), "texture_diffuse", material.diffuse});
+            textures.push_back({specularTextures[sceneModel.material].id(), "texture_specular", material.specular});
+        }
+        scenePlanes[i].reset(new Mesh(floorMeshVertices, vector<unsigned int>(floorIndices, floorIndices + 6), textures));
+    }
 
-    unsigned int floorDiffTexture = TextureFromFile("floor_diffuse.png", "resources/objects/floor");
-    unsigned int floorSpecTexture = TextureFromFile("floor_specular2.png", "resources/objects/floor");
+    // transforms live in a scene graph: the static objects are transformed once, after that only
+    // the swinging lamps are updated. The nodes are already ordered parents first, so they are
+    // added in one pass and keep their indices as ids.
+    rg::SceneGraph scene;
+    scene.reserve(sceneDescription.nodes.size());
+    vector<rg::SceneGraph::NodeId> instanceNodes;
+    vector<rg::Bvh::ItemId> nodeInstances(sceneDescription.nodes.size(), rg::Bvh::None);
+    for (const rg::SceneNode& node : sceneDescription.nodes) {
+        rg::SceneGraph::NodeId id = scene.add(node.parent < 0 ? rg::SceneGraph::None : node.parent, node.local());
+        if (node.model >= 0) {
+            nodeInstances[id] = instanceNodes.size();
+            instanceNodes.push_back(id);
+        }
+    }
+    scene.update();
+
+    // culling, picking and light queries go through a BVH over the instances' world bounds. A
+    // model's bounds are known once it's loaded, the tree is built again whenever one finishes
+    // and refit for the instances that moved in between.
+    vector<rg::Aabb> modelBounds(sceneDescription.models.size());
+    vector<bool> modelBoundsKnown(sceneDescription.models.size(), false);
+    for (size_t i = 0; i < scenePlanes.size(); i++) {
+        if (scenePlanes[i]) {
+            modelBounds[i] = localBounds(*scenePlanes[i]);
+            modelBoundsKnown[i] = true;
+        }
+    }
+    auto instanceBounds = [&](rg::Bvh::ItemId instance) {
+        rg::SceneGraph::NodeId node = instanceNodes[instance];
+        return modelBounds[sceneDescription.nodes[node].model].transformed(scene.world(node));
+    };
+    rg::Bvh bvh;
+    bool bvhOutdated = true;
+    size_t visibleInstances = 0;
+
+    // instances in view that weren't visible last time are drawn conditionally on an occlusion
+    // query of their bounding box, after the others filled in the depth buffer
+    rg::OcclusionCuller occlusionCuller;
+    occlusionCuller.resize(instanceNodes.size());
+    vector<rg::Bvh::ItemId> queriedInstances;
+    size_t occlusionQueries = 0;
+    size_t occludedInstances = 0;
+
+    // a software rasterizer pays for a query box like for any other draw, there the scene's
+    // occluders are rasterized on the CPU instead and instances behind them aren't submitted.
+    // RG_OCCLUSION=gpu|cpu picks one regardless of the driver
+    std::string glRenderer = (const char*)glGetString(GL_RENDERER);
+    bool cpuOcclusion = glRenderer.find("llvmpipe") != std::string::npos ||
+                        glRenderer.find("softpipe") != std::string::npos ||
+                        glRenderer.find("SwiftShader") != std::string::npos;
+    if (const char* occlusionMode = std::getenv("RG_OCCLUSION"))
+        cpuOcclusion = std::string(occlusionMode) == "cpu";
+
+    // with GPU occlusion the draws behind the queries are flushed a second time each frame
+    rg::RenderQueue renderQueue(cpuOcclusion ? 1 : 2);
+    unsigned int lightShaderId = renderQueue.registerShader(lightShader);
+    unsigned int objectShaderId = renderQueue.registerShader(objectShaders.get(objectShaderDefines(isSpotlightActivated)));
+
+    rg::SoftwareOcclusionCuller softwareCuller;
+    vector<rg::SoftwareOcclusionCuller::Occluder> occluders;
+    double occluderRasterMilliseconds = 0.0;
+    std::cout << "Occlusion culling on the " << (cpuOcclusion ? "CPU" : "GPU") << " (" << glRenderer << ", "
+              << sceneDescription.occluders.size() << " occluders)" << std::endl;
+    std::cout << "Scene: " << scene.size() << " nodes, " << instanceNodes.size() << " instances, "
+              << sceneDescription.lights.size() << " lights, loaded in "
+              << rg::ProgramCache::millisecondsSince(sceneLoadStart) << " ms" << std::endl;
+
+    // the CPU side of a frame runs as a graph of passes on a work-stealing job system, see
+    // rg/FrameGraph.h; the GL calls stay on this thread. RG_THREADS=<n> limits it to n threads
+    const char* threadsSetting = std::getenv("RG_THREADS");
+    rg::JobSystem jobs(threadsSetting ? (unsigned int)std::max(std::atoi(threadsSetting), 1) : rg::hardwareThreads());
+    std::cout << "Job system: " << jobs.threads() << " threads" << std::endl;
+
+    // state of the frame the passes work on, set on this thread before the graph starts
+    glm::mat4 projection(1.0f);
+    glm::mat4 view(1.0f);
+    double frameTime = 0.0;
+    bool softwareCulling = false;
+    bool picking = false;
+    // results of the passes
+    vector<glm::vec3> pointLightPositions(numPointLights, glm::vec3(0.0f));
+    glm::vec3 spotLightPosition(0.0f);
+    glm::vec3 spotLightDirection(0.0f, 0.0f, -1.0f);
+    rg::Bvh::ItemId pickedInstance = rg::Bvh::None;
+    float pickedDistance = 0.0f;
+    unsigned int pickedLights = 0;
+    // per thread output of the parallel passes, indexed by JobSystem::threadIndex()
+    vector<vector<rg::Bvh::ItemId>> culledLists(jobs.threads());
+    vector<vector<rg::Bvh::ItemId>> drawnLists(jobs.threads());
+    vector<vector<rg::Bvh::ItemId>> queriedLists(jobs.threads());
+    vector<size_t> hiddenCounts(jobs.threads());
+    vector<size_t> smallCounts(jobs.threads());
+    vector<rg::RenderQueue::DrawList> drawLists(jobs.threads());
+    vector<uint32_t> bvhSubtrees;
+    vector<rg::Bvh::ItemId> inView;
+    vector<rg::Bvh::ItemId> drawnInstances;
+    size_t smallInstances = 0;
+
+    auto gather = [](vector<vector<rg::Bvh::ItemId>>& lists, vector<rg::Bvh::ItemId>& all) {
+        all.clear();
+        for (vector<rg::Bvh::ItemId>& list : lists) {
+            all.insert(all.end(), list.begin(), list.end());
+            list.clear();
+        }
+    };
 
-    glm::vec3 pointLightPositions[3];
+    rg::FrameGraph frameGraph;
+    rg::FrameGraph::PassId transformsPass = frameGraph.addPass("transforms", [&]() {
+        for (const rg::SceneSwing& swing : sceneDescription.swings) {
+            float angle = glm::radians(swing.amplitudeDegrees * (float)sin(swing.phase + swing.frequency * frameTime));
+            scene.setLocal(swing.node, glm::rotate(sceneDescription.nodes[swing.node].local(), angle, swing.axis));
+        }
+        scene.update(&jobs);
+    });
+    // rasterized on the software culler's own thread while the passes below run
+    rg::FrameGraph::PassId occludersPass = frameGraph.addPass("occluders", [&]() {
+        if (!softwareCulling)
+            return;
+        occluders.clear();
+        for (const rg::SceneOccluder& occluder : sceneDescription.occluders)
+            occluders.push_back({scene.world(occluder.node), rg::Aabb(occluder.min, occluder.max)});
+        softwareCuller.begin(projection * view, occluders);
+    }, {transformsPass});
+    rg::FrameGraph::PassId boundsPass = frameGraph.addPass("bounds", [&]() {
+        for (size_t i = 0; i < sceneModels.size(); i++) {
+            if (!modelBoundsKnown[i] && sceneModels[i].ready()) {
+                modelBounds[i] = localBounds(sceneModels[i].get());
+                modelBoundsKnown[i] = true;
+                bvhOutdated = true;
+            }
+        }
+        if (bvhOutdated) {
+            vector<rg::Aabb> bounds(instanceNodes.size());
+            for (size_t i = 0; i < instanceNodes.size(); i++)
+                bounds[i] = instanceBounds(i);
+            bvh.build(bounds);
+            bvhOutdated = false;
+        } else {
+            for (rg::SceneGraph::NodeId node : scene.updatedNodes()) {
+                if (nodeInstances[node] != rg::Bvh::None)
+                    bvh.update(nodeInstances[node], instanceBounds(nodeInstances[node]));
+            }
+            bvh.refit();
+        }
+    }, {transformsPass});
+    rg::FrameGraph::PassId lightsPass = frameGraph.addPass("lights", [&]() {
+        for (size_t i = 0; i < pointLights.size(); i++)
+            pointLightPositions[i] = scene.worldPosition(pointLights[i]->node);
+        spotLightPosition = camera.Position;
+        spotLightDirection = camera.Front;
+        if (spotLight && spotLight->node >= 0) {
+            spotLightPosition = scene.worldPosition(spotLight->node);
+            spotLightDirection = glm::normalize(glm::vec3(scene.world(spotLight->node) * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f)));
+        }
+    }, {transformsPass});
+    frameGraph.addPass("pick", [&]() {
+        if (!picking)
+            return;
+        pickedInstance = bvh.raycast(camera.Position, camera.Front, 100.0f, pickedDistance);
+        pickedLights = 0;
+        if (pickedInstance != rg::Bvh::None) {
+            for (size_t i = 0; i < pointLights.size(); i++)
+                pickedLights += bvh.bounds(pickedInstance).overlapsSphere(pointLightPositions[i], pointLights[i]->range());
+        }
+    }, {boundsPass, lightsPass});
+    // the instances in view, a few subtrees of the BVH per thread
+    rg::FrameGraph::PassId cullPass = frameGraph.addPass("cull", [&]() {
+        rg::Frustum frustum = rg::Frustum::fromMatrix(projection * view);
+        bvh.subtrees(jobs.threads() * 4, bvhSubtrees);
+        jobs.parallelFor(bvhSubtrees.size(), 1, [&](size_t begin, size_t end) {
+            vector<rg::Bvh::ItemId>& culled = culledLists[jobs.threadIndex()];
+            rg::Bvh::Stats stats;
+            for (size_t i = begin; i < end; i++) {
+                bvh.cull(frustum, [&](rg::Bvh::ItemId instance) {
+                    int32_t model = sceneDescription.nodes[instanceNodes[instance]].model;
+                    if (scenePlanes[model] || sceneModels[model].ready())
+                        culled.push_back(instance);
+                }, bvhSubtrees[i], stats);
+            }
+        });
+    }, {boundsPass});
+    // Per instance in view: skipped when behind the CPU occluders or smaller than a pixel (the
+    // level of detail choice, with one level per model it is between drawing and skipping), drawn
+    // on an occlusion query when the GPU culls, drawn directly otherwise.
+    rg::FrameGraph::PassId selectPass = frameGraph.addPass("select", [&]() {
+        gather(culledLists, inView);
+        visibleInstances += inView.size();
+        if (softwareCulling)
+            softwareCuller.wait();
+        float pixelsPerRadian = SCR_HEIGHT / (2.0f * tan(glm::radians(camera.Zoom) * 0.5f));
+        jobs.parallelFor(inView.size(), 256, [&](size_t begin, size_t end) {
+            unsigned int thread = jobs.threadIndex();
+            for (size_t i = begin; i < end; i++) {
+                rg::Bvh::ItemId instance = inView[i];
+                const rg::Aabb& bounds = bvh.bounds(instance);
+                if (softwareCulling && softwareCuller.occluded(bounds)) {
+                    hiddenCounts[thread]++;
+                    continue;
+                }
+                float diameter = glm::length(bounds.max - bounds.min);
+                float distance = glm::length(bounds.center() - camera.Position);
+                if (distance > diameter && diameter / distance * pixelsPerRadian < MIN_INSTANCE_PIXELS) {
+                    smallCounts[thread]++;
+                    continue;
+                }
+                if (!softwareCulling && occlusionCulling &&
+                    !occlusionCuller.drawDirectly(instance, bounds, camera.Position, 0.1f))
+                    queriedLists[thread].push_back(instance);
+                else
+                    drawnLists[thread].push_back(instance);
+            }
+        });
+    }, {cullPass, occludersPass});
+    rg::FrameGraph::PassId recordPass = frameGraph.addPass("record", [&]() {
+        gather(drawnLists, drawnInstances);
+        jobs.parallelFor(drawnInstances.size(), 256, [&](size_t begin, size_t end) {
+            rg::RenderQueue::DrawList& list = drawLists[jobs.threadIndex()];
+            for (size_t i = begin; i < end; i++) {
+                rg::SceneGraph::NodeId node = instanceNodes[drawnInstances[i]];
+                int32_t model = sceneDescription.nodes[node].model;
+                unsigned int shaderId = sceneDescription.models[model].shader == rg::SceneShader::Light ? lightShaderId : objectShaderId;
+                if (scenePlanes[model])
+                    renderQueue.record(list, shaderId, *scenePlanes[model], scene.world(node), scene.normalMatrix(node));
+                else
+                    renderQueue.record(list, shaderId, sceneModels[model].get(), scene.world(node), scene.normalMatrix(node));
+            }
+        });
+    }, {selectPass});
+    frameGraph.addPass("merge", [&]() {
+        renderQueue.merge(drawLists);
+        gather(queriedLists, queriedInstances);
+    }, {recordPass});
+
+    double renderMilliseconds = 0.0;
+    unsigned int renderedFrames = 0;
+    bool loadStatsPrinted = false;
     while (!glfwWindowShouldClose(window))
     {
         float currentFrame = glfwGetTime();
@@ -183,73 +532,118 @@ int main()
 
         processInput(window);
 
+        shaderWatcher.update();
+        streamer.update();
+        uploadQueue.update(4 << 20);
+        if (!loadStatsPrinted && streamer.idle()) {
+            rg::ProgramCache::instance().printStats();
+            rg::TextureCache::printStats();
+            rg::TextureRegistry::instance().printStats();
+            loadStatsPrinted = true;
+        }
+        // planes show the placeholder texture until their own are loaded
+        for (size_t i = 0; i < scenePlanes.size(); i++) {
+            int32_t material = sceneDescription.models[i].material;
+            if (!scenePlanes[i] || material < 0)
+                continue;
+            Mesh& plane = *scenePlanes[i];
+            if (plane.textures[0].id != diffuseTextures[material].id() || plane.textures[1].id != specularTextures[material].id()) {
+                plane.textures[0].id = diffuseTextures[material].id();
+                plane.textures[1].id = specularTextures[material].id();
+                renderQueue.invalidate(plane);
+            }
+        }
+        auto renderStart = std::chrono::steady_clock::now();
+
+        projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        view = camera.GetViewMatrix();
+        frameTime = glfwGetTime();
+        softwareCulling = occlusionCulling && cpuOcclusion;
+        picking = pickRequested;
+        pickRequested = false;
+        renderQueue.begin(camera.Position, camera.Front, 100.0f);
+        Shader& objectShader = objectShaders.get(objectShaderDefines(isSpotlightActivated));
+        renderQueue.setShader(objectShaderId, objectShader);
+        occlusionCuller.collect();
+
+        // transforms, culling and the draw list are built by the job system while this thread
+        // sets up GL
+        frameGraph.start(jobs);
+
         // draw scene as normal in multisampled buffers
         glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
         glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glEnable(GL_DEPTH_TEST);
 
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT,
-                                                0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-
         // light
-        float pointLightLinear = 0.09;
-        float pointLightQuadratic = 0.032;
         lightShader.use();
         lightShader.setMat4("projection", projection);
         lightShader.setMat4("view", view);
 
-        set_light_bulb(lightModel, lightShader, pointLightPositions[0],
-                       glm::radians((float)(10.0 * sin(1.0 + 2*glfwGetTime()))),
-                       glm::vec3(0.0f, 2.0f, -3.0f));
-        set_light_bulb(lightModel, lightShader, pointLightPositions[1],
-                       glm::radians((float)(10.0 * sin(2*glfwGetTime()))),
-                       glm::vec3(0.0f, 2.0f, 0.0f));
-        set_light_bulb(lightModel, lightShader, pointLightPositions[2],
-                       glm::radians((float)(10.0 * sin(2.0 + 2*glfwGetTime()))),
-                       glm::vec3(0.0f, 2.0f, 3.0f));
-
         objectShader.use();
         objectShader.setMat4("projection", projection);
         objectShader.setMat4("view", view);
 
-        // point light 1
-        set_point_light(objectShader, pointLightPositions[0], 0, pointLightLinear, pointLightQuadratic);
-        // point light 2
-        set_point_light(objectShader, pointLightPositions[1], 1, pointLightLinear, pointLightQuadratic);
-        // point light 3
-        set_point_light(objectShader, pointLightPositions[2], 2, pointLightLinear, pointLightQuadratic);
-        // spotLight
-        set_spot_light(objectShader, camera);
-
-        // table
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, -5.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(1.4f, 1.4f, 1.4f));
-        objectShader.setMat4("model", model);
-        tableModel.Draw(objectShader);
-
-        // cake
-        draw_cake(cakeModel, objectShader, glm::vec3(1.5f,-2.15f, 3.0f));
-        draw_cake(cakeModel, objectShader, glm::vec3(-1.5f,-2.15f, 3.0f));
-        draw_cake(cakeModel, objectShader, glm::vec3(1.5f,-2.15f, 0.0f));
-        draw_cake(cakeModel, objectShader, glm::vec3(-1.5f,-2.15f, 0.0f));
-        draw_cake(cakeModel, objectShader, glm::vec3(1.5f,-2.15f, -3.0f));
-        draw_cake(cakeModel, objectShader, glm::vec3(-1.5f,-2.15f, -3.0f));
-
-        //floor
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, floorDiffTexture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, floorSpecTexture);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, -5.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(20.0f, 1.0f, 20.0f));
-        objectShader.setMat4("model", model);
-        glBindVertexArray(floorVAO);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        frameGraph.wait(jobs);
+        // printed here, output from the workers would interleave with this thread's
+        if (picking && pickedInstance == rg::Bvh::None) {
+            std::cout << "Picked nothing" << std::endl;
+        } else if (picking) {
+            const rg::SceneNode& node = sceneDescription.nodes[instanceNodes[pickedInstance]];
+            std::cout << "Picked " << (node.name.empty() ? sceneDescription.models[node.model].name : node.name)
+                      << " at " << pickedDistance << ", within reach of " << pickedLights << " point lights" << std::endl;
+        }
+        for (unsigned int i = 0; i < jobs.threads(); i++) {
+            occludedInstances += hiddenCounts[i];
+            smallInstances += smallCounts[i];
+            hiddenCounts[i] = smallCounts[i] = 0;
+        }
+        if (softwareCulling)
+            occluderRasterMilliseconds += softwareCuller.stats().rasterMilliseconds;
+
+        {
+            rg::GLTrace::Section lightUniforms("light uniforms");
+            // point lights
+            for (unsigned int i = 0; i < numPointLights; i++) {
+                static const rg::SceneLight blackLight = [] {
+                    rg::SceneLight light;
+                    light.ambient = light.diffuse = light.specular = glm::vec3(0.0f);
+                    return light;
+                }();
+                set_point_light(objectShader, i < pointLights.size() ? *pointLights[i] : blackLight,
+                                pointLightPositions[i], i);
+            }
+            // spotLight
+            set_spot_light(objectShader, camera, spotLight, spotLightPosition, spotLightDirection);
+        }
+
+        // sorted by shader, material and depth
+        {
+            rg::GLTrace::Section flush("RenderQueue::flush");
+            renderQueue.flush();
+        }
+
+        // boxes of the rest against the depth so far, then the rest itself on their results
+        if (!queriedInstances.empty()) {
+            rg::GLTrace::Section queries("occlusion queries");
+            renderQueue.begin(camera.Position, camera.Front, 100.0f);
+            occlusionCuller.beginQueries(occlusionShader, projection * view);
+            for (rg::Bvh::ItemId instance : queriedInstances) {
+                rg::SceneGraph::NodeId node = instanceNodes[instance];
+                int32_t model = sceneDescription.nodes[node].model;
+                unsigned int shaderId = sceneDescription.models[model].shader == rg::SceneShader::Light ? lightShaderId : objectShaderId;
+                renderQueue.setCondition(occlusionCuller.query(instance, bvh.bounds(instance)));
+                if (scenePlanes[model])
+                    renderQueue.submit(shaderId, *scenePlanes[model], scene.world(node), scene.normalMatrix(node));
+                else
+                    renderQueue.submit(shaderId, sceneModels[model].get(), scene.world(node), scene.normalMatrix(node));
+            }
+            occlusionCuller.endQueries();
+            renderQueue.flush();
+        }
+        occlusionQueries += occlusionCuller.stats().queries;
+        occludedInstances += occlusionCuller.stats().occluded;
 
         // 2. now render quad with scene's visuals as its texture image
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -258,80 +652,104 @@ int main()
         glDisable(GL_DEPTH_TEST);
 
         // draw Screen quad
+        Shader& screenShader = screenShaders.get(screenShaderDefines(effect));
         screenShader.use();
-        screenShader.setInt("effect", effect);
+        screenShader.setInt("screenTexture", 0);
         glBindVertexArray(quadVAO);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultiSampled); // use multisampled texture
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glEnable(GL_DEPTH_TEST);
 
+        renderMilliseconds += rg::ProgramCache::millisecondsSince(renderStart);
+        renderedFrames++;
+
         glfwSwapBuffers(window);
         glfwPollEvents();
+        rg::GLTrace::instance().endFrame();
     }
 
-    glDeleteVertexArrays(1, &floorVAO);
-    glDeleteBuffers(1, &floorVBO);
-    glDeleteBuffers(1, &floorEBO);
-
+    streamer.shutdown();
+    for (rg::ModelHandle& model : sceneModels)
+        if (model.ready())
+            model.get().Release();
+    for (size_t i = 0; i < diffuseTextures.size(); i++) {
+        if (diffuseTextures[i].ready())
+            rg::TextureRegistry::instance().release(diffuseTextures[i].id());
+        if (specularTextures[i].ready())
+            rg::TextureRegistry::instance().release(specularTextures[i].id());
+    }
+    renderQueue.shutdown();
+    occlusionCuller.release();
+    uploadQueue.release();
+    rg::GLDebug::instance().printStats();
+    rg::GLTrace::instance().printSummary();
+    if (renderedFrames > 0)
+        std::cout << "Rendered " << renderedFrames << " frames, " << renderMilliseconds / renderedFrames
+                  << " ms of CPU time per frame, " << visibleInstances / renderedFrames << " of "
+                  << instanceNodes.size() << " instances in view, " << occlusionQueries / renderedFrames
+                  << " occlusion queries, " << occludedInstances / renderedFrames << " occluded and "
+                  << smallInstances / renderedFrames << " too small instances skipped" << std::endl;
+    if (renderedFrames > 0) {
+        frameGraph.printStats();
+        rg::JobSystem::Stats jobStats = jobs.stats();
+        std::cout << "Job system: " << jobStats.jobs / renderedFrames << " jobs per frame, "
+                  << jobStats.steals / renderedFrames << " of them stolen" << std::endl;
+    }
+    if (renderedFrames > 0 && cpuOcclusion)
+        std::cout << "Occluders rasterized in " << occluderRasterMilliseconds / renderedFrames
+                  << " ms per frame on the worker thread" << std::endl;
     glfwTerminate();
     return 0;
 }
 
-void set_light_bulb(Model& lightModel, Shader& lightShader, glm::vec3& pointLightPositions, float angle,
-                    const glm::vec3& translation_vec) {
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, translation_vec);
-    model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
-    model = glm::translate(model, glm::vec3(0.0f, 1.32f, 0.0f));
-    model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::translate(model, glm::vec3(0.0f, -1.32f, 0.0f));
-    pointLightPositions = glm::vec3(model * glm::vec4(0.0f, 0.2f, 0.0f, 1.0f));
-    lightShader.setMat4("model", model);
-    lightModel.Draw(lightShader);
-}
-
-void draw_cake(Model& cakeModel, Shader& objectShader, const glm::vec3& translation_vec) {
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, translation_vec);
-    model = glm::rotate(model, -0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-    objectShader.setMat4("model", model);
-    cakeModel.Draw(objectShader);
-}
-
-void set_spot_light(Shader& objectShader, Camera& camera) {
-    objectShader.setVec3("spotLight.position", camera.Position);
-    objectShader.setVec3("spotLight.direction", camera.Front);
+void set_spot_light(Shader& objectShader, Camera& camera, const rg::SceneLight* spotLight, const glm::vec3& position,
+                    const glm::vec3& direction) {
+    // with the spot light off the shader variant has no spot light at all, a scene without
+    // one leaves it black
     if(isSpotlightActivated){
-        objectShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        objectShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        objectShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
-    }
-    else{ // All to 0.
-        objectShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        objectShader.setVec3("spotLight.diffuse", 0.0f, 0.0f, 0.0f);
-        objectShader.setVec3("spotLight.specular", 0.0f, 0.0f, 0.0f);
+        glm::vec3 color = spotLight ? glm::vec3(1.0f) : glm::vec3(0.0f);
+        rg::SceneLight light = spotLight ? *spotLight : rg::SceneLight();
+        objectShader.setVec3("spotLight.position", position);
+        objectShader.setVec3("spotLight.direction", direction);
+        objectShader.setVec3("spotLight.ambient", light.ambient * color);
+        objectShader.setVec3("spotLight.diffuse", light.diffuse * color);
+        objectShader.setVec3("spotLight.specular", light.specular * color);
+        objectShader.setFloat("spotLight.constant", light.constant);
+        objectShader.setFloat("spotLight.linear", light.linear);
+        objectShader.setFloat("spotLight.quadratic", light.quadratic);
+        objectShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(light.cutOffDegrees)));
+        objectShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(light.outerCutOffDegrees)));
     }
-    objectShader.setFloat("spotLight.constant", 1.0f);
-    objectShader.setFloat("spotLight.linear", 0.01);
-    objectShader.setFloat("spotLight.quadratic", 0.001);
-    objectShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(2.5f)));
-    objectShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(22.0f)));
 
     objectShader.setVec3("viewPos", camera.Position);
     objectShader.setFloat("material.shininess", 128.0f);
 }
 
-void set_point_light(Shader& objectShader, glm::vec3& point_light_position, int i, float point_light_linear,
-                     float point_light_quadratic) {
-    objectShader.setVec3("pointLights[" + to_string(i) + "].position", point_light_position);
-    objectShader.setVec3("pointLights[" + to_string(i) + "].ambient", 0.05f, 0.05f, 0.05f);
-    objectShader.setVec3("pointLights[" + to_string(i) + "].diffuse", 0.8f, 0.8f, 0.8f);
-    objectShader.setVec3("pointLights[" + to_string(i) + "].specular", 1.0f, 1.0f, 1.0f);
-    objectShader.setFloat("pointLights[" + to_string(i) + "].constant", 1.0f);
-    objectShader.setFloat("pointLights[" + to_string(i) + "].linear", point_light_linear);
-    objectShader.setFloat("pointLights[" + to_string(i) + "].quadratic", point_light_quadratic);
+rg::ShaderDefines objectShaderDefines(bool spotlight) {
+    // meshes bind their maps as texture_diffuseN/texture_specularN, so both material samplers
+    // stay on unit 0 and read the same texture; SPECULAR_MAP stays off and reuses that sample
+    rg::ShaderDefines defines;
+    defines.set("NR_POINT_LIGHTS", numPointLights);
+    defines.enable("SPOT_LIGHT", spotlight);
+    return defines;
+}
+
+rg::ShaderDefines screenShaderDefines(bool grayscale) {
+    rg::ShaderDefines defines;
+    defines.set("MSAA_SAMPLES", MSAA_SAMPLES);
+    defines.enable("GRAYSCALE", grayscale);
+    return defines;
+}
+
+void set_point_light(Shader& objectShader, const rg::SceneLight& light, const glm::vec3& position, int i) {
+    objectShader.setVec3("pointLights[" + to_string(i) + "].position", position);
+    objectShader.setVec3("pointLights[" + to_string(i) + "].ambient", light.ambient);
+    objectShader.setVec3("pointLights[" + to_string(i) + "].diffuse", light.diffuse);
+    objectShader.setVec3("pointLights[" + to_string(i) + "].specular", light.specular);
+    objectShader.setFloat("pointLights[" + to_string(i) + "].constant", light.constant);
+    objectShader.setFloat("pointLights[" + to_string(i) + "].linear", light.linear);
+    objectShader.setFloat("pointLights[" + to_string(i) + "].quadratic", light.quadratic);
 }
 
 void processInput(GLFWwindow *window) {
@@ -372,6 +790,26 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
 
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+        pickRequested = true;
+    }
+}
+
+rg::Aabb localBounds(const Model& model) {
+    rg::Aabb bounds;
+    for (const Mesh& mesh : model.meshes)
+        bounds.expand(localBounds(mesh));
+    return bounds;
+}
+
+rg::Aabb localBounds(const Mesh& mesh) {
+    rg::Aabb bounds;
+    for (const Vertex& vertex : mesh.vertices)
+        bounds.expand(vertex.Position);
+    return bounds;
+}
+
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod) {
     if (key == GLFW_KEY_L && action == GLFW_PRESS) {
         isSpotlightActivated = !isSpotlightActivated;
@@ -381,4 +819,8 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         effect = !effect;
     }
 
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        occlusionCulling = !occlusionCulling;
+    }
+
 }
\ No newline at end of file
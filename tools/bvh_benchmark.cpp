@@ -0,0 +1,188 @@
+// Times rg::Bvh against testing every instance, at 1k, 10k and 100k instances (or the counts
+// given on the command line).
+//
+// The instances are boxes of the size of a cake slice scattered over a square floor, spaced like
+// the grid scene_compiler --generate writes. The queries are the ones the renderer makes: frustum
+// culling from cameras walking over the floor, picking rays from those cameras, the instances
+// within reach of point lights, and a refit after 1% of the instances moved. Every query's result
+// is checked against the brute force one. cost is rg::Bvh::cost() after the build and after the
+// refit, vis % the share of instances a camera sees.
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <rg/Bvh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Camera {
+    glm::vec3 position;
+    glm::vec3 front;
+    rg::Frustum frustum;
+};
+
+bool check(bool condition, const char* query, unsigned int count) {
+    if (!condition) {
+        std::printf("%u instances: %s result differs from the brute force one\n", count, query);
+    }
+    return condition;
+}
+
+bool run(unsigned int count) {
+    std::mt19937 random(count);
+    float extent = std::sqrt((float)count) * 1.5f * 0.5f;
+    std::uniform_real_distribution<float> onFloor(-extent, extent);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const glm::vec3 halfSize(0.25f, 0.2f, 0.25f);
+
+    std::vector<rg::Aabb> bounds(count);
+    for (rg::Aabb& box : bounds) {
+        glm::vec3 center(onFloor(random), -5.0f + halfSize.y + unit(random) * 0.5f, onFloor(random));
+        box = rg::Aabb(center - halfSize, center + halfSize);
+    }
+
+    std::vector<Camera> cameras(64);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    for (Camera& camera : cameras) {
+        camera.position = glm::vec3(onFloor(random), -3.0f, onFloor(random));
+        float yaw = unit(random) * 6.2831853f;
+        camera.front = glm::normalize(glm::vec3(std::cos(yaw), -0.3f, std::sin(yaw)));
+        glm::mat4 view = glm::lookAt(camera.position, camera.position + camera.front, glm::vec3(0.0f, 1.0f, 0.0f));
+        camera.frustum = rg::Frustum::fromMatrix(projection * view);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    rg::Bvh bvh;
+    bvh.build(bounds);
+    double buildMs = millisecondsSince(start);
+    bool ok = true;
+
+    // frustum culling
+    size_t visible = 0;
+    size_t bruteVisible = 0;
+    start = std::chrono::steady_clock::now();
+    for (const Camera& camera : cameras) {
+        bvh.cull(camera.frustum, [&](rg::Bvh::ItemId) { visible++; });
+    }
+    double cullMs = millisecondsSince(start) / cameras.size();
+    start = std::chrono::steady_clock::now();
+    for (const Camera& camera : cameras) {
+        for (const rg::Aabb& box : bounds) {
+            bruteVisible += camera.frustum.test(box) != rg::Frustum::Outside;
+        }
+    }
+    double bruteCullMs = millisecondsSince(start) / cameras.size();
+    ok &= check(visible == bruteVisible, "culling", count);
+    double visiblePercent = (double)visible / cameras.size() / count * 100.0;
+
+    // picking, each camera shoots rays into its half of the floor
+    std::vector<glm::vec3> directions;
+    for (const Camera& camera : cameras) {
+        for (int i = 0; i < 16; ++i) {
+            glm::vec3 jitter(unit(random) - 0.5f, unit(random) * 0.3f - 0.15f, unit(random) - 0.5f);
+            directions.push_back(glm::normalize(camera.front + jitter * 0.5f));
+        }
+    }
+    std::vector<rg::Bvh::ItemId> picked;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < directions.size(); ++i) {
+        float distance;
+        picked.push_back(bvh.raycast(cameras[i / 16].position, directions[i], 100.0f, distance));
+    }
+    double pickMs = millisecondsSince(start) / directions.size();
+    size_t pickMismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < directions.size(); ++i) {
+        glm::vec3 inverseDirection = glm::vec3(1.0f) / directions[i];
+        float nearest = 100.0f;
+        rg::Bvh::ItemId hit = rg::Bvh::None;
+        for (rg::Bvh::ItemId item = 0; item < count; ++item) {
+            float distance = bounds[item].intersect(cameras[i / 16].position, inverseDirection, nearest);
+            if (distance >= 0.0f && distance < nearest) {
+                nearest = distance;
+                hit = item;
+            }
+        }
+        pickMismatches += hit != picked[i];
+    }
+    double brutePickMs = millisecondsSince(start) / directions.size();
+    ok &= check(pickMismatches == 0, "picking", count);
+
+    // point lights with a short reach, a few dozen instances each
+    std::vector<glm::vec3> lights(256);
+    for (glm::vec3& light : lights) {
+        light = glm::vec3(onFloor(random), 2.0f, onFloor(random));
+    }
+    const float range = 7.0f;
+    size_t lit = 0;
+    size_t bruteLit = 0;
+    start = std::chrono::steady_clock::now();
+    for (const glm::vec3& light : lights) {
+        bvh.overlapSphere(light, range, [&](rg::Bvh::ItemId) { lit++; });
+    }
+    double lightMs = millisecondsSince(start) / lights.size();
+    start = std::chrono::steady_clock::now();
+    for (const glm::vec3& light : lights) {
+        for (const rg::Aabb& box : bounds) {
+            bruteLit += box.overlapsSphere(light, range);
+        }
+    }
+    double bruteLightMs = millisecondsSince(start) / lights.size();
+    ok &= check(lit == bruteLit, "light overlap", count);
+
+    // 1% of the instances move a little, the tree is refit and has to agree with the new bounds
+    float cost = bvh.cost();
+    std::vector<rg::Bvh::ItemId> moved;
+    for (unsigned int i = 0; i < std::max(count / 100, 1u); ++i) {
+        moved.push_back(random() % count);
+    }
+    for (rg::Bvh::ItemId item : moved) {
+        glm::vec3 offset(unit(random) - 0.5f, 0.0f, unit(random) - 0.5f);
+        bounds[item] = rg::Aabb(bounds[item].min + offset, bounds[item].max + offset);
+    }
+    start = std::chrono::steady_clock::now();
+    for (rg::Bvh::ItemId item : moved) {
+        bvh.update(item, bounds[item]);
+    }
+    bvh.refit();
+    double refitMs = millisecondsSince(start);
+    visible = 0;
+    bruteVisible = 0;
+    bvh.cull(cameras[0].frustum, [&](rg::Bvh::ItemId) { visible++; });
+    for (const rg::Aabb& box : bounds) {
+        bruteVisible += cameras[0].frustum.test(box) != rg::Frustum::Outside;
+    }
+    ok &= check(visible == bruteVisible, "culling after the refit", count);
+
+    std::printf("%9u | %8.2f %6.1f %8.1f | %8.4f %8.4f | %8.4f %8.4f | %8.4f %8.4f | %8.4f %6.2f\n", count,
+                buildMs, cost, bvh.cost(), cullMs, bruteCullMs, pickMs, brutePickMs, lightMs, bruteLightMs,
+                refitMs, visiblePercent);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::vector<unsigned int> counts;
+    for (int i = 1; i < argc; ++i) {
+        counts.push_back((unsigned int)std::max(std::atoi(argv[i]), 1));
+    }
+    if (counts.empty()) {
+        counts = {1000, 10000, 100000};
+    }
+
+    std::printf("%9s | %8s %6s %8s | %8s %8s | %8s %8s | %8s %8s | %8s %6s\n", "instances", "build ms", "cost",
+                "refitted", "cull ms", "linear", "pick ms", "linear", "light ms", "linear", "refit ms", "vis %");
+    bool ok = true;
+    for (unsigned int count : counts) {
+        ok &= run(count);
+    }
+    return ok ? 0 : 1;
+}
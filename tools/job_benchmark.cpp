@@ -0,0 +1,238 @@
+// Frame times of the renderer's CPU passes on rg::JobSystem with 1 to N threads, on a scene from
+// scene_compiler --generate.
+//
+//   job_benchmark <scene> [max threads] [frames]
+//
+// It runs the frame graph of main.cpp minus what needs a GL context: the models aren't loaded,
+// so every model is a unit cube for its bounds, and the draw list is recorded as the sort key and
+// matrices RenderQueue::record() stores, without meshes. A tenth of the instances turn every frame
+// so the transform and refit passes have work, and the camera walks across the floor. Every
+// thread count has to draw the same instances as one thread; draws is their count per frame.
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <rg/Bvh.h>
+#include <rg/FrameGraph.h>
+#include <rg/JobSystem.h>
+#include <rg/SceneFile.h>
+#include <rg/SceneGraph.h>
+#include <rg/SoftwareOcclusionCuller.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct Draw {
+    uint64_t key;
+    glm::mat4 model;
+    glm::mat4 normalMatrix;
+};
+
+struct Result {
+    double frameMilliseconds = 0.0;
+    std::vector<double> passMilliseconds;
+    std::vector<std::string> passNames;
+    size_t draws = 0;
+    rg::JobSystem::Stats jobs;
+};
+
+Result run(const rg::SceneDescription& description, unsigned int threads, unsigned int frames) {
+    rg::JobSystem jobs(threads);
+    rg::SceneGraph scene;
+    std::vector<rg::SceneGraph::NodeId> instanceNodes;
+    std::vector<rg::Bvh::ItemId> nodeInstances(description.nodes.size(), rg::Bvh::None);
+    for (const rg::SceneNode& node : description.nodes) {
+        rg::SceneGraph::NodeId id = scene.add(node.parent < 0 ? rg::SceneGraph::None : node.parent, node.local());
+        if (node.model >= 0) {
+            nodeInstances[id] = instanceNodes.size();
+            instanceNodes.push_back(id);
+        }
+    }
+    scene.update();
+    std::vector<rg::Aabb> modelBounds;
+    for (const rg::SceneModel& model : description.models) {
+        modelBounds.push_back(model.primitive == "plane" ? rg::Aabb(glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 0.0f, 1.0f))
+                                                         : rg::Aabb(glm::vec3(-1.0f), glm::vec3(1.0f)));
+    }
+    auto instanceBounds = [&](rg::Bvh::ItemId instance) {
+        rg::SceneGraph::NodeId node = instanceNodes[instance];
+        return modelBounds[description.nodes[node].model].transformed(scene.world(node));
+    };
+    rg::Bvh bvh;
+    std::vector<rg::Aabb> bounds(instanceNodes.size());
+    for (size_t i = 0; i < instanceNodes.size(); ++i) {
+        bounds[i] = instanceBounds(i);
+    }
+    bvh.build(bounds);
+
+    rg::SoftwareOcclusionCuller softwareCuller;
+    std::vector<rg::SoftwareOcclusionCuller::Occluder> occluders;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    glm::mat4 view(1.0f);
+    glm::vec3 cameraPosition(0.0f);
+    glm::vec3 cameraFront(0.0f, 0.0f, -1.0f);
+    unsigned int frame = 0;
+
+    std::vector<std::vector<rg::Bvh::ItemId>> culledLists(jobs.threads());
+    std::vector<std::vector<rg::Bvh::ItemId>> drawnLists(jobs.threads());
+    std::vector<std::vector<Draw>> drawLists(jobs.threads());
+    std::vector<uint32_t> bvhSubtrees;
+    std::vector<rg::Bvh::ItemId> inView;
+    std::vector<rg::Bvh::ItemId> drawnInstances;
+    std::vector<Draw> draws;
+    size_t drawCount = 0;
+    auto gather = [](std::vector<std::vector<rg::Bvh::ItemId>>& lists, std::vector<rg::Bvh::ItemId>& all) {
+        all.clear();
+        for (std::vector<rg::Bvh::ItemId>& list : lists) {
+            all.insert(all.end(), list.begin(), list.end());
+            list.clear();
+        }
+    };
+
+    rg::FrameGraph graph;
+    rg::FrameGraph::PassId transformsPass = graph.addPass("transforms", [&]() {
+        for (size_t i = frame % 10; i < instanceNodes.size(); i += 10) {
+            rg::SceneGraph::NodeId node = instanceNodes[i];
+            scene.setLocal(node, glm::rotate(scene.local(node), 0.05f, glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+        scene.update(&jobs);
+    });
+    rg::FrameGraph::PassId occludersPass = graph.addPass("occluders", [&]() {
+        occluders.clear();
+        for (const rg::SceneOccluder& occluder : description.occluders) {
+            occluders.push_back({scene.world(occluder.node), rg::Aabb(occluder.min, occluder.max)});
+        }
+        softwareCuller.begin(projection * view, occluders);
+    }, {transformsPass});
+    rg::FrameGraph::PassId boundsPass = graph.addPass("bounds", [&]() {
+        for (rg::SceneGraph::NodeId node : scene.updatedNodes()) {
+            if (nodeInstances[node] != rg::Bvh::None) {
+                bvh.update(nodeInstances[node], instanceBounds(nodeInstances[node]));
+            }
+        }
+        bvh.refit();
+    }, {transformsPass});
+    rg::FrameGraph::PassId cullPass = graph.addPass("cull", [&]() {
+        rg::Frustum frustum = rg::Frustum::fromMatrix(projection * view);
+        bvh.subtrees(jobs.threads() * 4, bvhSubtrees);
+        jobs.parallelFor(bvhSubtrees.size(), 1, [&](size_t begin, size_t end) {
+            std::vector<rg::Bvh::ItemId>& culled = culledLists[jobs.threadIndex()];
+            rg::Bvh::Stats stats;
+            for (size_t i = begin; i < end; ++i) {
+                bvh.cull(frustum, [&](rg::Bvh::ItemId instance) { culled.push_back(instance); }, bvhSubtrees[i], stats);
+            }
+        });
+    }, {boundsPass});
+    rg::FrameGraph::PassId selectPass = graph.addPass("select", [&]() {
+        gather(culledLists, inView);
+        softwareCuller.wait();
+        float pixelsPerRadian = 600.0f / (2.0f * std::tan(glm::radians(45.0f) * 0.5f));
+        jobs.parallelFor(inView.size(), 256, [&](size_t begin, size_t end) {
+            std::vector<rg::Bvh::ItemId>& drawn = drawnLists[jobs.threadIndex()];
+            for (size_t i = begin; i < end; ++i) {
+                const rg::Aabb& box = bvh.bounds(inView[i]);
+                if (softwareCuller.occluded(box)) {
+                    continue;
+                }
+                float diameter = glm::length(box.max - box.min);
+                float distance = glm::length(box.center() - cameraPosition);
+                if (distance > diameter && diameter / distance * pixelsPerRadian < 1.0f) {
+                    continue;
+                }
+                drawn.push_back(inView[i]);
+            }
+        });
+    }, {cullPass, occludersPass});
+    rg::FrameGraph::PassId recordPass = graph.addPass("record", [&]() {
+        gather(drawnLists, drawnInstances);
+        jobs.parallelFor(drawnInstances.size(), 256, [&](size_t begin, size_t end) {
+            std::vector<Draw>& list = drawLists[jobs.threadIndex()];
+            for (size_t i = begin; i < end; ++i) {
+                rg::SceneGraph::NodeId node = instanceNodes[drawnInstances[i]];
+                const glm::mat4& world = scene.world(node);
+                float depth = glm::clamp(glm::dot(glm::vec3(world[3]) - cameraPosition, cameraFront) / 100.0f, 0.0f, 1.0f);
+                uint64_t key = (uint64_t)description.nodes[node].model << 38 | (uint64_t)(depth * 16777215.0f);
+                list.push_back(Draw{key, world, scene.normalMatrix(node)});
+            }
+        });
+    }, {selectPass});
+    graph.addPass("merge", [&]() {
+        draws.clear();
+        for (std::vector<Draw>& list : drawLists) {
+            draws.insert(draws.end(), list.begin(), list.end());
+            list.clear();
+        }
+        drawCount += draws.size();
+    }, {recordPass});
+
+    // the camera walks along a circle over the floor, looking inwards and a little down
+    float radius = 0.0f;
+    for (const rg::Aabb& box : bounds) {
+        radius = std::max(radius, std::max(std::fabs(box.center().x), std::fabs(box.center().z)));
+    }
+    radius *= 0.8f;
+    auto start = std::chrono::steady_clock::now();
+    for (frame = 0; frame < frames; ++frame) {
+        float angle = frame * 6.2831853f / frames;
+        cameraPosition = glm::vec3(std::cos(angle) * radius, -3.0f, std::sin(angle) * radius);
+        cameraFront = glm::normalize(glm::vec3(-std::cos(angle), -0.25f, -std::sin(angle)));
+        view = glm::lookAt(cameraPosition, cameraPosition + cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
+        graph.execute(jobs);
+    }
+    Result result;
+    result.frameMilliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    for (rg::FrameGraph::PassId id = 0; id < graph.size(); ++id) {
+        result.passNames.push_back(graph.name(id));
+        result.passMilliseconds.push_back(graph.milliseconds(id));
+    }
+    result.draws = drawCount / frames;
+    result.jobs = jobs.stats();
+    return result;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 4) {
+        std::fprintf(stderr, "usage: %s <scene> [max threads] [frames]\n", argv[0]);
+        return 1;
+    }
+    rg::SceneDescription description;
+    std::string error;
+    if (!rg::SceneFile::load(argv[1], description, error)) {
+        std::fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+        return 1;
+    }
+    unsigned int maxThreads = argc > 2 ? (unsigned int)std::max(std::atoi(argv[2]), 1) : rg::hardwareThreads();
+    unsigned int frames = argc > 3 ? (unsigned int)std::max(std::atoi(argv[3]), 1) : 100;
+    std::printf("%s: %zu nodes, %u frames, %u hardware threads\n", argv[1], description.nodes.size(), frames,
+                rg::hardwareThreads());
+
+    Result single;
+    bool ok = true;
+    for (unsigned int threads = 1; threads <= maxThreads; ++threads) {
+        Result result = run(description, threads, frames);
+        if (threads == 1) {
+            single = result;
+            std::printf("%7s | %8s %7s | %7s %7s |", "threads", "frame ms", "speedup", "draws", "steals");
+            for (const std::string& name : result.passNames) {
+                std::printf(" %10s", name.c_str());
+            }
+            std::printf("\n");
+        }
+        std::printf("%7u | %8.3f %6.2fx | %7zu %7u |", threads, result.frameMilliseconds,
+                    single.frameMilliseconds / result.frameMilliseconds, result.draws, result.jobs.steals / frames);
+        for (double milliseconds : result.passMilliseconds) {
+            std::printf(" %10.3f", milliseconds);
+        }
+        std::printf("\n");
+        if (result.draws != single.draws) {
+            std::printf("%u threads draw %zu instances per frame, one thread %zu\n", threads, result.draws, single.draws);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
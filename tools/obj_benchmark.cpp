@@ -0,0 +1,95 @@
+// Times rg::ObjLoader against Assimp on the bundled OBJ models.
+//
+// Both produce triangulated meshes with smooth normals, flipped UVs and tangents; Assimp's
+// number covers ReadFile only, the conversion into Mesh vertices Model::processMesh does on
+// top of it is not included.
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <learnopengl/filesystem.h>
+#include <rg/ObjLoader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Timing {
+    double best = 1e30;
+    double total = 0.0;
+    size_t vertices = 0;
+    size_t indices = 0;
+    size_t meshes = 0;
+};
+
+template<typename Function>
+Timing measure(int iterations, Function function) {
+    Timing timing;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function(timing);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        timing.best = std::min(timing.best, ms);
+        timing.total += ms;
+    }
+    return timing;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 10;
+    const char* models[] = {
+            "resources/objects/cookie/cookie.obj",
+            "resources/objects/dining_table/dining_table.obj",
+            "resources/objects/light/light.obj",
+            "resources/objects/slice_of_cake/cake.obj",
+    };
+
+    std::printf("%-18s %8s | %10s %10s %8s %8s | %10s %10s %8s %8s | %7s\n", "model", "size KB",
+                "obj best", "obj avg", "verts", "meshes", "assimp best", "assimp avg", "verts", "meshes", "speedup");
+    for (const char* model : models) {
+        std::string path = FileSystem::getPath(model);
+        rg::FileView file(path);
+        size_t size = file.size();
+        file.close();
+
+        Timing obj = measure(iterations, [&](Timing& timing) {
+            rg::ObjScene scene;
+            if (!rg::ObjLoader::load(path, scene)) {
+                return;
+            }
+            timing.meshes = scene.meshes.size();
+            timing.vertices = 0;
+            timing.indices = 0;
+            for (const rg::ObjMesh& mesh : scene.meshes) {
+                timing.vertices += mesh.vertices.size();
+                timing.indices += mesh.indices.size();
+            }
+        });
+
+        Timing assimp = measure(iterations, [&](Timing& timing) {
+            Assimp::Importer importer;
+            const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals |
+                                                           aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+            if (!scene) {
+                return;
+            }
+            timing.meshes = scene->mNumMeshes;
+            timing.vertices = 0;
+            timing.indices = 0;
+            for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
+                timing.vertices += scene->mMeshes[i]->mNumVertices;
+                timing.indices += scene->mMeshes[i]->mNumFaces * 3;
+            }
+        });
+
+        const char* name = std::strrchr(model, '/') + 1;
+        std::printf("%-18s %8zu | %8.2fms %8.2fms %8zu %8zu | %9.2fms %8.2fms %8zu %8zu | %6.1fx\n", name, size / 1024,
+                    obj.best, obj.total / iterations, obj.vertices, obj.meshes,
+                    assimp.best, assimp.total / iterations, assimp.vertices, assimp.meshes, assimp.best / obj.best);
+    }
+    return 0;
+}
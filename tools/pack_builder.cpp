@@ -0,0 +1,146 @@
+// Builds the pack file the Vfs mounts at startup from everything under resources/.
+//
+//   pack_builder [output]        default: <project root>/resources.pack
+//
+// Entries are sorted by name for the binary searched table of contents and aligned to 64
+// bytes. Each file is LZ compressed if that saves at least an eighth of its size, which in
+// practice means text (OBJ, MTL, shaders) while JPEG/PNG images stay stored as they are.
+#include <learnopengl/filesystem.h>
+#include <rg/Lz.h>
+#include <rg/FileView.h>
+#include <rg/PackFile.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+const uint32_t Alignment = 64;
+
+struct Input {
+    std::string name; // relative to the project root, as the Vfs looks it up
+    std::string path;
+};
+
+void collect(const std::string& root, const std::string& name, std::vector<Input>& inputs) {
+    std::string path = root + name;
+    DIR* directory = opendir(path.c_str());
+    if (!directory) {
+        return;
+    }
+    while (dirent* item = readdir(directory)) {
+        std::string child = item->d_name;
+        if (child == "." || child == "..") {
+            continue;
+        }
+        struct stat info;
+        std::string childName = name + "/" + child;
+        if (stat((root + childName).c_str(), &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            collect(root, childName, inputs);
+        } else if (S_ISREG(info.st_mode)) {
+            inputs.push_back(Input{childName, root + childName});
+        }
+    }
+    closedir(directory);
+}
+
+void pad(std::ofstream& out, uint64_t& offset, uint32_t alignment) {
+    static const char zeros[64] = {};
+    uint64_t padding = (alignment - offset % alignment) % alignment;
+    out.write(zeros, padding);
+    offset += padding;
+}
+
+int main(int argc, char** argv) {
+    std::string root = FileSystem::getPath("");
+    std::string output = argc > 1 ? argv[1] : FileSystem::getPath("resources.pack");
+
+    std::vector<Input> inputs;
+    collect(root, "resources", inputs);
+    if (inputs.empty()) {
+        std::cerr << "No files found under " << root << "resources" << std::endl;
+        return 1;
+    }
+    std::sort(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) {
+        return a.name < b.name;
+    });
+
+    std::string temporary = output + ".tmp";
+    std::ofstream out(temporary, std::ios::binary);
+    if (!out) {
+        std::cerr << "Could not write " << temporary << std::endl;
+        return 1;
+    }
+
+    rg::PackHeader header = {};
+    std::memcpy(header.magic, "RGPK", 4);
+    header.version = rg::PACK_VERSION;
+    header.entryCount = (uint32_t)inputs.size();
+    header.alignment = Alignment;
+    out.write((const char*)&header, sizeof(header));
+    uint64_t offset = sizeof(header);
+
+    std::vector<rg::PackEntry> entries;
+    std::string names;
+    uint64_t totalSize = 0;
+    uint64_t totalStored = 0;
+    unsigned int compressedCount = 0;
+    for (const Input& input : inputs) {
+        rg::FileView file(input.path);
+        if (!file.isOpen()) {
+            std::cerr << "Could not read " << input.path << std::endl;
+            return 1;
+        }
+        rg::PackEntry entry = {};
+        entry.nameOffset = (uint32_t)names.size();
+        entry.nameLength = (uint32_t)input.name.size();
+        entry.size = file.size();
+        names += input.name;
+
+        std::vector<unsigned char> compressed(rg::lz::compressBound(file.size()));
+        size_t compressedSize = file.size() ? rg::lz::compress(file.data(), file.size(), compressed.data()) : 0;
+        const unsigned char* data = file.data();
+        entry.storedSize = file.size();
+        if (file.size() > 0 && compressedSize < file.size() - file.size() / 8) {
+            entry.flags |= rg::PACK_ENTRY_LZ;
+            entry.storedSize = compressedSize;
+            data = compressed.data();
+            ++compressedCount;
+        }
+
+        pad(out, offset, Alignment);
+        entry.offset = offset;
+        out.write((const char*)data, entry.storedSize);
+        offset += entry.storedSize;
+        entries.push_back(entry);
+        totalSize += entry.size;
+        totalStored += entry.storedSize;
+    }
+
+    pad(out, offset, 8);
+    header.tocOffset = offset;
+    out.write((const char*)entries.data(), entries.size() * sizeof(rg::PackEntry));
+    offset += entries.size() * sizeof(rg::PackEntry);
+    header.namesOffset = offset;
+    out.write(names.data(), names.size());
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    out.close();
+    if (!out || std::rename(temporary.c_str(), output.c_str()) != 0) {
+        std::cerr << "Could not write " << output << std::endl;
+        std::remove(temporary.c_str());
+        return 1;
+    }
+
+    std::cout << "Packed " << entries.size() << " files (" << compressedCount << " compressed), "
+              << totalSize / 1024 << " KB -> " << totalStored / 1024 << " KB into " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Compiles JSON scenes to the binary form rg::SceneFile loads without parsing, and generates
+// large benchmark scenes.
+//
+//   scene_compiler <scene.json> <output.scene>
+//   scene_compiler --generate <count> <scene.json>
+//
+// The generated scene is the dining room floor with count cakes on a grid and the three lamps
+// above its middle. Run the program with RG_SCENE=<scene> to render either form.
+#include <rg/SceneFile.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int compile(const std::string& input, const std::string& output) {
+    auto start = std::chrono::steady_clock::now();
+    rg::SceneDescription scene;
+    std::string error;
+    if (!rg::SceneFile::load(input, scene, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    double parseMilliseconds = millisecondsSince(start);
+    if (!rg::SceneFile::writeBinary(scene, output)) {
+        std::cerr << "can't write " << output << std::endl;
+        return 1;
+    }
+
+    start = std::chrono::steady_clock::now();
+    rg::SceneDescription compiled;
+    if (!rg::SceneFile::load(output, compiled, error)) {
+        std::cerr << output << ": " << error << std::endl;
+        return 1;
+    }
+    std::cout << output << ": " << scene.nodes.size() << " nodes, " << scene.models.size() << " models, "
+              << scene.lights.size() << " lights; loads in " << millisecondsSince(start) << " ms, the JSON in "
+              << parseMilliseconds << " ms" << std::endl;
+    return 0;
+}
+
+int generate(unsigned int count, const std::string& output) {
+    std::ofstream out(output);
+    if (!out) {
+        std::cerr << "can't write " << output << std::endl;
+        return 1;
+    }
+    const float spacing = 1.5f;
+    unsigned int side = (unsigned int)std::ceil(std::sqrt((double)count));
+    float extent = side * spacing * 0.5f + 2.0f;
+
+    out << "{\n"
+           "    \"materials\": [\n"
+           "        { \"name\": \"floor\", \"diffuse\": \"resources/objects/floor/floor_diffuse.png\", "
+           "\"specular\": \"resources/objects/floor/floor_specular2.png\" }\n"
+           "    ],\n"
+           "    \"models\": [\n"
+           "        { \"name\": \"cake\", \"path\": \"resources/objects/slice_of_cake/cake.obj\" },\n"
+           "        { \"name\": \"lamp\", \"path\": \"resources/objects/light/light.obj\", \"shader\": \"light\" },\n"
+           "        { \"name\": \"floor\", \"primitive\": \"plane\", \"material\": \"floor\" }\n"
+           "    ],\n"
+           "    \"nodes\": [\n";
+    out << "        { \"name\": \"floor\", \"model\": \"floor\", \"position\": [0, -5, 0], \"scale\": [" << extent
+        << ", 1, " << extent << "],\n"
+           "          \"occluder\": { \"min\": [-1, 0, -1], \"max\": [1, 0, 1] } }";
+    // every node after the floor starts with the separator, so no count leaves a trailing comma
+    const unsigned int lamps = 3;
+    for (unsigned int lamp = 0; lamp < lamps; ++lamp) {
+        out << ",\n"
+               "        { \"name\": \"lamp " << lamp + 1 << "\", \"position\": [0, 7.28, " << (lamp * 3.0f - 3.0f)
+            << "], \"scale\": 4, \"children\": [\n"
+               "            { \"swing\": { \"axis\": [0, 0, 1], \"degrees\": 10, \"frequency\": 2, \"phase\": " << lamp
+            << " }, \"children\": [\n"
+               "                { \"model\": \"lamp\", \"position\": [0, -1.32, 0], \"children\": [\n"
+               "                    { \"position\": [0, 0.2, 0], \"light\": { \"type\": \"point\" } }\n"
+               "                ] }\n"
+               "            ] }\n"
+               "        ] }";
+    }
+    for (unsigned int i = 0; i < count; ++i) {
+        float x = (i % side) * spacing - (side - 1) * spacing * 0.5f;
+        float z = (i / side) * spacing - (side - 1) * spacing * 0.5f;
+        out << ",\n"
+               "        { \"model\": \"cake\", \"position\": [" << x << ", -5, " << z << "], \"rotation\": "
+            << "{ \"axis\": [0, 1, 0], \"degrees\": " << (i * 37) % 360 << " }, \"scale\": 0.1 }";
+    }
+    out << "\n"
+           "    ],\n"
+           "    \"lights\": [\n"
+           "        { \"type\": \"spot\", \"ambient\": 0, \"diffuse\": 1, \"specular\": 1, \"constant\": 1, "
+           "\"linear\": 0.01, \"quadratic\": 0.001, \"cutOff\": 2.5, \"outerCutOff\": 22 }\n"
+           "    ]\n"
+           "}\n";
+    out.close();
+    if (!out.good()) {
+        std::cerr << "can't write " << output << std::endl;
+        return 1;
+    }
+    std::cout << output << ": " << count << " cakes on a " << side << "x" << side << " grid" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4 && std::string(argv[1]) == "--generate") {
+        return generate((unsigned int)std::strtoul(argv[2], nullptr, 10), argv[3]);
+    }
+    if (argc == 3) {
+        return compile(argv[1], argv[2]);
+    }
+    std::cerr << "usage: " << argv[0] << " <scene.json> <output.scene>\n"
+              << "       " << argv[0] << " --generate <count> <scene.json>" << std::endl;
+    return 1;
+}